@@ -0,0 +1,19 @@
+# Autodetect if AVX2 intrinsics can be compiled. Whether they can also be
+# executed is decided at runtime.
+
+include(CheckCXXSourceCompiles)
+set(CMAKE_REQUIRED_FLAGS "")
+
+if (CMAKE_CXX_COMPILER_ID STREQUAL "GNU" OR CMAKE_CXX_COMPILER_ID STREQUAL "Clang" OR CMAKE_CXX_COMPILER_ID STREQUAL "AppleClang")
+    set(CMAKE_REQUIRED_FLAGS "-mavx2")
+endif (CMAKE_CXX_COMPILER_ID STREQUAL "GNU" OR CMAKE_CXX_COMPILER_ID STREQUAL "Clang" OR CMAKE_CXX_COMPILER_ID STREQUAL "AppleClang")
+
+check_cxx_source_compiles("
+    #include <immintrin.h>
+    int main() {
+        __m256i a = _mm256_setzero_si256();
+        a = _mm256_add_epi16(a, a);
+        return _mm256_movemask_epi8(a);
+    }"
+    AVX2_FOUND
+)
@@ -13,22 +13,31 @@
 #include "tile_cmd.h"
 #include "viewport_func.h"
 #include "framerate_type.h"
+#include <unordered_map>
 
 #include "safeguards.h"
 
-/** The table/list with animated tiles. */
+/**
+ * The table/list with animated tiles, in animation order.
+ * Removed tiles are replaced by INVALID_TILE, such that the order of the remaining tiles does not change,
+ * until the list is compacted during the next animation loop.
+ */
 std::vector<TileIndex> _animated_tiles;
 
+/** The index of each animated tile in #_animated_tiles. */
+static std::unordered_map<TileIndex, uint> _animated_tile_index;
+
 /**
  * Removes the given tile from the animated tile table.
  * @param tile the tile to remove
  */
 void DeleteAnimatedTile(TileIndex tile)
 {
-	auto to_remove = std::find(_animated_tiles.begin(), _animated_tiles.end(), tile);
-	if (to_remove != _animated_tiles.end()) {
+	auto to_remove = _animated_tile_index.find(tile);
+	if (to_remove != _animated_tile_index.end()) {
 		/* The order of the remaining elements must stay the same, otherwise the animation loop may miss a tile. */
-		_animated_tiles.erase(to_remove);
+		_animated_tiles[to_remove->second] = INVALID_TILE;
+		_animated_tile_index.erase(to_remove);
 		MarkTileDirtyByTile(tile, ZOOM_LVL_DRAW_MAP);
 	}
 }
@@ -41,7 +50,39 @@ void DeleteAnimatedTile(TileIndex tile)
 void AddAnimatedTile(TileIndex tile)
 {
 	MarkTileDirtyByTile(tile, ZOOM_LVL_DRAW_MAP);
-	include(_animated_tiles, tile);
+	if (_animated_tile_index.insert({ tile, (uint)_animated_tiles.size() }).second) {
+		_animated_tiles.push_back(tile);
+	}
+}
+
+/**
+ * Remove the deleted tiles from the animated tile table, keeping the order of the remaining tiles.
+ */
+void CompactAnimatedTiles()
+{
+	if (_animated_tiles.size() == _animated_tile_index.size()) return;
+
+	uint write = 0;
+	for (TileIndex tile : _animated_tiles) {
+		if (tile == INVALID_TILE) continue;
+		_animated_tile_index[tile] = write;
+		_animated_tiles[write++] = tile;
+	}
+	_animated_tiles.resize(write);
+}
+
+/**
+ * Rebuild the index of the animated tile table, after the table has been loaded.
+ * Duplicate entries are removed.
+ */
+void RebuildAnimatedTileIndex()
+{
+	_animated_tile_index.clear();
+	_animated_tile_index.reserve(_animated_tiles.size());
+	for (uint i = 0; i < _animated_tiles.size(); i++) {
+		if (!_animated_tile_index.insert({ _animated_tiles[i], i }).second) _animated_tiles[i] = INVALID_TILE;
+	}
+	CompactAnimatedTiles();
 }
 
 /**
@@ -56,9 +97,19 @@ void AnimateAnimatedTiles()
 
 	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
 
-	const TileIndex *ti = _animated_tiles.data();
-	while (ti < _animated_tiles.data() + _animated_tiles.size()) {
-		const TileIndex curr = *ti;
+	/* Compact the table while animating: tiles are moved down over the deleted tiles before they are animated.
+	 * Tiles added during the loop are appended, and are animated in this loop as well. */
+	uint write = 0;
+	for (uint read = 0; read < _animated_tiles.size(); read++) {
+		const TileIndex curr = _animated_tiles[read];
+		if (curr == INVALID_TILE) continue;
+
+		if (write != read) {
+			_animated_tiles[write] = curr;
+			_animated_tiles[read] = INVALID_TILE;
+			_animated_tile_index[curr] = write;
+		}
+
 		switch (GetTileType(curr)) {
 			case MP_HOUSE:
 				AnimateTile_Town(curr);
@@ -80,17 +131,12 @@ void AnimateAnimatedTiles()
 				NOT_REACHED();
 		}
 
-		/* During the AnimateTile call, DeleteAnimatedTile could have been called,
-		 * deleting an element we've already processed and pushing the rest one
-		 * slot to the left. We can detect this by checking whether the index
-		 * in the current slot has changed - if it has, an element has been deleted,
-		 * and we should process the current slot again instead of going forward.
-		 * NOTE: this will still break if more than one animated tile is being
-		 *       deleted during the same AnimateTile call, but no code seems to
-		 *       be doing this anyway.
-		 */
-		if (*ti == curr) ++ti;
+		/* The tile may have been deleted during the AnimateTile call, in which case its slot is reused. */
+		if (_animated_tiles[write] == curr) write++;
 	}
+
+	/* Deleted tiles which were already animated in this loop remain, they are removed in the next loop. */
+	_animated_tiles.resize(write);
 }
 
 /**
@@ -99,4 +145,5 @@ void AnimateAnimatedTiles()
 void InitializeAnimatedTiles()
 {
 	_animated_tiles.clear();
+	_animated_tile_index.clear();
 }
@@ -0,0 +1,318 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_anim_avx2.cpp Implementation of the AVX2 32 bpp blitter with animation support. */
+
+#ifdef WITH_SSE
+
+#include "../stdafx.h"
+#include "../video/video_driver.hpp"
+#include "../table/sprites.h"
+#include "32bpp_anim_avx2.hpp"
+#include "32bpp_avx2_func.hpp"
+
+#include "../safeguards.h"
+
+/** Instantiation of the AVX2 32bpp blitter factory. */
+static FBlitter_32bppAVX2_Anim iFBlitter_32bppAVX2_Anim;
+
+/**
+ * Draws a sprite to a (screen) buffer, eight pixels at a time.
+ * Blocks containing animated colours are drawn one pixel at a time.
+ *
+ * @tparam mode blitter mode, either BM_NORMAL or BM_TRANSPARENT
+ * @tparam read_mode how to skip the empty pixels of a line
+ * @tparam translucent whether the sprite has pixels that are neither fully transparent nor fully opaque
+ * @tparam animated whether the sprite has pixels using animated palette colours
+ * @param bp further blitting parameters
+ * @param zoom zoom level at which we are drawing
+ */
+IGNORE_UNINITIALIZED_WARNING_START
+template <BlitterMode mode, Blitter_32bppSSE_Base::ReadMode read_mode, bool translucent, bool animated>
+inline void Blitter_32bppAVX2_Anim::Draw(const Blitter::BlitterParams *bp, ZoomLevel zoom)
+{
+	assert_compile(mode == BM_NORMAL || mode == BM_TRANSPARENT);
+
+	Colour *dst_line = (Colour *) bp->dst + bp->top * bp->pitch + bp->left;
+	uint16 *anim_line = this->anim_buf + this->ScreenToAnimOffset((uint32 *)bp->dst) + bp->top * this->anim_buf_pitch + bp->left;
+	int effective_width = bp->width;
+
+	/* Find where to start reading in the source sprite. */
+	const Blitter_32bppSSE_Base::SpriteData * const sd = (const Blitter_32bppSSE_Base::SpriteData *) bp->sprite;
+	const SpriteInfo * const si = &sd->infos[zoom];
+	const MapValue *src_mv_line = (const MapValue *) &sd->data[si->mv_offset] + bp->skip_top * si->sprite_width;
+	const Colour *src_rgba_line = (const Colour *) ((const byte *) &sd->data[si->sprite_offset] + bp->skip_top * si->sprite_line_size);
+
+	if (read_mode != RM_WITH_MARGIN) {
+		src_rgba_line += bp->skip_left;
+		src_mv_line += bp->skip_left;
+	}
+	const MapValue *src_mv = src_mv_line;
+
+	/* Load these variables into register before loop. */
+	const __m128i a_cm        = ALPHA_CONTROL_MASK;
+	const __m128i pack_low_cm = PACK_LOW_CONTROL_MASK;
+	const __m128i tr_nom_base = TRANSPARENT_NOM_BASE;
+	const __m256i a_cm_256        = ALPHA_CONTROL_MASK_256;
+	const __m256i pack_low_256    = PACK_LOW_MASK_256;
+	const __m256i tr_nom_base_256 = TRANSPARENT_NOM_BASE_256;
+	const __m128i colour_mask     = _mm_set1_epi16(0xFF);
+	const __m128i anim_cmp        = _mm_set1_epi16(PALETTE_ANIM_START - 1);
+	const __m128i opaque_cmp      = _mm_set1_epi16(0xFF);
+
+	/* Draw a single pixel the way 32bpp_anim_sse4.cpp does for the last pixel of an odd line. */
+	auto draw_single = [&](const Colour *src, const MapValue *mv, Colour *dst, uint16 *anim) {
+		if (src->a == 0) {
+		} else if (src->a == 255) {
+			*anim = animated ? *(const uint16*) mv : 0;
+			*dst = (animated && mv->m >= PALETTE_ANIM_START) ? AdjustBrightneSSE(this->LookupColourInPalette(mv->m), mv->v) : *src;
+		} else {
+			*anim = 0;
+			__m128i srcABCD;
+			__m128i dstABCD = _mm_cvtsi32_si128(dst->data);
+			if (animated && mv->m >= PALETTE_ANIM_START) {
+				Colour colour = AdjustBrightneSSE(this->LookupColourInPalette(mv->m), mv->v);
+				colour.a = src->a;
+				srcABCD = _mm_cvtsi32_si128(colour.data);
+			} else {
+				srcABCD = _mm_cvtsi32_si128(src->data);
+			}
+			dst->data = _mm_cvtsi128_si32(AlphaBlendTwoPixels(srcABCD, dstABCD, a_cm, pack_low_cm));
+		}
+	};
+
+	for (int y = bp->height; y != 0; y--) {
+		Colour *dst = dst_line;
+		const Colour *src = src_rgba_line + META_LENGTH;
+		if (mode != BM_TRANSPARENT) src_mv = src_mv_line;
+		uint16 *anim = anim_line;
+
+		if (read_mode == RM_WITH_MARGIN) {
+			anim += src_rgba_line[0].data;
+			src += src_rgba_line[0].data;
+			dst += src_rgba_line[0].data;
+			if (mode != BM_TRANSPARENT) src_mv += src_rgba_line[0].data;
+			const int width_diff = si->sprite_width - bp->width;
+			effective_width = bp->width - (int) src_rgba_line[0].data;
+			const int delta_diff = (int) src_rgba_line[1].data - width_diff;
+			const int new_width = effective_width - delta_diff;
+			effective_width = delta_diff > 0 ? new_width : effective_width;
+			if (effective_width <= 0) goto next_line;
+		}
+
+		switch (mode) {
+			default: {
+				uint x = (uint) effective_width;
+				for (; x >= 8; x -= 8) {
+					__m256i srcABCD = _mm256_loadu_si256((const __m256i *) src);
+					__m256i dstABCD = _mm256_loadu_si256((const __m256i *) dst);
+					__m128i anim8 = _mm_loadu_si128((const __m128i *) anim);
+					const __m128i visible = NarrowPixelMask(VisiblePixelMask(srcABCD));
+
+					if (animated) {
+						const __m128i mv = _mm_loadu_si128((const __m128i *) src_mv);
+						if (unlikely(_mm_movemask_epi8(_mm_cmpgt_epi16(_mm_and_si128(mv, colour_mask), anim_cmp)) != 0)) {
+							/* Animated colours need a palette lookup and brightness adjustment per pixel. */
+							for (uint i = 0; i < 8; i++) draw_single(src + i, src_mv + i, dst + i, anim + i);
+							goto bmno_next_block;
+						}
+
+						/* Opaque pixels take the map value, other visible ones are no longer animated. */
+						const __m128i alpha = NarrowPixelMask(_mm256_srli_epi32(srcABCD, 24));
+						const __m128i opaque = _mm_cmpeq_epi16(alpha, opaque_cmp);
+						anim8 = _mm_andnot_si128(visible, anim8);
+						anim8 = _mm_blendv_epi8(anim8, mv, opaque);
+					} else {
+						anim8 = _mm_andnot_si128(visible, anim8);
+					}
+					_mm_storeu_si128((__m128i *) anim, anim8);
+
+					if (translucent) {
+						_mm256_storeu_si256((__m256i *) dst, AlphaBlendEightPixels(srcABCD, dstABCD, a_cm_256, pack_low_256));
+					} else {
+						_mm256_storeu_si256((__m256i *) dst, _mm256_blendv_epi8(dstABCD, srcABCD, _mm256_cvtepi16_epi32(visible)));
+					}
+bmno_next_block:
+					src_mv += 8;
+					src += 8;
+					anim += 8;
+					dst += 8;
+				}
+
+				for (; x > 0; x--) {
+					draw_single(src, src_mv, dst, anim);
+					src_mv++;
+					src++;
+					anim++;
+					dst++;
+				}
+				break;
+			}
+
+			case BM_TRANSPARENT: {
+				/* Make the current colour a bit more black, so it looks like this image is transparent. */
+				uint x = (uint) bp->width;
+				for (; x >= 8; x -= 8) {
+					__m256i srcABCD = _mm256_loadu_si256((const __m256i *) src);
+					__m256i dstABCD = _mm256_loadu_si256((const __m256i *) dst);
+					_mm256_storeu_si256((__m256i *) dst, DarkenEightPixels(srcABCD, dstABCD, a_cm_256, tr_nom_base_256));
+					__m128i anim8 = _mm_loadu_si128((const __m128i *) anim);
+					_mm_storeu_si128((__m128i *) anim, _mm_andnot_si128(NarrowPixelMask(VisiblePixelMask(srcABCD)), anim8));
+					src += 8;
+					dst += 8;
+					anim += 8;
+				}
+				for (; x > 0; x--) {
+					__m128i srcABCD = _mm_cvtsi32_si128(src->data);
+					__m128i dstABCD = _mm_cvtsi32_si128(dst->data);
+					dst->data = _mm_cvtsi128_si32(DarkenTwoPixels(srcABCD, dstABCD, a_cm, tr_nom_base));
+					if (src->a) *anim = 0;
+					src++;
+					dst++;
+					anim++;
+				}
+				break;
+			}
+		}
+
+next_line:
+		if (mode != BM_TRANSPARENT) src_mv_line += si->sprite_width;
+		src_rgba_line = (const Colour*) ((const byte*) src_rgba_line + si->sprite_line_size);
+		dst_line += bp->pitch;
+		anim_line += this->anim_buf_pitch;
+	}
+}
+IGNORE_UNINITIALIZED_WARNING_STOP
+
+/**
+ * Draws a sprite to a (screen) buffer. Calls adequate templated function.
+ * The remap modes are left to the SSE4 blitter.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void Blitter_32bppAVX2_Anim::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	const BlitterSpriteFlags sprite_flags = ((const Blitter_32bppSSE_Base::SpriteData *) bp->sprite)->flags;
+	switch (mode) {
+		default: {
+bm_normal:
+			if (bp->skip_left != 0 || bp->width <= MARGIN_NORMAL_THRESHOLD) {
+				if (sprite_flags & SF_NO_ANIM) Draw<BM_NORMAL, RM_WITH_SKIP, true, false>(bp, zoom);
+				else                           Draw<BM_NORMAL, RM_WITH_SKIP, true, true>(bp, zoom);
+			} else if (sprite_flags & SF_TRANSLUCENT) {
+				if (sprite_flags & SF_NO_ANIM) Draw<BM_NORMAL, RM_WITH_MARGIN, true, false>(bp, zoom);
+				else                           Draw<BM_NORMAL, RM_WITH_MARGIN, true, true>(bp, zoom);
+			} else {
+				if (sprite_flags & SF_NO_ANIM) Draw<BM_NORMAL, RM_WITH_MARGIN, false, false>(bp, zoom);
+				else                           Draw<BM_NORMAL, RM_WITH_MARGIN, false, true>(bp, zoom);
+			}
+			break;
+		}
+		case BM_COLOUR_REMAP:
+			if (sprite_flags & SF_NO_REMAP) goto bm_normal;
+			Blitter_32bppSSE4_Anim::Draw(bp, mode, zoom);
+			return;
+		case BM_TRANSPARENT:  Draw<BM_TRANSPARENT, RM_NONE, true, true>(bp, zoom); return;
+		case BM_CRASH_REMAP:
+		case BM_BLACK_REMAP:
+			Blitter_32bppSSE4_Anim::Draw(bp, mode, zoom);
+			return;
+	}
+}
+
+void Blitter_32bppAVX2_Anim::DrawColourMappingRect(void *dst, int width, int height, PaletteID pal)
+{
+	/* When not drawing to the screen there is no animation buffer to clear. */
+	uint16 *anim = _screen_disable_anim ? nullptr : this->anim_buf + this->ScreenToAnimOffset((uint32 *)dst);
+	if (DrawColourMappingRectAVX2((Colour *) dst, anim, this->anim_buf_pitch, width, height, pal)) return;
+
+	DEBUG(misc, 0, "32bpp blitter doesn't know how to draw this colour table ('%d')", pal);
+}
+
+void Blitter_32bppAVX2_Anim::PaletteAnimate(const Palette &palette)
+{
+	assert(!_screen_disable_anim);
+
+	this->palette = palette;
+	/* If first_dirty is 0, it is for 8bpp indication to send the new
+	 *  palette. However, only the animation colours might possibly change.
+	 *  Especially when going between toyland and non-toyland. */
+	assert(this->palette.first_dirty == PALETTE_ANIM_START || this->palette.first_dirty == 0);
+
+	const uint16 *anim = this->anim_buf;
+	Colour *dst = (Colour *)_screen.dst_ptr;
+
+	bool screen_dirty = false;
+
+	/* Let's walk the anim buffer and try to find the pixels */
+	const int width = this->anim_buf_width;
+	const int screen_pitch = _screen.pitch;
+	const int anim_pitch = this->anim_buf_pitch;
+	const int *palette_table = (const int *) this->palette.palette;
+	const __m256i anim_cmp = _mm256_set1_epi16(PALETTE_ANIM_START - 1);
+	const __m256i brightness_cmp = _mm256_set1_epi16(Blitter_32bppBase::DEFAULT_BRIGHTNESS);
+	const __m256i colour_mask = _mm256_set1_epi16(0xFF);
+	for (int y = this->anim_buf_height; y != 0 ; y--) {
+		Colour *next_dst_ln = dst + screen_pitch;
+		const uint16 *next_anim_ln = anim + anim_pitch;
+		int x = width;
+		for (; x >= 16; x -= 16) {
+			const __m256i data = _mm256_loadu_si256((const __m256i *) anim);
+			const __m256i colour_data = _mm256_and_si256(data, colour_mask);
+
+			/* test if any colour >= PALETTE_ANIM_START */
+			const __m256i animated = _mm256_cmpgt_epi16(colour_data, anim_cmp);
+			if (unlikely(!_mm256_testz_si256(animated, animated))) {
+				const __m256i odd_brightness = _mm256_andnot_si256(_mm256_cmpeq_epi16(_mm256_srli_epi16(data, 8), brightness_cmp), animated);
+				if (unlikely(!_mm256_testz_si256(odd_brightness, odd_brightness))) {
+					/* slow path: unexpected brightnesses */
+					for (int z = 0; z < 16; z++) {
+						const uint8 colour = GB(anim[z], 0, 8);
+						if (colour >= PALETTE_ANIM_START) dst[z] = AdjustBrightneSSE(LookupColourInPalette(colour), GB(anim[z], 8, 8));
+					}
+				} else {
+					/* fast path: gather the palette colours of all 16 pixels and only keep the animated ones */
+					const __m128i colour_lo = _mm256_castsi256_si128(colour_data);
+					const __m128i colour_hi = _mm256_extracti128_si256(colour_data, 1);
+					const __m256i mask_lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(animated));
+					const __m256i mask_hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(animated, 1));
+					const __m256i pal_lo = _mm256_i32gather_epi32(palette_table, _mm256_cvtepu16_epi32(colour_lo), 4);
+					const __m256i pal_hi = _mm256_i32gather_epi32(palette_table, _mm256_cvtepu16_epi32(colour_hi), 4);
+					const __m256i dst_lo = _mm256_loadu_si256((const __m256i *) dst);
+					const __m256i dst_hi = _mm256_loadu_si256((const __m256i *) (dst + 8));
+					_mm256_storeu_si256((__m256i *) dst, _mm256_blendv_epi8(dst_lo, pal_lo, mask_lo));
+					_mm256_storeu_si256((__m256i *) (dst + 8), _mm256_blendv_epi8(dst_hi, pal_hi, mask_hi));
+				}
+				screen_dirty = true;
+			}
+			anim += 16;
+			dst += 16;
+		}
+
+		/* less than 16 pixels left */
+		for (; x > 0; x--) {
+			const uint8 colour = GB(*anim, 0, 8);
+			if (colour >= PALETTE_ANIM_START) {
+				*dst = AdjustBrightneSSE(LookupColourInPalette(colour), GB(*anim, 8, 8));
+				screen_dirty = true;
+			}
+			anim++;
+			dst++;
+		}
+		dst = next_dst_ln;
+		anim = next_anim_ln;
+	}
+
+	if (screen_dirty) {
+		/* Make sure the backend redraws the whole screen */
+		VideoDriver::GetInstance()->MakeDirty(0, 0, _screen.width, _screen.height);
+	}
+}
+
+#endif /* WITH_SSE */
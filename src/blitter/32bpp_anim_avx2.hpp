@@ -0,0 +1,47 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_anim_avx2.hpp A 32 bpp blitter with animation support, AVX2 version. */
+
+#ifndef BLITTER_32BPP_AVX2_ANIM_HPP
+#define BLITTER_32BPP_AVX2_ANIM_HPP
+
+#ifdef WITH_SSE
+
+#ifndef SSE_VERSION
+#define SSE_VERSION 5
+#endif
+
+#ifndef FULL_ANIMATION
+#define FULL_ANIMATION 1
+#endif
+
+#include "32bpp_anim_sse4.hpp"
+
+/**
+ * The AVX2 32 bpp blitter with palette animation.
+ * Plain and transparent sprites are drawn eight pixels at a time; remaps are left to the SSE4 code.
+ */
+class Blitter_32bppAVX2_Anim FINAL : public Blitter_32bppSSE4_Anim {
+public:
+	template <BlitterMode mode, Blitter_32bppSSE_Base::ReadMode read_mode, bool translucent, bool animated>
+	void Draw(const Blitter::BlitterParams *bp, ZoomLevel zoom);
+	void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom) override;
+	void DrawColourMappingRect(void *dst, int width, int height, PaletteID pal) override;
+	void PaletteAnimate(const Palette &palette) override;
+	const char *GetName() override { return "32bpp-avx2-anim"; }
+};
+
+/** Factory for the AVX2 32 bpp blitter (with palette animation). */
+class FBlitter_32bppAVX2_Anim: public BlitterFactory {
+public:
+	FBlitter_32bppAVX2_Anim() : BlitterFactory("32bpp-avx2-anim", "32bpp AVX2 Blitter (palette animation)", HasCPUAVX2Support()) {}
+	Blitter *CreateInstance() override { return new Blitter_32bppAVX2_Anim(); }
+};
+
+#endif /* WITH_SSE */
+#endif /* BLITTER_32BPP_AVX2_ANIM_HPP */
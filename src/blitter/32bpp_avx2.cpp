@@ -0,0 +1,303 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_avx2.cpp Implementation of the AVX2 32 bpp blitter. */
+
+#ifdef WITH_SSE
+
+#include "../stdafx.h"
+#include "../zoom_func.h"
+#include "../settings_type.h"
+#include "../gfx_func.h"
+#include "../table/sprites.h"
+#include "32bpp_avx2.hpp"
+#include "32bpp_avx2_func.hpp"
+
+#include "../safeguards.h"
+
+/** Instantiation of the AVX2 32bpp blitter factory. */
+static FBlitter_32bppAVX2 iFBlitter_32bppAVX2;
+
+/**
+ * Draws a sprite to a (screen) buffer, eight pixels at a time.
+ * The remaining pixels of each line are drawn one at a time, so unlike the SSE
+ * blitters there is no specialisation for the width being odd or even.
+ *
+ * @tparam mode blitter mode
+ * @tparam read_mode how to skip the empty pixels of a line
+ * @tparam translucent whether the sprite has pixels that are neither fully transparent nor fully opaque
+ * @param bp further blitting parameters
+ * @param zoom zoom level at which we are drawing
+ */
+IGNORE_UNINITIALIZED_WARNING_START
+template <BlitterMode mode, Blitter_32bppSSE_Base::ReadMode read_mode, bool translucent>
+inline void Blitter_32bppAVX2::Draw(const Blitter::BlitterParams *bp, ZoomLevel zoom)
+{
+	const byte * const remap = bp->remap;
+	Colour *dst_line = (Colour *) bp->dst + bp->top * bp->pitch + bp->left;
+	int effective_width = bp->width;
+
+	/* Find where to start reading in the source sprite. */
+	const SpriteData * const sd = (const SpriteData *) bp->sprite;
+	const SpriteInfo * const si = &sd->infos[zoom];
+	const MapValue *src_mv_line = (const MapValue *) &sd->data[si->mv_offset] + bp->skip_top * si->sprite_width;
+	const Colour *src_rgba_line = (const Colour *) ((const byte *) &sd->data[si->sprite_offset] + bp->skip_top * si->sprite_line_size);
+
+	if (read_mode != RM_WITH_MARGIN) {
+		src_rgba_line += bp->skip_left;
+		src_mv_line += bp->skip_left;
+	}
+	const MapValue *src_mv = src_mv_line;
+
+	/* Load these variables into register before loop. */
+	const __m128i a_cm        = ALPHA_CONTROL_MASK;
+	const __m128i pack_low_cm = PACK_LOW_CONTROL_MASK;
+	const __m128i tr_nom_base = TRANSPARENT_NOM_BASE;
+	const __m256i a_cm_256        = ALPHA_CONTROL_MASK_256;
+	const __m256i pack_low_256    = PACK_LOW_MASK_256;
+	const __m256i tr_nom_base_256 = TRANSPARENT_NOM_BASE_256;
+
+	for (int y = bp->height; y != 0; y--) {
+		Colour *dst = dst_line;
+		const Colour *src = src_rgba_line + META_LENGTH;
+		if (mode == BM_COLOUR_REMAP || mode == BM_CRASH_REMAP) src_mv = src_mv_line;
+
+		if (read_mode == RM_WITH_MARGIN) {
+			src += src_rgba_line[0].data;
+			dst += src_rgba_line[0].data;
+			if (mode == BM_COLOUR_REMAP || mode == BM_CRASH_REMAP) src_mv += src_rgba_line[0].data;
+			const int width_diff = si->sprite_width - bp->width;
+			effective_width = bp->width - (int) src_rgba_line[0].data;
+			const int delta_diff = (int) src_rgba_line[1].data - width_diff;
+			const int new_width = effective_width - delta_diff;
+			effective_width = delta_diff > 0 ? new_width : effective_width;
+			if (effective_width <= 0) goto next_line;
+		}
+
+		switch (mode) {
+			default: {
+				uint x = (uint) effective_width;
+				if (!translucent) {
+					/* Every pixel is either fully transparent or fully opaque: a plain select. */
+					for (; x >= 8; x -= 8) {
+						__m256i srcABCD = _mm256_loadu_si256((const __m256i *) src);
+						__m256i dstABCD = _mm256_loadu_si256((const __m256i *) dst);
+						_mm256_storeu_si256((__m256i *) dst, _mm256_blendv_epi8(dstABCD, srcABCD, VisiblePixelMask(srcABCD)));
+						src += 8;
+						dst += 8;
+					}
+					for (; x > 0; x--) {
+						if (src->a) *dst = *src;
+						src++;
+						dst++;
+					}
+					break;
+				}
+
+				for (; x >= 8; x -= 8) {
+					__m256i srcABCD = _mm256_loadu_si256((const __m256i *) src);
+					__m256i dstABCD = _mm256_loadu_si256((const __m256i *) dst);
+					_mm256_storeu_si256((__m256i *) dst, AlphaBlendEightPixels(srcABCD, dstABCD, a_cm_256, pack_low_256));
+					src += 8;
+					dst += 8;
+				}
+				for (; x > 0; x--) {
+					__m128i srcABCD = _mm_cvtsi32_si128(src->data);
+					__m128i dstABCD = _mm_cvtsi32_si128(dst->data);
+					dst->data = _mm_cvtsi128_si32(AlphaBlendTwoPixels(srcABCD, dstABCD, a_cm, pack_low_cm));
+					src++;
+					dst++;
+				}
+				break;
+			}
+
+			case BM_COLOUR_REMAP: {
+				uint x = (uint) effective_width;
+				for (; x >= 8; x -= 8) {
+					__m256i srcABCD = _mm256_loadu_si256((const __m256i *) src);
+					__m256i dstABCD = _mm256_loadu_si256((const __m256i *) dst);
+
+					/* Only remap when any of the 8 pixels has a non zero m-channel; most blocks of a remapped sprite do not. */
+					const __m128i mv = _mm_loadu_si128((const __m128i *) src_mv);
+					if (!_mm_testz_si128(mv, _mm_set1_epi16(0x00FF))) {
+						Colour remapped_src[8];
+						for (uint i = 0; i < 8; i += 2) {
+							const uint32 mvX2 = *((const uint32 *) (src_mv + i));
+							__m128i srcAB = _mm_loadl_epi64((const __m128i *) (src + i));
+							if (mvX2 & 0x00FF00FF) {
+								#define CMOV_REMAP(m_colour, m_colour_init, m_src, m_m) \
+									/* Written so the compiler uses CMOV. */ \
+									Colour m_colour = m_colour_init; \
+									{ \
+									const Colour srcm = (Colour) (m_src); \
+									const uint m = (byte) (m_m); \
+									const uint r = remap[m]; \
+									const Colour cmap = (this->LookupColourInPalette(r).data & 0x00FFFFFF) | (srcm.data & 0xFF000000); \
+									m_colour = r == 0 ? m_colour : cmap; \
+									m_colour = m != 0 ? m_colour : srcm; \
+									}
+								CMOV_REMAP(c0, 0, src[i], mvX2);
+								CMOV_REMAP(c1, 0, src[i + 1], mvX2 >> 16);
+								#undef CMOV_REMAP
+								srcAB = _mm_cvtsi32_si128(c0.data);
+								InsertSecondUint32(c1.data, srcAB);
+
+								if ((mvX2 & 0xFF00FF00) != 0x80008000) srcAB = AdjustBrightnessOfTwoPixels(srcAB, mvX2);
+							}
+							_mm_storel_epi64((__m128i *) &remapped_src[i], srcAB);
+						}
+						srcABCD = _mm256_loadu_si256((const __m256i *) remapped_src);
+					}
+
+					/* Blend colours. */
+					_mm256_storeu_si256((__m256i *) dst, AlphaBlendEightPixels(srcABCD, dstABCD, a_cm_256, pack_low_256));
+					dst += 8;
+					src += 8;
+					src_mv += 8;
+				}
+
+				for (; x > 0; x--) {
+					/* In case the m-channel is zero, do not remap this pixel in any way. */
+					__m128i srcABCD;
+					if (src_mv->m) {
+						const uint r = remap[src_mv->m];
+						if (r != 0) {
+							Colour remapped_colour = AdjustBrightneSSE(this->LookupColourInPalette(r), src_mv->v);
+							if (src->a == 255) {
+								*dst = remapped_colour;
+							} else {
+								remapped_colour.a = src->a;
+								srcABCD = _mm_cvtsi32_si128(remapped_colour.data);
+								goto bmcr_alpha_blend_single;
+							}
+						}
+					} else {
+						srcABCD = _mm_cvtsi32_si128(src->data);
+						if (src->a < 255) {
+bmcr_alpha_blend_single:
+							__m128i dstABCD = _mm_cvtsi32_si128(dst->data);
+							srcABCD = AlphaBlendTwoPixels(srcABCD, dstABCD, a_cm, pack_low_cm);
+						}
+						dst->data = _mm_cvtsi128_si32(srcABCD);
+					}
+					src_mv++;
+					dst++;
+					src++;
+				}
+				break;
+			}
+
+			case BM_TRANSPARENT: {
+				/* Make the current colour a bit more black, so it looks like this image is transparent. */
+				uint x = (uint) bp->width;
+				for (; x >= 8; x -= 8) {
+					__m256i srcABCD = _mm256_loadu_si256((const __m256i *) src);
+					__m256i dstABCD = _mm256_loadu_si256((const __m256i *) dst);
+					_mm256_storeu_si256((__m256i *) dst, DarkenEightPixels(srcABCD, dstABCD, a_cm_256, tr_nom_base_256));
+					src += 8;
+					dst += 8;
+				}
+				for (; x > 0; x--) {
+					__m128i srcABCD = _mm_cvtsi32_si128(src->data);
+					__m128i dstABCD = _mm_cvtsi32_si128(dst->data);
+					dst->data = _mm_cvtsi128_si32(DarkenTwoPixels(srcABCD, dstABCD, a_cm, tr_nom_base));
+					src++;
+					dst++;
+				}
+				break;
+			}
+
+			case BM_CRASH_REMAP:
+				for (uint x = (uint) bp->width; x > 0; x--) {
+					if (src_mv->m == 0) {
+						if (src->a != 0) {
+							uint8 g = MakeDark(src->r, src->g, src->b);
+							*dst = ComposeColourRGBA(g, g, g, src->a, *dst);
+						}
+					} else {
+						uint r = remap[src_mv->m];
+						if (r != 0) *dst = ComposeColourPANoCheck(this->AdjustBrightness(this->LookupColourInPalette(r), src_mv->v), src->a, *dst);
+					}
+					src_mv++;
+					dst++;
+					src++;
+				}
+				break;
+
+			case BM_BLACK_REMAP: {
+				const __m256i black = _mm256_set1_epi32(Colour(0, 0, 0).data);
+				uint x = (uint) bp->width;
+				for (; x >= 8; x -= 8) {
+					__m256i srcABCD = _mm256_loadu_si256((const __m256i *) src);
+					__m256i dstABCD = _mm256_loadu_si256((const __m256i *) dst);
+					_mm256_storeu_si256((__m256i *) dst, _mm256_blendv_epi8(dstABCD, black, VisiblePixelMask(srcABCD)));
+					src += 8;
+					dst += 8;
+				}
+				for (; x > 0; x--) {
+					if (src->a != 0) {
+						*dst = Colour(0, 0, 0);
+					}
+					dst++;
+					src++;
+				}
+				break;
+			}
+		}
+
+next_line:
+		if (mode == BM_COLOUR_REMAP || mode == BM_CRASH_REMAP) src_mv_line += si->sprite_width;
+		src_rgba_line = (const Colour*) ((const byte*) src_rgba_line + si->sprite_line_size);
+		dst_line += bp->pitch;
+	}
+}
+IGNORE_UNINITIALIZED_WARNING_STOP
+
+/**
+ * Draws a sprite to a (screen) buffer. Calls adequate templated function.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void Blitter_32bppAVX2::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	switch (mode) {
+		default: {
+			if (bp->skip_left != 0 || bp->width <= MARGIN_NORMAL_THRESHOLD) {
+bm_normal:
+				Draw<BM_NORMAL, RM_WITH_SKIP, true>(bp, zoom);
+			} else {
+				if (((const Blitter_32bppSSE_Base::SpriteData *) bp->sprite)->flags & SF_TRANSLUCENT) {
+					Draw<BM_NORMAL, RM_WITH_MARGIN, true>(bp, zoom);
+				} else {
+					Draw<BM_NORMAL, RM_WITH_MARGIN, false>(bp, zoom);
+				}
+			}
+			return;
+		}
+		case BM_COLOUR_REMAP:
+			if (((const Blitter_32bppSSE_Base::SpriteData *) bp->sprite)->flags & SF_NO_REMAP) goto bm_normal;
+			if (bp->skip_left != 0 || bp->width <= MARGIN_REMAP_THRESHOLD) {
+				Draw<BM_COLOUR_REMAP, RM_WITH_SKIP, true>(bp, zoom); return;
+			} else {
+				Draw<BM_COLOUR_REMAP, RM_WITH_MARGIN, true>(bp, zoom); return;
+			}
+		case BM_TRANSPARENT:  Draw<BM_TRANSPARENT, RM_NONE, true>(bp, zoom); return;
+		case BM_CRASH_REMAP:  Draw<BM_CRASH_REMAP, RM_NONE, true>(bp, zoom); return;
+		case BM_BLACK_REMAP:  Draw<BM_BLACK_REMAP, RM_NONE, true>(bp, zoom); return;
+	}
+}
+
+void Blitter_32bppAVX2::DrawColourMappingRect(void *dst, int width, int height, PaletteID pal)
+{
+	if (DrawColourMappingRectAVX2((Colour *) dst, nullptr, 0, width, height, pal)) return;
+
+	DEBUG(misc, 0, "32bpp blitter doesn't know how to draw this colour table ('%d')", pal);
+}
+
+#endif /* WITH_SSE */
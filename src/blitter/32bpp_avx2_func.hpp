@@ -0,0 +1,145 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_avx2_func.hpp Functions related to AVX2 32 bpp blitter. */
+
+#ifndef BLITTER_32BPP_AVX2_FUNC_HPP
+#define BLITTER_32BPP_AVX2_FUNC_HPP
+
+#ifdef WITH_SSE
+
+#include "32bpp_sse_func.hpp"
+
+#define ALPHA_CONTROL_MASK_256     _mm256_broadcastsi128_si256(ALPHA_CONTROL_MASK)
+#define PACK_LOW_MASK_256          _mm256_setr_epi8(-1, 0, -1, 0, -1, 0, 0, 0, -1, 0, -1, 0, -1, 0, 0, 0, -1, 0, -1, 0, -1, 0, 0, 0, -1, 0, -1, 0, -1, 0, 0, 0)
+#define TRANSPARENT_NOM_BASE_256   _mm256_set1_epi16(256)
+#define ALPHA_CHANNEL_MASK_256     _mm256_set1_epi32(0xFF000000)
+
+/**
+ * Alpha blend 8 pixels, the 256 bit counterpart of AlphaBlendTwoPixels().
+ * Each 128 bit lane is unpacked into two halves so the packing at the end restores the pixel order.
+ */
+static inline __m256i AlphaBlendEightPixels(__m256i src, __m256i dst, const __m256i &distribution_mask, const __m256i &pack_mask)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i srcLo = _mm256_unpacklo_epi8(src, zero); // VPUNPCKLBW, pixels 0, 1, 4, 5
+	__m256i srcHi = _mm256_unpackhi_epi8(src, zero); // VPUNPCKHBW, pixels 2, 3, 6, 7
+	__m256i dstLo = _mm256_unpacklo_epi8(dst, zero);
+	__m256i dstHi = _mm256_unpackhi_epi8(dst, zero);
+
+	__m256i alphaLo = _mm256_cmpgt_epi16(srcLo, zero); // if (alpha > 0) a++;
+	__m256i alphaHi = _mm256_cmpgt_epi16(srcHi, zero);
+	alphaLo = _mm256_shuffle_epi8(_mm256_add_epi16(_mm256_srli_epi16(alphaLo, 15), srcLo), distribution_mask);
+	alphaHi = _mm256_shuffle_epi8(_mm256_add_epi16(_mm256_srli_epi16(alphaHi, 15), srcHi), distribution_mask);
+
+	srcLo = _mm256_mullo_epi16(_mm256_sub_epi16(srcLo, dstLo), alphaLo); // a*(r - Cr)
+	srcHi = _mm256_mullo_epi16(_mm256_sub_epi16(srcHi, dstHi), alphaHi);
+	srcLo = _mm256_add_epi16(_mm256_srli_epi16(srcLo, 8), dstLo);        // a*(r - Cr)/256 + Cr
+	srcHi = _mm256_add_epi16(_mm256_srli_epi16(srcHi, 8), dstHi);
+
+	/* Only the low bytes are meaningful, so wipe the high ones before the saturating pack.
+	 * Like PACK_LOW_CONTROL_MASK this clears alpha as well. */
+	return _mm256_packus_epi16(_mm256_and_si256(srcLo, pack_mask), _mm256_and_si256(srcHi, pack_mask));
+}
+
+/** Darken 8 pixels, the 256 bit counterpart of DarkenTwoPixels(). */
+static inline __m256i DarkenEightPixels(__m256i src, __m256i dst, const __m256i &distribution_mask, const __m256i &tr_nom_base)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i alphaLo = _mm256_srli_epi16(_mm256_shuffle_epi8(_mm256_unpacklo_epi8(src, zero), distribution_mask), 2);
+	__m256i alphaHi = _mm256_srli_epi16(_mm256_shuffle_epi8(_mm256_unpackhi_epi8(src, zero), distribution_mask), 2);
+	__m256i dstLo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, zero), _mm256_sub_epi16(tr_nom_base, alphaLo));
+	__m256i dstHi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, zero), _mm256_sub_epi16(tr_nom_base, alphaHi));
+	return _mm256_packus_epi16(_mm256_srli_epi16(dstLo, 8), _mm256_srli_epi16(dstHi, 8));
+}
+
+/**
+ * Get a mask of the pixels with a non zero alpha.
+ * @param src The 8 pixels.
+ * @return All bits set in the 32 bit lanes of the visible pixels.
+ */
+static inline __m256i VisiblePixelMask(__m256i src)
+{
+	const __m256i transparent = _mm256_cmpeq_epi32(_mm256_and_si256(src, ALPHA_CHANNEL_MASK_256), _mm256_setzero_si256());
+	return _mm256_xor_si256(transparent, _mm256_set1_epi32(-1));
+}
+
+/**
+ * Narrow a mask of 8 32 bit lanes into a mask of 8 16 bit lanes, e.g. to address the animation buffer.
+ * @param mask The 32 bit lane mask; every lane has to be either all ones or zero.
+ * @return The same mask, in 16 bit lanes.
+ */
+static inline __m128i NarrowPixelMask(__m256i mask)
+{
+	return _mm_packs_epi32(_mm256_castsi256_si128(mask), _mm256_extracti128_si256(mask, 1));
+}
+
+/** MakeTransparent() with a nominator of 154 for 8 pixels; alpha becomes opaque. */
+static inline __m256i MakeTransparentEightPixels(__m256i colour)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i nom = _mm256_set1_epi16(154);
+	__m256i lo = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(colour, zero), nom), 8);
+	__m256i hi = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(colour, zero), nom), 8);
+	return _mm256_or_si256(_mm256_packus_epi16(lo, hi), ALPHA_CHANNEL_MASK_256);
+}
+
+/** MakeGrey() for 8 pixels; alpha becomes opaque. */
+static inline __m256i MakeGreyEightPixels(__m256i colour)
+{
+	const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+	__m256i b = _mm256_and_si256(colour, byte_mask);
+	__m256i g = _mm256_and_si256(_mm256_srli_epi32(colour, 8), byte_mask);
+	__m256i r = _mm256_and_si256(_mm256_srli_epi32(colour, 16), byte_mask);
+	__m256i grey = _mm256_mullo_epi32(r, _mm256_set1_epi32(19595));
+	grey = _mm256_add_epi32(grey, _mm256_mullo_epi32(g, _mm256_set1_epi32(38470)));
+	grey = _mm256_add_epi32(grey, _mm256_mullo_epi32(b, _mm256_set1_epi32(7471)));
+	grey = _mm256_srli_epi32(grey, 16);
+	grey = _mm256_or_si256(grey, _mm256_or_si256(_mm256_slli_epi32(grey, 8), _mm256_slli_epi32(grey, 16)));
+	return _mm256_or_si256(grey, ALPHA_CHANNEL_MASK_256);
+}
+
+/**
+ * Apply one of the 32bpp colour mapping palettes to a rectangle of the screen, eight pixels at a time.
+ * @param udst The top left pixel of the rectangle.
+ * @param anim The matching position in the animation buffer, or \c nullptr when there is none.
+ * @param anim_pitch The pitch of the animation buffer.
+ * @param width The width of the rectangle.
+ * @param height The height of the rectangle.
+ * @param pal The palette to apply.
+ * @return False when the palette is not known to 32bpp blitters.
+ */
+static inline bool DrawColourMappingRectAVX2(Colour *udst, uint16 *anim, int anim_pitch, int width, int height, PaletteID pal)
+{
+	const bool transparent = (pal == PALETTE_TO_TRANSPARENT);
+	if (!transparent && pal != PALETTE_NEWSPAPER) return false;
+
+	do {
+		int x = width;
+		for (; x >= 8; x -= 8) {
+			__m256i colour = _mm256_loadu_si256((const __m256i *) udst);
+			colour = transparent ? MakeTransparentEightPixels(colour) : MakeGreyEightPixels(colour);
+			_mm256_storeu_si256((__m256i *) udst, colour);
+			udst += 8;
+			if (anim != nullptr) {
+				_mm_storeu_si128((__m128i *) anim, _mm_setzero_si128());
+				anim += 8;
+			}
+		}
+		for (; x > 0; x--) {
+			*udst = transparent ? Blitter_32bppBase::MakeTransparent(*udst, 154) : Blitter_32bppBase::MakeGrey(*udst);
+			udst++;
+			if (anim != nullptr) *anim++ = 0;
+		}
+		udst = udst - width + _screen.pitch;
+		if (anim != nullptr) anim = anim - width + anim_pitch;
+	} while (--height);
+	return true;
+}
+
+#endif /* WITH_SSE */
+#endif /* BLITTER_32BPP_AVX2_FUNC_HPP */
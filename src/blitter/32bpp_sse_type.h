@@ -19,6 +19,8 @@
 #include <tmmintrin.h>
 #elif (SSE_VERSION == 4)
 #include <smmintrin.h>
+#elif (SSE_VERSION == 5)
+#include <immintrin.h>
 #endif
 
 #define META_LENGTH 2 ///< Number of uint32 inserted before each line of pixels in a sprite.
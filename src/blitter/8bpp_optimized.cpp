@@ -145,8 +145,9 @@ Sprite *Blitter_8bppOptimized::Encode(const SpriteLoader::Sprite *sprite, Alloca
 
 	/* Don't allocate memory each time, but just keep some
 	 * memory around as this function is called quite often
-	 * and the memory usage is quite low. */
-	static ReusableBuffer<byte> temp_buffer;
+	 * and the memory usage is quite low. Sprites may be encoded
+	 * on multiple threads, so each has its own buffer. */
+	static thread_local ReusableBuffer<byte> temp_buffer;
 	SpriteData *temp_dst = (SpriteData *)temp_buffer.Allocate(memory);
 	memset(temp_dst, 0, sizeof(*temp_dst));
 	byte *dst = temp_dst->data;
@@ -14,6 +14,7 @@
 #include "../debug.h"
 #include "../string_func.h"
 #include "../core/string_compare_type.hpp"
+#include "../spritecache.h"
 #include <map>
 
 
@@ -90,6 +91,9 @@ public:
 		BlitterFactory *b = GetBlitterFactory(name);
 		if (b == nullptr) return nullptr;
 
+		/* Background sprite loads encode with the active blitter. */
+		CancelSpritePrefetch();
+
 		Blitter *newb = b->CreateInstance();
 		delete *GetActiveBlitter();
 		*GetActiveBlitter() = newb;
@@ -209,6 +209,7 @@ static inline void MakeRailBridgeRamp(TileIndex t, Owner o, BridgeType bridgetyp
 static inline void MakeAqueductBridgeRamp(TileIndex t, Owner o, DiagDirection d)
 {
 	MakeBridgeRamp(t, o, 0, d, TRANSPORT_WATER);
+	InvalidateWaterRegion(t);
 }
 
 /**
@@ -277,6 +278,7 @@ static inline void SetCustomBridgeHeadRoadBits(TileIndex t, RoadTramType rtt, Ro
 		assert(bits == ROAD_NONE);
 		SB(_m[t].m2, rtt == RTT_TRAM ? 4 : 0, 4, 0);
 	}
+	YapfNotifyRoadLayoutChange(t);
 }
 
 /**
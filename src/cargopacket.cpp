@@ -409,6 +409,7 @@ void VehicleCargoList::Append(CargoPacket *cp, MoveToAction action)
 	assert(cp != nullptr);
 	assert(action == MTA_LOAD ||
 			(action == MTA_KEEP && this->action_counts[MTA_LOAD] == 0));
+	this->ApplyPendingAging();
 	this->AddToMeta(cp, action);
 
 	if (this->count == cp->count) {
@@ -557,17 +558,19 @@ void VehicleCargoList::AddToMeta(const CargoPacket *cp, MoveToAction action)
 }
 
 /**
- * Ages the all cargo in this list.
+ * Apply the aging steps deferred by AgeCargo() to all cargo in this list.
+ * Each step increases the days in transit of every packet which is not yet at the maximum.
  */
-void VehicleCargoList::AgeCargo()
+void VehicleCargoList::ApplyPendingAgingSlow()
 {
-	for (ConstIterator it(this->packets.begin()); it != this->packets.end(); it++) {
-		CargoPacket *cp = *it;
-		/* If we're at the maximum, then we can't increase no more. */
-		if (cp->days_in_transit == 0xFF) continue;
+	const uint steps = this->pending_aging;
+	this->pending_aging = 0;
 
-		cp->days_in_transit++;
-		this->cargo_days_in_transit += cp->count;
+	for (CargoPacket *cp : this->packets) {
+		/* If we're at the maximum, then we can't increase no more. */
+		const uint age = min<uint>(steps, 0xFF - cp->days_in_transit);
+		cp->days_in_transit += age;
+		this->cargo_days_in_transit += age * cp->count;
 	}
 }
 
@@ -626,6 +629,7 @@ void VehicleCargoList::SetTransferLoadPlace(TileIndex xy)
  */
 bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationIDStack next_station, uint8 order_flags, const GoodsEntry *ge, CargoPayment *payment)
 {
+	this->ApplyPendingAging();
 	this->AssertCountConsistency();
 	assert(this->action_counts[MTA_LOAD] == 0);
 	this->action_counts[MTA_TRANSFER] = this->action_counts[MTA_DELIVER] = this->action_counts[MTA_KEEP] = 0;
@@ -721,6 +725,7 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 /** Invalidates the cached data and rebuild it. */
 void VehicleCargoList::InvalidateCache()
 {
+	this->ApplyPendingAging();
 	this->feeder_share = 0;
 	this->Parent::InvalidateCache();
 }
@@ -740,6 +745,7 @@ void VehicleCargoList::InvalidateCache()
 template<VehicleCargoList::MoveToAction Tfrom, VehicleCargoList::MoveToAction Tto>
 uint VehicleCargoList::Reassign(uint max_move, TileOrStationID)
 {
+	this->ApplyPendingAging();
 	assert_tcompile(Tfrom != MTA_TRANSFER && Tto != MTA_TRANSFER);
 	assert_tcompile(Tfrom - Tto == 1 || Tto - Tfrom == 1);
 	max_move = min(this->action_counts[Tfrom], max_move);
@@ -758,6 +764,7 @@ uint VehicleCargoList::Reassign(uint max_move, TileOrStationID)
 template<>
 uint VehicleCargoList::Reassign<VehicleCargoList::MTA_DELIVER, VehicleCargoList::MTA_TRANSFER>(uint max_move, TileOrStationID next_station)
 {
+	this->ApplyPendingAging();
 	max_move = min(this->action_counts[MTA_DELIVER], max_move);
 
 	uint sum = 0;
@@ -791,6 +798,7 @@ uint VehicleCargoList::Reassign<VehicleCargoList::MTA_DELIVER, VehicleCargoList:
  */
 uint VehicleCargoList::Return(uint max_move, StationCargoList *dest, StationID next)
 {
+	this->ApplyPendingAging();
 	max_move = min(this->action_counts[MTA_LOAD], max_move);
 	this->PopCargo(CargoReturn(this, dest, max_move, next));
 	return max_move;
@@ -804,6 +812,8 @@ uint VehicleCargoList::Return(uint max_move, StationCargoList *dest, StationID n
  */
 uint VehicleCargoList::Shift(uint max_move, VehicleCargoList *dest)
 {
+	this->ApplyPendingAging();
+	dest->ApplyPendingAging();
 	max_move = min(this->count, max_move);
 	this->PopCargo(CargoShift(this, dest, max_move));
 	return max_move;
@@ -819,6 +829,7 @@ uint VehicleCargoList::Shift(uint max_move, VehicleCargoList *dest)
  */
 uint VehicleCargoList::Unload(uint max_move, StationCargoList *dest, CargoPayment *payment)
 {
+	this->ApplyPendingAging();
 	uint moved = 0;
 	if (this->action_counts[MTA_TRANSFER] > 0) {
 		uint move = min(this->action_counts[MTA_TRANSFER], max_move);
@@ -841,6 +852,7 @@ uint VehicleCargoList::Unload(uint max_move, StationCargoList *dest, CargoPaymen
  */
 uint VehicleCargoList::Truncate(uint max_move)
 {
+	this->ApplyPendingAging();
 	max_move = min(this->count, max_move);
 	if (max_move > this->ActionCount(MTA_KEEP)) this->KeepAll();
 	this->PopCargo(CargoRemoval<VehicleCargoList>(this, max_move));
@@ -857,6 +869,8 @@ uint VehicleCargoList::Truncate(uint max_move)
  */
 uint VehicleCargoList::Reroute(uint max_move, VehicleCargoList *dest, StationID avoid, StationID avoid2, const GoodsEntry *ge)
 {
+	this->ApplyPendingAging();
+	dest->ApplyPendingAging();
 	max_move = min(this->action_counts[MTA_TRANSFER], max_move);
 	this->ShiftCargoWithFrontInsert(VehicleCargoReroute(this, dest, max_move, avoid, avoid2, ge));
 	return max_move;
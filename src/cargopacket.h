@@ -286,6 +286,7 @@ protected:
 
 	Money feeder_share;                     ///< Cache for the feeder share.
 	uint action_counts[NUM_MOVE_TO_ACTION]; ///< Counts of cargo to be transferred, delivered, kept and loaded.
+	uint8 pending_aging;                    ///< NOSAVE: Number of aging steps which have not yet been applied to the packets, see AgeCargo().
 
 	template<class Taction>
 	void ShiftCargo(Taction action);
@@ -330,6 +331,8 @@ protected:
 	void AddToCache(const CargoPacket *cp);
 	void RemoveFromCache(const CargoPacket *cp, uint count);
 
+	void ApplyPendingAgingSlow();
+
 	void AddToMeta(const CargoPacket *cp, MoveToAction action);
 	void RemoveFromMeta(const CargoPacket *cp, MoveToAction action, uint count);
 
@@ -361,6 +364,46 @@ public:
 		return this->count == 0 ? INVALID_STATION : this->packets.front()->source;
 	}
 
+	/**
+	 * Apply the aging steps deferred by AgeCargo() to the packets and the days in transit cache.
+	 * This must be called before anything reads or moves the packets of this list.
+	 */
+	inline void ApplyPendingAging()
+	{
+		if (this->pending_aging != 0) this->ApplyPendingAgingSlow();
+	}
+
+	/**
+	 * Returns a pointer to the cargo packet list (so you can iterate over it etc).
+	 * @return Pointer to the packet list.
+	 */
+	inline const CargoPacketList *Packets() const
+	{
+		const_cast<VehicleCargoList *>(this)->ApplyPendingAging();
+		return this->Parent::Packets();
+	}
+
+	/**
+	 * Returns average number of days in transit for a cargo entity.
+	 * @return The before mentioned number.
+	 */
+	inline uint DaysInTransit() const
+	{
+		const_cast<VehicleCargoList *>(this)->ApplyPendingAging();
+		return this->Parent::DaysInTransit();
+	}
+
+	/**
+	 * Ages the all cargo in this list.
+	 * Aging a list with many packets is expensive, as every packet has to be visited. Vehicles usually
+	 * age their cargo many times between two stations, so the aging steps are only counted here, and
+	 * applied to all packets at once by ApplyPendingAging() when the packets are next accessed.
+	 */
+	inline void AgeCargo()
+	{
+		if (this->count != 0 && this->pending_aging != UINT8_MAX) this->pending_aging++;
+	}
+
 	/**
 	 * Returns total sum of the feeder share for all packets.
 	 * @return The before mentioned number.
@@ -428,8 +471,6 @@ public:
 
 	void Append(CargoPacket *cp, MoveToAction action = MTA_KEEP);
 
-	void AgeCargo();
-
 	void InvalidateCache();
 
 	void SetTransferLoadPlace(TileIndex xy);
@@ -424,4 +424,5 @@ extern const TileTypeProcs _tile_type_clear_procs = {
 	nullptr,                     ///< vehicle_enter_tile_proc
 	GetFoundation_Clear,      ///< get_foundation_proc
 	TerraformTile_Clear,      ///< terraform_tile_proc
+	nullptr,                  ///< tile_loop_precheck_proc
 };
@@ -268,6 +268,8 @@ static inline void MakeClear(TileIndex t, ClearGround g, uint density)
 	_me[t].m6 = 0;
 	_me[t].m7 = 0;
 	_me[t].m8 = 0;
+	InvalidateWaterRegion(t);
+	YapfNotifyRoadLayoutChange(t);
 }
 
 
@@ -34,6 +34,7 @@
 #include "ai/ai_config.hpp"
 #include "newgrf.h"
 #include "newgrf_profiling.h"
+#include "pathfinder/pathfinder_profiling.h"
 #include "console_func.h"
 #include "engine_base.h"
 #include "game/game.hpp"
@@ -1434,10 +1435,12 @@ DEF_CONSOLE_CMD(ConAlias)
 DEF_CONSOLE_CMD(ConScreenShot)
 {
 	if (argc == 0) {
-		IConsoleHelp("Create a screenshot of the game. Usage: 'screenshot [big | giant | no_con | minimap] [file name]'");
+		IConsoleHelp("Create a screenshot of the game. Usage: 'screenshot [big | giant | giant_tiles | no_con | minimap] [file name]'");
 		IConsoleHelp("'big' makes a zoomed-in screenshot of the visible area, 'giant' makes a screenshot of the "
 				"whole map, 'no_con' hides the console to create the screenshot. 'big' or 'giant' "
 				"screenshots are always drawn without console. "
+				"'giant_tiles' makes a screenshot of the whole map as 256x256 images in a directory named after the file name, "
+				"laid out as <zoom>/<x>/<y> for web map viewers. "
 				"'minimap' makes a top-viewed minimap screenshot of whole world which represents one tile by one pixel.");
 		return true;
 	}
@@ -1456,6 +1459,10 @@ DEF_CONSOLE_CMD(ConScreenShot)
 			/* screenshot giant [filename] */
 			type = SC_WORLD;
 			if (argc > 2) name = argv[2];
+		} else if (strcmp(argv[1], "giant_tiles") == 0) {
+			/* screenshot giant_tiles [filename] */
+			type = SC_WORLD_TILES;
+			if (argc > 2) name = argv[2];
 		} else if (strcmp(argv[1], "minimap") == 0) {
 			/* screenshot minimap [filename] */
 			type = SC_MINIMAP;
@@ -2248,6 +2255,44 @@ DEF_CONSOLE_CMD(ConViewportDebug)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConViewportSortBenchmark)
+{
+	if (argc < 2 || argc > 3) {
+		IConsoleHelp("Debug: Benchmark the viewport sprite sorters.  Usage: 'viewport_sort_benchmark capture' or 'viewport_sort_benchmark run [<iterations>]'");
+		IConsoleHelp("  'capture' keeps the largest parent sprite list which is sorted when the viewports are next drawn.");
+		IConsoleHelp("  'run' sorts the captured list with each available sorter, and checks that they all give the same order.");
+		return true;
+	}
+
+	extern void ViewportStartSpriteSorterCapture();
+	extern void ViewportRunSpriteSorterBenchmark(uint iterations);
+	if (strcmp(argv[1], "capture") == 0) {
+		ViewportStartSpriteSorterCapture();
+	} else if (strcmp(argv[1], "run") == 0) {
+		ViewportRunSpriteSorterBenchmark(argc == 3 ? max<uint>(strtoul(argv[2], nullptr, 0), 1) : 10);
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConViewportRenderBenchmark)
+{
+	if (argc > 3) {
+		IConsoleHelp("Debug: Benchmark viewport rendering.  Usage: 'viewport_render_benchmark [<iterations> [<blitter>]]'");
+		IConsoleHelp("  Renders viewports of the screen size at each zoom level and map mode offscreen, and reports the frame and drawing phase times.");
+		IConsoleHelp("  Another blitter than the current one can only be used with the null video driver.");
+		return true;
+	}
+
+	extern bool ViewportRunRenderBenchmark(uint iterations, const char *blitter_name, void (*print)(const char *));
+	ViewportRunRenderBenchmark(argc >= 2 ? max<uint>(strtoul(argv[1], nullptr, 0), 1) : 10, argc == 3 ? argv[2] : nullptr,
+			[](const char *line) { IConsolePrint(CC_DEFAULT, line); });
+
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConViewportMarkDirty)
 {
 	if (argc < 3 || argc > 5) {
@@ -2469,6 +2514,83 @@ DEF_CONSOLE_CMD(ConNewGRFProfile)
 	return false;
 }
 
+DEF_CONSOLE_CMD(ConPathfinderProfile)
+{
+	if (argc == 0) {
+		IConsoleHelp("Collect performance data about the pathfinder calls of all vehicles. Sub-commands can be abbreviated.");
+		IConsoleHelp("Usage: pf_profile start [<num-days>]");
+		IConsoleHelp("  Begin profiling. If a number of days is provided, profiling stops after that many in-game days.");
+		IConsoleHelp("Usage: pf_profile status [<num-vehicles>]");
+		IConsoleHelp("  Show the statistics per call site and the vehicles with the most pathfinder time collected so far.");
+		IConsoleHelp("Usage: pf_profile stop");
+		IConsoleHelp("  End profiling, show the statistics and write the collected data to a CSV file.");
+		IConsoleHelp("Usage: pf_profile abort");
+		IConsoleHelp("  End profiling and discard all collected data.");
+		return true;
+	}
+
+	if (argc < 2) return false;
+
+	/* "start" sub-command */
+	if (strncasecmp(argv[1], "sta", 3) == 0 && strncasecmp(argv[1], "stat", 4) != 0) {
+		if (_pathfinder_profiler.active) {
+			IConsolePrintF(CC_WARNING, "Pathfinder profiling is already active.");
+			return true;
+		}
+		_pathfinder_profiler.Start();
+		IConsolePrintF(CC_DEBUG, "Started pathfinder profiling");
+		if (argc >= 3) {
+			int days = max(atoi(argv[2]), 1);
+			_pathfinder_profiler.end_date = _date + days;
+
+			char datestrbuf[32]{ 0 };
+			SetDParam(0, _pathfinder_profiler.end_date);
+			GetString(datestrbuf, STR_JUST_DATE_ISO, lastof(datestrbuf));
+			IConsolePrintF(CC_DEBUG, "Profiling will automatically stop on game date %s", datestrbuf);
+		}
+		return true;
+	}
+
+	/* "status" sub-command */
+	if (strncasecmp(argv[1], "stat", 4) == 0) {
+		if (!_pathfinder_profiler.active) {
+			IConsolePrintF(CC_WARNING, "Pathfinder profiling is not active.");
+			return true;
+		}
+		_pathfinder_profiler.PrintSummary(argc >= 3 ? max(atoi(argv[2]), 0) : 10);
+		return true;
+	}
+
+	/* "stop" sub-command */
+	if (strncasecmp(argv[1], "sto", 3) == 0) {
+		_pathfinder_profiler.Finish();
+		return true;
+	}
+
+	/* "abort" sub-command */
+	if (strncasecmp(argv[1], "abo", 3) == 0) {
+		_pathfinder_profiler.Abort();
+		return true;
+	}
+
+	return false;
+}
+
+DEF_CONSOLE_CMD(ConPathfinderBenchmark)
+{
+	if (argc > 2) {
+		IConsoleHelp("Debug: Benchmark the pathfinders.  Usage: 'pf_benchmark [<iterations>]'");
+		IConsoleHelp("  Runs pathfinder queries built from the current state of all vehicles of the loaded game, and reports their times.");
+		IConsoleHelp("  These are the track choices on the tile ahead of each vehicle, depot searches and reverse checks.");
+		IConsoleHelp("  They reserve no track and change no vehicles, but fill the segment cost caches and rail destination trees.");
+		return true;
+	}
+
+	PathfinderRunBenchmark(argc == 2 ? max<uint>(strtoul(argv[1], nullptr, 0), 1) : 10);
+
+	return true;
+}
+
 #ifdef _DEBUG
 /******************
  *  debug commands
@@ -2667,6 +2789,11 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("show_industry_window", ConShowIndustryWindow, nullptr, true);
 	IConsoleCmdRegister("viewport_debug", ConViewportDebug, nullptr, true);
 	IConsoleCmdRegister("viewport_mark_dirty", ConViewportMarkDirty, nullptr, true);
+	IConsoleCmdRegister("viewport_sort_benchmark", ConViewportSortBenchmark, nullptr, true);
+	IConsoleCmdRegister("viewport_render_benchmark", ConViewportRenderBenchmark, nullptr, true);
+
+	IConsoleCmdRegister("pf_profile", ConPathfinderProfile);
+	IConsoleCmdRegister("pf_benchmark", ConPathfinderBenchmark, nullptr, true);
 
 	/* NewGRF development stuff */
 	IConsoleCmdRegister("reload_newgrfs",  ConNewGRFReload, ConHookNewGRFDeveloperTool);
@@ -88,7 +88,16 @@ uint64 ottd_rdtsc() {return 0;}
 #if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
 void ottd_cpuid(int info[4], int type)
 {
-	__cpuid(info, type);
+	__cpuidex(info, type, 0);
+}
+
+/**
+ * Get the low 32 bits of the extended control register XCR0.
+ * @return The state components the OS saves on context switches.
+ */
+static uint32 ottd_xgetbv0()
+{
+	return (uint32)_xgetbv(0);
 }
 #elif defined(__x86_64__) || defined(__i386)
 void ottd_cpuid(int info[4], int type)
@@ -108,21 +117,43 @@ void ottd_cpuid(int info[4], int type)
 			/* It is safe to write "=r" for (info[1]) as in case that PIC is enabled for i386,
 			 * the compiler will not choose EBX as target register (but something else).
 			 */
-			: "a" (type)
+			: "a" (type), "c" (0)
 	);
 #else
+	/* Sub-leaf 0 is selected explicitly, leaves such as 7 need it in ECX. */
 	__asm__ __volatile__ (
 			"cpuid           \n\t"
 			: "=a" (info[0]), "=b" (info[1]), "=c" (info[2]), "=d" (info[3])
-			: "a" (type)
+			: "a" (type), "c" (0)
 	);
 #endif /* i386 PIC */
 }
+
+/**
+ * Get the low 32 bits of the extended control register XCR0.
+ * Only call this when CPUID reports OSXSAVE support.
+ * @return The state components the OS saves on context switches.
+ */
+static uint32 ottd_xgetbv0()
+{
+	uint32 eax, edx;
+	__asm__ __volatile__ (
+			"xgetbv          \n\t"
+			: "=a" (eax), "=d" (edx)
+			: "c" (0)
+	);
+	return eax;
+}
 #else
 void ottd_cpuid(int info[4], int type)
 {
 	info[0] = info[1] = info[2] = info[3] = 0;
 }
+
+static uint32 ottd_xgetbv0()
+{
+	return 0;
+}
 #endif
 
 bool HasCPUIDFlag(uint type, uint index, uint bit)
@@ -135,3 +166,13 @@ bool HasCPUIDFlag(uint type, uint index, uint bit)
 	ottd_cpuid(cpu_info, type);
 	return HasBit(cpu_info[index], bit);
 }
+
+bool HasCPUAVX2Support()
+{
+	/* AVX2 itself, in the extended feature flags. */
+	if (!HasCPUIDFlag(7, 1, 5)) return false;
+
+	/* The OS must have enabled XSAVE and AVX, otherwise the upper halves of the YMM registers are not preserved. */
+	if (!HasCPUIDFlag(1, 2, 27) || !HasCPUIDFlag(1, 2, 28)) return false;
+	return (ottd_xgetbv0() & 0x6) == 0x6;
+}
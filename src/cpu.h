@@ -32,4 +32,11 @@ void ottd_cpuid(int info[4], int type);
  */
 bool HasCPUIDFlag(uint type, uint index, uint bit);
 
+/**
+ * Check whether AVX2 instructions can be used, i.e. the CPU supports them
+ * and the OS preserves the YMM registers.
+ * @return True when AVX2 code may be executed.
+ */
+bool HasCPUAVX2Support();
+
 #endif /* CPU_H */
@@ -19,6 +19,7 @@
 #include "linkgraph/linkgraph.h"
 #include "saveload/saveload.h"
 #include "newgrf_profiling.h"
+#include "pathfinder/pathfinder_profiling.h"
 #include "console_func.h"
 #include "debug.h"
 
@@ -272,6 +273,10 @@ static void OnNewDay()
 		NewGRFProfiler::FinishAll();
 	}
 
+	if (_pathfinder_profiler.active && _pathfinder_profiler.end_date <= _date) {
+		_pathfinder_profiler.Finish();
+	}
+
 	if (_network_server) NetworkServerDailyLoop();
 
 	DisasterDailyLoop();
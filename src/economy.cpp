@@ -574,6 +574,7 @@ void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 	IntialiseOrderDestinationRefcountMap();
 
 	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+	YapfNotifyRoadLayoutChange(INVALID_TILE);
 
 	NotifyRoadLayoutChanged();
 
@@ -25,6 +25,8 @@
 #endif
 #include <sys/stat.h>
 #include <algorithm>
+#include <atomic>
+#include <memory>
 #include <sstream>
 
 #ifdef WITH_XDG_BASEDIR
@@ -36,16 +38,21 @@
 /** Size of the #Fio data buffer. */
 #define FIO_BUFFER_SIZE 8192
 
-/** Structure for keeping several open files with just one data buffer. */
-struct Fio {
+/** Read position in the slotted files, with its data buffer. */
+struct FioReadState {
 	byte buffer_start[FIO_BUFFER_SIZE];    ///< local buffer when read from file
 	byte *buffer, *buffer_end;             ///< position pointer in local buffer and last valid byte of buffer
 	size_t pos;                            ///< current (system) position in file
 	FILE *cur_fh;                          ///< current file handle
 	const char *filename;                  ///< current filename
+};
+
+/** Structure for keeping several open files with just one data buffer. */
+struct Fio : FioReadState {
 	FILE *handles[MAX_FILE_SLOTS];         ///< array of file handles we can have open
 	const char *filenames[MAX_FILE_SLOTS]; ///< array of filenames we (should) have open
 	char *shortnames[MAX_FILE_SLOTS];      ///< array of short names for spriteloader's use
+	Subdirectory subdirs[MAX_FILE_SLOTS];  ///< array of sub directories the files were opened from
 #if defined(LIMITED_FDS)
 	uint open_handles;                     ///< current amount of open handles
 	uint usage_count[MAX_FILE_SLOTS];      ///< count how many times this file has been opened
@@ -54,6 +61,59 @@ struct Fio {
 
 static Fio _fio; ///< #Fio instance.
 
+/**
+ * Read state with file handles of its own, so a thread other than the main thread can read the slotted files.
+ * @see FioPrivateReaderScope
+ */
+struct FioPrivateReader : FioReadState {
+	FILE *handles[MAX_FILE_SLOTS] = {};    ///< handles of the files opened by this reader
+	uint generation = 0;                   ///< value of #_fio_generation when the handles were opened
+
+	void CloseAll()
+	{
+		for (FILE *&f : this->handles) {
+			if (f != nullptr) fclose(f);
+			f = nullptr;
+		}
+	}
+
+	~FioPrivateReader()
+	{
+		this->CloseAll();
+	}
+};
+
+static std::atomic<uint> _fio_generation(0);                                 ///< Incremented whenever a slot is (re)opened or closed.
+static thread_local std::unique_ptr<FioPrivateReader> _fio_private_reader;  ///< Private reader of the current thread.
+static thread_local bool _fio_private_reader_active = false;                ///< Whether the current thread reads with its private reader.
+
+/**
+ * Get the read state of the calling thread.
+ * @return The private reader inside a #FioPrivateReaderScope, otherwise the shared state of the main thread.
+ */
+static inline FioReadState &FioCurrentReadState()
+{
+	if (_fio_private_reader_active) return *_fio_private_reader;
+	return _fio;
+}
+
+FioPrivateReaderScope::FioPrivateReaderScope()
+{
+	assert(!_fio_private_reader_active);
+	if (_fio_private_reader == nullptr) _fio_private_reader.reset(new FioPrivateReader());
+	const uint generation = _fio_generation.load(std::memory_order_acquire);
+	if (_fio_private_reader->generation != generation) {
+		_fio_private_reader->CloseAll();
+		_fio_private_reader->generation = generation;
+	}
+	_fio_private_reader_active = true;
+}
+
+FioPrivateReaderScope::~FioPrivateReaderScope()
+{
+	_fio_private_reader_active = false;
+}
+
 /** Whether the working directory should be scanned. */
 static bool _do_scan_working_directory = true;
 
@@ -66,7 +126,8 @@ extern char *_highscore_file;
  */
 size_t FioGetPos()
 {
-	return _fio.pos + (_fio.buffer - _fio.buffer_end);
+	const FioReadState &fio = FioCurrentReadState();
+	return fio.pos + (fio.buffer - fio.buffer_end);
 }
 
 /**
@@ -87,10 +148,11 @@ const char *FioGetFilename(uint slot)
 void FioSeekTo(size_t pos, int mode)
 {
 	if (mode == SEEK_CUR) pos += FioGetPos();
-	_fio.buffer = _fio.buffer_end = _fio.buffer_start + FIO_BUFFER_SIZE;
-	_fio.pos = pos;
-	if (fseek(_fio.cur_fh, _fio.pos, SEEK_SET) < 0) {
-		DEBUG(misc, 0, "Seeking in %s failed", _fio.filename);
+	FioReadState &fio = FioCurrentReadState();
+	fio.buffer = fio.buffer_end = fio.buffer_start + FIO_BUFFER_SIZE;
+	fio.pos = pos;
+	if (fseek(fio.cur_fh, fio.pos, SEEK_SET) < 0) {
+		DEBUG(misc, 0, "Seeking in %s failed", fio.filename);
 	}
 }
 
@@ -113,6 +175,18 @@ static void FioRestoreFile(int slot)
  */
 void FioSeekToFile(uint slot, size_t pos)
 {
+	if (_fio_private_reader_active) {
+		FioPrivateReader &reader = *_fio_private_reader;
+		if (reader.handles[slot] == nullptr) {
+			reader.handles[slot] = FioFOpenFile(_fio.filenames[slot], "rb", _fio.subdirs[slot]);
+			if (reader.handles[slot] == nullptr) usererror("Cannot open file '%s'", _fio.filenames[slot]);
+		}
+		reader.cur_fh = reader.handles[slot];
+		reader.filename = _fio.filenames[slot];
+		FioSeekTo(pos, SEEK_SET);
+		return;
+	}
+
 	FILE *f;
 #if defined(LIMITED_FDS)
 	/* Make sure we have this file open */
@@ -131,15 +205,16 @@ void FioSeekToFile(uint slot, size_t pos)
  */
 byte FioReadByte()
 {
-	if (_fio.buffer == _fio.buffer_end) {
-		_fio.buffer = _fio.buffer_start;
-		size_t size = fread(_fio.buffer, 1, FIO_BUFFER_SIZE, _fio.cur_fh);
-		_fio.pos += size;
-		_fio.buffer_end = _fio.buffer_start + size;
+	FioReadState &fio = FioCurrentReadState();
+	if (fio.buffer == fio.buffer_end) {
+		fio.buffer = fio.buffer_start;
+		size_t size = fread(fio.buffer, 1, FIO_BUFFER_SIZE, fio.cur_fh);
+		fio.pos += size;
+		fio.buffer_end = fio.buffer_start + size;
 
 		if (size == 0) return 0;
 	}
-	return *_fio.buffer++;
+	return *fio.buffer++;
 }
 
 /**
@@ -148,9 +223,10 @@ byte FioReadByte()
  */
 void FioSkipBytes(int n)
 {
+	FioReadState &fio = FioCurrentReadState();
 	for (;;) {
-		int m = min(_fio.buffer_end - _fio.buffer, n);
-		_fio.buffer += m;
+		int m = min(fio.buffer_end - fio.buffer, n);
+		fio.buffer += m;
 		n -= m;
 		if (n == 0) break;
 		FioReadByte();
@@ -186,7 +262,8 @@ uint32 FioReadDword()
 void FioReadBlock(void *ptr, size_t size)
 {
 	FioSeekTo(FioGetPos(), SEEK_SET);
-	_fio.pos += fread(ptr, 1, size, _fio.cur_fh);
+	FioReadState &fio = FioCurrentReadState();
+	fio.pos += fread(ptr, 1, size, fio.cur_fh);
 }
 
 /**
@@ -197,6 +274,7 @@ static inline void FioCloseFile(int slot)
 {
 	if (_fio.handles[slot] != nullptr) {
 		fclose(_fio.handles[slot]);
+		_fio_generation++;
 
 		free(_fio.shortnames[slot]);
 		_fio.shortnames[slot] = nullptr;
@@ -261,6 +339,8 @@ void FioOpenFile(uint slot, const char *filename, Subdirectory subdir, char **ou
 	FioCloseFile(slot); // if file was opened before, close it
 	_fio.handles[slot] = f;
 	_fio.filenames[slot] = filename;
+	_fio.subdirs[slot] = subdir;
+	_fio_generation++;
 
 	/* Store the filename without path and extension */
 	const char *t = strrchr(filename, PATHSEPCHAR);
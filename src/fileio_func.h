@@ -25,6 +25,15 @@ void FioOpenFile(uint slot, const char *filename, Subdirectory subdir, char **ou
 void FioReadBlock(void *ptr, size_t size);
 void FioSkipBytes(int n);
 
+/**
+ * Scope in which the slotted file functions above, called on the current thread, use file handles and a buffer of this thread.
+ * This allows reading files on a thread other than the main thread; the set of opened slots must not change meanwhile.
+ */
+struct FioPrivateReaderScope {
+	FioPrivateReaderScope();
+	~FioPrivateReaderScope();
+};
+
 /**
  * The search paths OpenTTD could search through.
  * At least one of the slots has to be filled with a path.
@@ -24,6 +24,8 @@
 #include "window_gui.h"
 #include "framerate_type.h"
 #include "transparency.h"
+#include "viewport_func.h"
+#include "smallmap_gui.h"
 
 #include "table/palettes.h"
 #include "table/string_colours.h"
@@ -54,7 +56,7 @@ PauseMode _pause_mode;
 Palette _cur_palette;
 
 static byte _stringwidth_table[FS_END][224]; ///< Cache containing width of often used characters. @see GetCharacterWidth()
-DrawPixelInfo *_cur_dpi;
+thread_local DrawPixelInfo *_cur_dpi;
 byte _colour_gradient[COLOUR_END][8];
 
 static void GfxMainBlitterViewport(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub = nullptr, SpriteID sprite_id = SPR_CURSOR_MOUSE);
@@ -72,7 +74,7 @@ ZoomLevel _font_zoom; ///< Font Zoom level
  *
  * @ingroup dirty
  */
-static const byte *_colour_remap_ptr;
+static thread_local const byte *_colour_remap_ptr; ///< Remap of the sprite being drawn by this thread, viewports may be drawn by several threads at once.
 static byte _string_colourremap[3]; ///< Recoloursprite for stringdrawing. The grf loader ensures that #ST_FONT sprites only use colours 0 to 2.
 
 static const uint DIRTY_BLOCK_HEIGHT   = 8;
@@ -1328,9 +1330,6 @@ void ScreenSizeChanged()
 {
 	MarkWholeScreenDirty();
 
-	extern uint32 *_vp_map_line;
-	_vp_map_line = ReallocT<uint32>(_vp_map_line, _screen.width);
-
 	/* screen size changed and the old bitmap is invalid now, so we don't want to undraw it */
 	_cursor.visible = false;
 }
@@ -1868,6 +1867,9 @@ void SetPendingDirtyBlocks(int left, int top, int right, int bottom)
 void MarkWholeScreenDirty()
 {
 	_whole_screen_dirty = true;
+	ClearLandscapeSpriteCache();
+	ClearViewportMapColourCache();
+	ClearSmallMapColourCache();
 }
 
 /**
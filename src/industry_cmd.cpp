@@ -3005,6 +3005,7 @@ extern const TileTypeProcs _tile_type_industry_procs = {
 	nullptr,                        // vehicle_enter_tile_proc
 	GetFoundation_Industry,      // get_foundation_proc
 	TerraformTile_Industry,      // terraform_tile_proc
+	nullptr,                     // tile_loop_precheck_proc
 };
 
 bool IndustryCompare::operator() (const Industry *lhs, const Industry *rhs) const
@@ -34,6 +34,7 @@
 #include "framerate_type.h"
 #include "3rdparty/cpp-btree/btree_set.h"
 #include "scope_info.h"
+#include "worker_thread.h"
 #include <list>
 #include <set>
 #include <deque>
@@ -803,6 +804,87 @@ CommandCost CmdClearArea(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 
 TileIndex _cur_tileloop_tile;
 
+/** Number of tiles of the tile loop sequence which are prechecked together. */
+static const uint TILE_LOOP_PRECHECK_CHUNK_SIZE = 4096;
+
+static bool _tile_loop_precheck_active = false;                   ///< Whether a chunk of precheck results is currently in use.
+static std::vector<TileIndex> _tile_loop_precheck_invalidations; ///< Tiles passed to InvalidateTileLoopPrecheck while the current chunk is in use.
+
+/**
+ * Notify the tile loop that a tile has been changed in a way which may invalidate the precheck result of the tile or of its neighbours.
+ * This must be called by tile loop side effects which change a tile in a way which a tile_loop_precheck_proc depends on.
+ * @param tile The changed tile.
+ */
+void InvalidateTileLoopPrecheck(TileIndex tile)
+{
+	if (_tile_loop_precheck_active) _tile_loop_precheck_invalidations.push_back(tile);
+}
+
+/**
+ * Check whether the precheck result of a tile is invalidated by a change to the tile or one of its neighbours.
+ * @param tile The tile to check.
+ * @return true if the precheck result must not be used.
+ */
+static bool IsTileLoopPrecheckInvalidated(TileIndex tile)
+{
+	for (TileIndex t : _tile_loop_precheck_invalidations) {
+		if (DistanceMax(t, tile) <= 1) return true;
+	}
+	return false;
+}
+
+/**
+ * Run the tile loop procs of the next part of the tile loop sequence.
+ * The sequence is split into chunks, the tile loop precheck procs of each chunk are evaluated in parallel on the worker threads,
+ * then the resulting tile loop procs are run serially in sequence order. All modifications of the game state therefore still
+ * happen in exactly the same order as in the serial tile loop.
+ * @param tile First tile in the sequence.
+ * @param count Number of tiles to loop over.
+ * @param feedback LFSR feedback term.
+ * @return The tile following the last looped over tile in the sequence.
+ */
+static TileIndex RunTileLoopPrechecked(TileIndex tile, uint count, uint32 feedback)
+{
+	static TileIndex tiles[TILE_LOOP_PRECHECK_CHUNK_SIZE];
+	static TileLoopProc *procs[TILE_LOOP_PRECHECK_CHUNK_SIZE];
+
+	TileIndex cur_tile = INVALID_TILE;
+	SCOPE_INFO_FMT([&], "RunTileLoop: tile: %dx%d", TileX(cur_tile), TileY(cur_tile));
+
+	while (count > 0) {
+		const uint chunk = min<uint>(count, TILE_LOOP_PRECHECK_CHUNK_SIZE);
+		count -= chunk;
+
+		for (uint i = 0; i < chunk; i++) {
+			tiles[i] = tile;
+
+			/* Get the next tile in sequence using a Galois LFSR. */
+			tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
+		}
+
+		RunParallelFor(_general_worker_pool, chunk, 256, [](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				TileLoopPrecheckProc *precheck = _tile_type_procs[GetTileType(tiles[i])]->tile_loop_precheck_proc;
+				procs[i] = (precheck != nullptr) ? precheck(tiles[i]) : nullptr;
+			}
+		});
+
+		_tile_loop_precheck_active = true;
+		for (uint i = 0; i < chunk; i++) {
+			cur_tile = tiles[i];
+			TileLoopProc *proc = procs[i];
+			if (proc == nullptr || (!_tile_loop_precheck_invalidations.empty() && IsTileLoopPrecheckInvalidated(cur_tile))) {
+				proc = _tile_type_procs[GetTileType(cur_tile)]->tile_loop_proc;
+			}
+			proc(cur_tile);
+		}
+		_tile_loop_precheck_active = false;
+		_tile_loop_precheck_invalidations.clear();
+	}
+
+	return tile;
+}
+
 /**
  * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
  */
@@ -830,14 +912,20 @@ void RunTileLoop()
 	/* The LFSR cannot have a zeroed state. */
 	assert(tile != 0);
 
-	SCOPE_INFO_FMT([&], "RunTileLoop: tile: %dx%d", TileX(tile), TileY(tile));
-
 	/* Manually update tile 0 every 256 ticks - the LFSR never iterates over it itself.  */
 	if (_tick_counter % 256 == 0) {
 		_tile_type_procs[GetTileType(0)]->tile_loop_proc(0);
 		count--;
 	}
 
+	/* Only precheck when there are worker threads to do it, and the map is large enough to be worth it. */
+	if (_general_worker_pool.GetThreadCount() > 0 && count >= TILE_LOOP_PRECHECK_CHUNK_SIZE) {
+		_cur_tileloop_tile = RunTileLoopPrechecked(tile, count, feedback);
+		return;
+	}
+
+	SCOPE_INFO_FMT([&], "RunTileLoop: tile: %dx%d", TileX(tile), TileY(tile));
+
 	while (count--) {
 		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
 
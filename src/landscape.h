@@ -137,6 +137,7 @@ bool HasFoundationNE(TileIndex tile, Slope slope_here, uint z_here);
 
 void DoClearSquare(TileIndex tile);
 void RunTileLoop();
+void InvalidateTileLoopPrecheck(TileIndex tile);
 
 void InitializeLandscape();
 void GenerateLandscape(byte mode);
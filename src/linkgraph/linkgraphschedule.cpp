@@ -230,38 +230,28 @@ LinkGraphJobGroup::LinkGraphJobGroup(constructor_token token, std::vector<LinkGr
 void LinkGraphJobGroup::SpawnThread()
 {
 	/**
-	 * Spawn a thread if possible and run the link graph job in the thread. If
-	 * that's not possible run the job right now in the current thread.
+	 * Queue the link graph jobs as a task on the worker pool. If the pool has
+	 * no worker threads the jobs are run right now in the current thread.
 	 */
-	if (StartNewThread(&this->thread, "ottd:linkgraph", &(LinkGraphJobGroup::Run), this)) {
-		for (auto &it : this->jobs) {
-			it->SetJobGroup(this->shared_from_this());
-		}
-	} else {
-		/* Of course this will hang a bit.
-		 * On the other hand, if you want to play games which make this hang noticably
-		 * on a platform without threads then you'll probably get other problems first.
-		 * OK:
-		 * If someone comes and tells me that this hangs for him/her, I'll implement a
-		 * smaller grained "Step" method for all handlers and add some more ticks where
-		 * "Step" is called. No problem in principle. */
-		LinkGraphJobGroup::Run(this);
+	for (auto &it : this->jobs) {
+		it->SetJobGroup(this->shared_from_this());
 	}
+	this->task = _general_worker_pool.EnqueueTask(WTC_LINKGRAPH, &LinkGraphJobGroup::Run, this);
 }
 
 void LinkGraphJobGroup::JoinThread()
 {
-	if (this->thread.joinable()) {
-		this->thread.join();
+	if (this->task != nullptr) {
+		this->task->Wait();
 	}
 }
 
 /**
  * Run all jobs for the given LinkGraphJobGroup. This method is tailored to
- * ThreadObject::New.
- * @param j Pointer to a LinkGraphJobGroup.
+ * WorkerThreadPool::EnqueueTask.
+ * @param group Pointer to a LinkGraphJobGroup.
  */
-/* static */ void LinkGraphJobGroup::Run(void *group)
+/* static */ void LinkGraphJobGroup::Run(void *group, void *, void *)
 {
 	LinkGraphJobGroup *job_group = (LinkGraphJobGroup *)group;
 	for (LinkGraphJob *job : job_group->jobs) {
@@ -270,7 +260,8 @@ void LinkGraphJobGroup::JoinThread()
 }
 
 /* static */ void LinkGraphJobGroup::ExecuteJobSet(std::vector<JobInfo> jobs) {
-	const uint thread_budget = 200000;
+	/* Jobs are grouped into worker pool tasks of about this cost, the pool decides how many of them run concurrently. */
+	const uint task_budget = 200000;
 
 	std::sort(jobs.begin(), jobs.end(), [](const JobInfo &a, const JobInfo &b) {
 		return std::make_pair(a.job->JoinDateTicks(), a.cost_estimate) < std::make_pair(b.job->JoinDateTicks(), b.cost_estimate);
@@ -290,7 +281,7 @@ void LinkGraphJobGroup::JoinThread()
 	};
 
 	for (JobInfo &it : jobs) {
-		if (bucket_cost && (bucket_join_date != it.job->JoinDateTicks() || (bucket_cost + it.cost_estimate > thread_budget))) flush_bucket();
+		if (bucket_cost && (bucket_join_date != it.job->JoinDateTicks() || (bucket_cost + it.cost_estimate > task_budget))) flush_bucket();
 		bucket_join_date = it.job->JoinDateTicks();
 		bucket.push_back(it.job);
 		bucket_cost += it.cost_estimate;
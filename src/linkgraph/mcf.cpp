@@ -3,6 +3,7 @@
 #include "../stdafx.h"
 #include "../core/math_func.hpp"
 #include "mcf.h"
+#include "../worker_thread.h"
 #include "../3rdparty/cpp-btree/btree_map.h"
 #include <set>
 
@@ -10,6 +11,9 @@
 
 typedef btree::btree_map<NodeID, Path *> PathViaMap;
 
+static const uint MCF_PARALLEL_MIN_NODES = 128;  ///< Minimum component size for searching the paths of several sources at once.
+static const uint MCF_PARALLEL_BATCH_SIZE = 16;  ///< Number of sources whose paths are searched for at once in large components.
+
 /**
  * This is a wrapper around Tannotation* which also stores a cache of GetAnnotation() and GetNode()
  * to remove the need dereference the Tannotation* pointer when sorting/inseting/erasing in MultiCommodityFlow::Dijkstra::AnnoSet
@@ -264,10 +268,34 @@ bool CapacityAnnotation::IsBetter(const CapacityAnnotation *base, uint cap,
 	}
 }
 
+/**
+ * Allocate and initialise the annotations for a path search from the given source.
+ * This uses the path allocator of the job and must therefore not be called concurrently.
+ * @tparam Tannotation Annotation to be used.
+ * @param source_node Node where the path search starts.
+ * @param paths Container for the paths to be calculated.
+ */
+template<class Tannotation>
+void MultiCommodityFlow::InitPaths(NodeID source_node, PathVector &paths)
+{
+	uint size = this->job.Size();
+	paths.resize(size, nullptr);
+
+	this->job.path_allocator.SetParameters(sizeof(Tannotation), (8192 - 32) / sizeof(Tannotation));
+
+	for (NodeID node = 0; node < size; ++node) {
+		Tannotation *anno = new (this->job.path_allocator.Allocate()) Tannotation(node, node == source_node);
+		anno->UpdateAnnotation();
+		paths[node] = anno;
+	}
+}
+
 /**
  * A slightly modified Dijkstra algorithm. Grades the paths not necessarily by
  * distance, but by the value Tannotation computes. It uses the max_saturation
  * setting to artificially decrease capacities.
+ * The paths have to be initialised by InitPaths beforehand. This only modifies
+ * the given paths, so it may be run concurrently for different sources.
  * @tparam Tannotation Annotation to be used.
  * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
  * @param source_node Node where the algorithm starts.
@@ -279,20 +307,11 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 	typedef btree::btree_set<AnnoSetItem<Tannotation>, typename Tannotation::Comparator> AnnoSet;
 	AnnoSet annos = AnnoSet(typename Tannotation::Comparator());
 	Tedge_iterator iter(this->job);
-	uint size = this->job.Size();
-	paths.resize(size, nullptr);
 
-	this->job.path_allocator.SetParameters(sizeof(Tannotation), (8192 - 32) / sizeof(Tannotation));
+	Tannotation *source_anno = static_cast<Tannotation *>(paths[source_node]);
+	annos.insert(AnnoSetItem<Tannotation>(source_anno));
+	source_anno->SetAnnosSetFlag(true);
 
-	for (NodeID node = 0; node < size; ++node) {
-		Tannotation *anno = new (this->job.path_allocator.Allocate()) Tannotation(node, node == source_node);
-		anno->UpdateAnnotation();
-		if (node == source_node) {
-			annos.insert(AnnoSetItem<Tannotation>(anno)).first;
-			anno->SetAnnosSetFlag(true);
-		}
-		paths[node] = anno;
-	}
 	while (!annos.empty()) {
 		typename AnnoSet::iterator i = annos.begin();
 		Tannotation *source = i->anno_ptr;
@@ -322,6 +341,41 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 	}
 }
 
+/**
+ * Search the paths from several sources, using the worker threads. All
+ * searches see the same flows, no flow may be pushed until all of them are done.
+ * @tparam Tannotation Annotation to be used.
+ * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
+ * @param sources Nodes to search paths from.
+ * @param paths Containers for the paths to be calculated, one per source.
+ */
+template<class Tannotation, class Tedge_iterator>
+void MultiCommodityFlow::FindPaths(const std::vector<NodeID> &sources, std::vector<PathVector> &paths)
+{
+	if (paths.size() < sources.size()) paths.resize(sources.size());
+	for (size_t i = 0; i < sources.size(); ++i) {
+		this->InitPaths<Tannotation>(sources[i], paths[i]);
+	}
+	RunParallelFor(_general_worker_pool, sources.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			this->Dijkstra<Tannotation, Tedge_iterator>(sources[i], paths[i]);
+		}
+	});
+}
+
+/**
+ * Get the number of sources whose paths are searched for at once.
+ * The flows of a batch are pushed only after the paths of all of its sources
+ * have been found. This affects the result, so the batch size must not depend
+ * on the number of available threads.
+ * @param size Number of nodes in the component.
+ * @return Number of sources per batch.
+ */
+/* static */ uint MultiCommodityFlow::GetSourceBatchSize(uint size)
+{
+	return size >= MCF_PARALLEL_MIN_NODES ? MCF_PARALLEL_BATCH_SIZE : 1;
+}
+
 /**
  * Clean up paths that lead nowhere and the root path.
  * @param source_id ID of the root node.
@@ -519,43 +573,52 @@ bool MCF1stPass::EliminateCycles()
  */
 MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
-	PathVector paths;
+	std::vector<NodeID> sources;
+	std::vector<PathVector> paths;
 	uint size = job.Size();
 	uint accuracy = job.Settings().accuracy;
+	uint batch_size = GetSourceBatchSize(size);
 	bool more_loops;
 	std::vector<bool> finished_sources(size);
 
 	do {
 		more_loops = false;
-		for (NodeID source = 0; source < size; ++source) {
-			if (finished_sources[source]) continue;
+		for (NodeID next_source = 0; next_source < size;) {
+			sources.clear();
+			for (; next_source < size && sources.size() < batch_size; ++next_source) {
+				if (!finished_sources[next_source]) sources.push_back(next_source);
+			}
 
 			/* First saturate the shortest paths. */
-			this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths);
-
-			bool source_demand_left = false;
-			for (NodeID dest = 0; dest < size; ++dest) {
-				Edge edge = job[source][dest];
-				if (edge.UnsatisfiedDemand() > 0) {
-					Path *path = paths[dest];
-					assert(path != nullptr);
-					/* Generally only allow paths that don't exceed the
-					 * available capacity. But if no demand has been assigned
-					 * yet, make an exception and allow any valid path *once*. */
-					if (path->GetFreeCapacity() > 0 && this->PushFlow(edge, path,
-							accuracy, this->max_saturation) > 0) {
-						/* If a path has been found there is a chance we can
-						 * find more. */
-						more_loops = more_loops || (edge.UnsatisfiedDemand() > 0);
-					} else if (edge.UnsatisfiedDemand() == edge.Demand() &&
-							path->GetFreeCapacity() > INT_MIN) {
-						this->PushFlow(edge, path, accuracy, UINT_MAX);
+			this->FindPaths<DistanceAnnotation, GraphEdgeIterator>(sources, paths);
+
+			for (size_t i = 0; i < sources.size(); ++i) {
+				NodeID source = sources[i];
+				PathVector &source_paths = paths[i];
+				bool source_demand_left = false;
+				for (NodeID dest = 0; dest < size; ++dest) {
+					Edge edge = job[source][dest];
+					if (edge.UnsatisfiedDemand() > 0) {
+						Path *path = source_paths[dest];
+						assert(path != nullptr);
+						/* Generally only allow paths that don't exceed the
+						 * available capacity. But if no demand has been assigned
+						 * yet, make an exception and allow any valid path *once*. */
+						if (path->GetFreeCapacity() > 0 && this->PushFlow(edge, path,
+								accuracy, this->max_saturation) > 0) {
+							/* If a path has been found there is a chance we can
+							 * find more. */
+							more_loops = more_loops || (edge.UnsatisfiedDemand() > 0);
+						} else if (edge.UnsatisfiedDemand() == edge.Demand() &&
+								path->GetFreeCapacity() > INT_MIN) {
+							this->PushFlow(edge, path, accuracy, UINT_MAX);
+						}
+						if (edge.UnsatisfiedDemand() > 0) source_demand_left = true;
 					}
-					if (edge.UnsatisfiedDemand() > 0) source_demand_left = true;
 				}
+				if (!source_demand_left) finished_sources[source] = true;
+				this->CleanupPaths(source, source_paths);
 			}
-			if (!source_demand_left) finished_sources[source] = true;
-			this->CleanupPaths(source, paths);
 		}
 	} while ((more_loops || this->EliminateCycles()) && !job.IsJobAborted());
 }
@@ -568,32 +631,41 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
 	this->max_saturation = UINT_MAX; // disable artificial cap on saturation
-	PathVector paths;
+	std::vector<NodeID> sources;
+	std::vector<PathVector> paths;
 	uint size = job.Size();
 	uint accuracy = job.Settings().accuracy;
+	uint batch_size = GetSourceBatchSize(size);
 	bool demand_left = true;
 	std::vector<bool> finished_sources(size);
 	while (demand_left && !job.IsJobAborted()) {
 		demand_left = false;
-		for (NodeID source = 0; source < size; ++source) {
-			if (finished_sources[source]) continue;
+		for (NodeID next_source = 0; next_source < size;) {
+			sources.clear();
+			for (; next_source < size && sources.size() < batch_size; ++next_source) {
+				if (!finished_sources[next_source]) sources.push_back(next_source);
+			}
 
-			this->Dijkstra<CapacityAnnotation, FlowEdgeIterator>(source, paths);
+			this->FindPaths<CapacityAnnotation, FlowEdgeIterator>(sources, paths);
 
-			bool source_demand_left = false;
-			for (NodeID dest = 0; dest < size; ++dest) {
-				Edge edge = this->job[source][dest];
-				Path *path = paths[dest];
-				if (edge.UnsatisfiedDemand() > 0 && path->GetFreeCapacity() > INT_MIN) {
-					this->PushFlow(edge, path, accuracy, UINT_MAX);
-					if (edge.UnsatisfiedDemand() > 0) {
-						demand_left = true;
-						source_demand_left = true;
+			for (size_t i = 0; i < sources.size(); ++i) {
+				NodeID source = sources[i];
+				PathVector &source_paths = paths[i];
+				bool source_demand_left = false;
+				for (NodeID dest = 0; dest < size; ++dest) {
+					Edge edge = this->job[source][dest];
+					Path *path = source_paths[dest];
+					if (edge.UnsatisfiedDemand() > 0 && path->GetFreeCapacity() > INT_MIN) {
+						this->PushFlow(edge, path, accuracy, UINT_MAX);
+						if (edge.UnsatisfiedDemand() > 0) {
+							demand_left = true;
+							source_demand_left = true;
+						}
 					}
 				}
+				if (!source_demand_left) finished_sources[source] = true;
+				this->CleanupPaths(source, source_paths);
 			}
-			if (!source_demand_left) finished_sources[source] = true;
-			this->CleanupPaths(source, paths);
 		}
 	}
 }
@@ -21,13 +21,21 @@ protected:
 			max_saturation(job.Settings().short_path_saturation)
 	{}
 
+	template<class Tannotation>
+	void InitPaths(NodeID source, PathVector &paths);
+
 	template<class Tannotation, class Tedge_iterator>
 	void Dijkstra(NodeID from, PathVector &paths);
 
+	template<class Tannotation, class Tedge_iterator>
+	void FindPaths(const std::vector<NodeID> &sources, std::vector<PathVector> &paths);
+
 	uint PushFlow(Edge &edge, Path *path, uint accuracy, uint max_saturation);
 
 	void CleanupPaths(NodeID source, PathVector &paths);
 
+	static uint GetSourceBatchSize(uint size);
+
 	LinkGraphJob &job;   ///< Job we're working with.
 	uint max_saturation; ///< Maximum saturation for edges.
 };
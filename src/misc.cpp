@@ -30,6 +30,7 @@
 #include "town_kdtree.h"
 #include "viewport_kdtree.h"
 #include "newgrf_profiling.h"
+#include "pathfinder/pathfinder_profiling.h"
 #include "tracerestrict.h"
 #include "programmable_signals.h"
 #include "viewport_func.h"
@@ -37,6 +38,7 @@
 #include "command_func.h"
 #include "zoning.h"
 #include "cargopacket.h"
+#include "pathfinder/yapf/yapf_cache.h"
 
 #include "safeguards.h"
 
@@ -71,6 +73,7 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	AllocateMap(size_x, size_y);
 
 	ViewportMapClearTunnelCache();
+	YapfClearRailDestinationTrees();
 	ClearCommandLog();
 	ClearDesyncMsgLog();
 
@@ -91,6 +94,7 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	if (reset_settings) MakeNewgameSettingsLive();
 
 	_newgrf_profilers.clear();
+	_pathfinder_profiler.Abort();
 
 	if (reset_date) {
 		SetDate(ConvertYMDToDate(_settings_game.game_creation.starting_year, 0, 1), 0);
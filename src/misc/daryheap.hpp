@@ -0,0 +1,168 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file daryheap.hpp D-ary heap implementation. */
+
+#ifndef DARYHEAP_HPP
+#define DARYHEAP_HPP
+
+#include "../core/math_func.hpp"
+
+#include <vector>
+
+/**
+ * D-ary Heap as C++ template.
+ *  A priority queue which keeps its smallest item at the first position.
+ *  Each node of the tree has D children, which makes the tree flatter
+ *  than a binary heap and lets the children of a node share cache lines.
+ *
+ * @par Usage information:
+ * Item of the heap should support the 'lower-than' operator '<', and the
+ * methods GetHeapIndex() and SetHeapIndex(uint) to store the position of
+ * the item in the heap. This allows to remove any item without searching it.
+ *
+ * @par
+ * The heap only stores pointers to the items. The items are allocated elsewhere.
+ *
+ * @tparam T Type of the items stored in the heap
+ * @tparam D Number of children of each node of the heap
+ */
+template <class T, uint D = 4>
+class CDaryHeapT {
+private:
+	std::vector<T *> data; ///< The pointers to the heap items
+
+	/**
+	 * Move a gap upwards in the tree until the item fits, and put it there.
+	 * @param gap The position of the gap
+	 * @param item The item for filling the gap
+	 */
+	inline void SiftUp(uint gap, T *item)
+	{
+		while (gap > 0) {
+			uint parent = (gap - 1) / D;
+			if (!(*item < *this->data[parent])) break;
+			this->data[gap] = this->data[parent];
+			this->data[gap]->SetHeapIndex(gap);
+			gap = parent;
+		}
+		this->data[gap] = item;
+		item->SetHeapIndex(gap);
+	}
+
+	/**
+	 * Move a gap downwards in the tree until the item fits, and put it there.
+	 * @param gap The position of the gap
+	 * @param item The item for filling the gap
+	 */
+	inline void SiftDown(uint gap, T *item)
+	{
+		uint items = this->Length();
+		for (;;) {
+			uint first = gap * D + 1;
+			if (first >= items) break;
+			uint last = min(first + D, items);
+			/* choose the smallest child */
+			uint child = first;
+			for (uint i = first + 1; i < last; i++) {
+				if (*this->data[i] < *this->data[child]) child = i;
+			}
+			/* the smallest child is still bigger or same as the item => we are done */
+			if (!(*this->data[child] < *item)) break;
+			this->data[gap] = this->data[child];
+			this->data[gap]->SetHeapIndex(gap);
+			gap = child;
+		}
+		this->data[gap] = item;
+		item->SetHeapIndex(gap);
+	}
+
+public:
+	/**
+	 * Create a heap.
+	 * @param initial_capacity Number of items to reserve space for.
+	 */
+	explicit CDaryHeapT(uint initial_capacity)
+	{
+		this->data.reserve(initial_capacity);
+	}
+
+	/** Get the number of items stored in the priority queue. */
+	inline uint Length() const
+	{
+		return (uint)this->data.size();
+	}
+
+	/** Test if the priority queue is empty. */
+	inline bool IsEmpty() const
+	{
+		return this->data.empty();
+	}
+
+	/**
+	 * Get the smallest item in the heap.
+	 * @return The smallest item, or throw assert if empty.
+	 */
+	inline T *Begin()
+	{
+		assert(!this->IsEmpty());
+		return this->data[0];
+	}
+
+	/**
+	 * Insert new item into the priority queue, maintaining heap order.
+	 * @param new_item The pointer to the new item
+	 */
+	inline void Include(T *new_item)
+	{
+		this->data.push_back(new_item);
+		this->SiftUp(this->Length() - 1, new_item);
+	}
+
+	/**
+	 * Remove and return the smallest (and also first) item from the priority queue.
+	 * @return The pointer to the removed item
+	 */
+	inline T *Shift()
+	{
+		assert(!this->IsEmpty());
+		T *first = this->data[0];
+		T *last = this->data.back();
+		this->data.pop_back();
+		if (!this->IsEmpty()) this->SiftDown(0, last);
+		return first;
+	}
+
+	/**
+	 * Remove the given item from the priority queue.
+	 * @param item The item, which must be in the queue
+	 */
+	inline void Remove(T &item)
+	{
+		uint index = item.GetHeapIndex();
+		assert(index < this->Length() && this->data[index] == &item);
+		T *last = this->data.back();
+		this->data.pop_back();
+		if (index == this->Length()) return;
+		if (index > 0 && *last < *this->data[(index - 1) / D]) {
+			this->SiftUp(index, last);
+		} else {
+			this->SiftDown(index, last);
+		}
+	}
+
+	/**
+	 * Make the priority queue empty.
+	 * All remaining items will remain untouched.
+	 */
+	inline void Clear()
+	{
+		this->data.clear();
+	}
+};
+
+#endif /* DARYHEAP_HPP */
@@ -0,0 +1,196 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file openhashtable.hpp Open addressing hash table support. */
+
+#ifndef OPENHASHTABLE_HPP
+#define OPENHASHTABLE_HPP
+
+#include "../core/math_func.hpp"
+
+#include <vector>
+
+/**
+ * class COpenHashTableT<Titem> - hash table of pointers allocated elsewhere,
+ *  using open addressing with linear probing.
+ *
+ *  Supports: Add/Find/Remove of Titems.
+ *
+ *  Unlike CHashTableT the items don't need to be linked to each other, and
+ *  the table grows when it gets half full. Clearing the table doesn't touch
+ *  its slots, so it is cheap to reuse a large table for small sets of items.
+ *
+ *  Your Titem must support nested type Titem::Key and the public method
+ *    const Key& GetKey() const; // return the item's key object
+ *
+ *  In addition, the Titem::Key class must support:
+ *    - public method that calculates key's hash:
+ *        int CalcHash() const;
+ *    - public 'equality' operator to compare the key with another one
+ *        bool operator==(const Key &other) const;
+ */
+template <class Titem_>
+class COpenHashTableT {
+public:
+	typedef Titem_ Titem;                         // make Titem_ visible from outside of class
+	typedef typename Titem_::Key Tkey;            // make Titem_::Key a property of HashTable
+
+protected:
+	struct Slot {
+		Titem_ *m_item;      ///< the item, only valid if the slot is in use
+		uint32  m_hash;      ///< full hash of the key of the item
+		uint32  m_generation; ///< the slot is in use if this equals the generation of the table
+	};
+
+	std::vector<Slot> m_slots; // here we store our data, the number of slots is a power of 2
+	uint   m_shift;            // 32 - log2(number of slots)
+	int    m_num_items;        // item counter
+	uint32 m_generation;       // generation of the slots in use, never 0
+
+	/** static helper - return hash for the given key, the highest bits are used as slot index */
+	inline static uint32 CalcHash(const Tkey &key)
+	{
+		return (uint32)key.CalcHash() * 0x9E3779B9;
+	}
+
+	inline uint Mask() const
+	{
+		return (uint)m_slots.size() - 1;
+	}
+
+	inline bool IsUsed(const Slot &slot) const
+	{
+		return slot.m_generation == m_generation;
+	}
+
+	/** return index of the slot holding the item with the given key, or -1 if not found */
+	inline int FindSlot(const Tkey &key, uint32 hash) const
+	{
+		for (uint i = hash >> m_shift;; i = (i + 1) & Mask()) {
+			const Slot &slot = m_slots[i];
+			if (!IsUsed(slot)) return -1;
+			if (slot.m_hash == hash && slot.m_item->GetKey() == key) return i;
+		}
+	}
+
+	/** put an item into the first free slot of its probe sequence */
+	inline void Insert(Titem_ *item, uint32 hash)
+	{
+		uint i = hash >> m_shift;
+		while (IsUsed(m_slots[i])) i = (i + 1) & Mask();
+		m_slots[i].m_item = item;
+		m_slots[i].m_hash = hash;
+		m_slots[i].m_generation = m_generation;
+	}
+
+	/** empty the given slot, moving back the following items of the cluster which would no longer be found */
+	inline void Erase(uint gap)
+	{
+		for (uint i = (gap + 1) & Mask(); IsUsed(m_slots[i]); i = (i + 1) & Mask()) {
+			uint home = m_slots[i].m_hash >> m_shift;
+			/* The item can fill the gap unless its home slot lies cyclically between the gap and its slot. */
+			if (((i - home) & Mask()) >= ((i - gap) & Mask())) {
+				m_slots[gap] = m_slots[i];
+				gap = i;
+			}
+		}
+		m_slots[gap].m_generation = m_generation - 1;
+		m_num_items--;
+	}
+
+	/** double the number of slots */
+	void Grow()
+	{
+		std::vector<Slot> old_slots(m_slots.size() * 2);
+		old_slots.swap(m_slots);
+		m_shift--;
+		uint32 old_generation = m_generation;
+		m_generation = 1;
+		for (const Slot &slot : old_slots) {
+			if (slot.m_generation == old_generation) Insert(slot.m_item, slot.m_hash);
+		}
+	}
+
+public:
+	/**
+	 * Create a hash table.
+	 * @param initial_bits Log2 of the initial number of slots.
+	 */
+	explicit COpenHashTableT(uint initial_bits) : m_slots((size_t)1 << initial_bits), m_shift(32 - initial_bits), m_num_items(0), m_generation(1)
+	{
+		assert(initial_bits > 0 && initial_bits < 32);
+	}
+
+	/** item count */
+	inline int Count() const
+	{
+		return m_num_items;
+	}
+
+	/** forget all items */
+	inline void Clear()
+	{
+		m_num_items = 0;
+		if (++m_generation == 0) {
+			/* The generations wrapped, so old slots could appear to be in use again. */
+			for (Slot &slot : m_slots) slot.m_generation = 0;
+			m_generation = 1;
+		}
+	}
+
+	/** const item search */
+	const Titem_ *Find(const Tkey &key) const
+	{
+		int i = FindSlot(key, CalcHash(key));
+		return i < 0 ? nullptr : m_slots[i].m_item;
+	}
+
+	/** non-const item search */
+	Titem_ *Find(const Tkey &key)
+	{
+		int i = FindSlot(key, CalcHash(key));
+		return i < 0 ? nullptr : m_slots[i].m_item;
+	}
+
+	/** non-const item search & optional removal (if found) */
+	Titem_ *TryPop(const Tkey &key)
+	{
+		int i = FindSlot(key, CalcHash(key));
+		if (i < 0) return nullptr;
+		Titem_ *item = m_slots[i].m_item;
+		Erase(i);
+		return item;
+	}
+
+	/** non-const item search & removal */
+	Titem_& Pop(const Tkey &key)
+	{
+		Titem_ *item = TryPop(key);
+		assert(item != nullptr);
+		return *item;
+	}
+
+	/** non-const item removal */
+	void Pop(Titem_ &item)
+	{
+		Titem_ *popped = TryPop(item.GetKey());
+		assert(popped == &item);
+		(void)popped;
+	}
+
+	/** add one item */
+	void Push(Titem_ &new_item)
+	{
+		if ((size_t)(m_num_items + 1) * 2 > m_slots.size()) Grow();
+		uint32 hash = CalcHash(new_item.GetKey());
+		assert(FindSlot(new_item.GetKey(), hash) < 0);
+		Insert(&new_item, hash);
+		m_num_items++;
+	}
+};
+
+#endif /* OPENHASHTABLE_HPP */
@@ -57,20 +57,22 @@ INSTANTIATE_POOL_METHODS(NetworkClientSocket)
 /** Instantiate the listen sockets. */
 template SocketList TCPListenHandler<ServerNetworkGameSocketHandler, PACKET_SERVER_FULL, PACKET_SERVER_BANNED>::sockets;
 
-/** Writing a savegame directly to a number of packets. */
+/**
+ * Writing a savegame directly to a number of packets.
+ * The savegame is a snapshot of the game at a single frame, which is shared by all clients which started downloading the map at that frame.
+ * The packets are kept until all these clients have been sent a copy of them; each client tracks its own position in the packets.
+ */
 struct PacketWriter : SaveFilter {
-	ServerNetworkGameSocketHandler *cs; ///< Socket we are associated with.
-	std::unique_ptr<Packet> current;    ///< The packet we're currently writing to.
+	std::atomic<uint> clients;          ///< Number of clients still downloading this snapshot.
 	size_t total_size;                  ///< Total size of the compressed savegame.
-	std::deque<std::unique_ptr<Packet>> packets; ///< Packet queue of the savegame; send these "slowly" to the client.
+	bool finished;                      ///< Whether the whole savegame has been written.
+	std::vector<std::unique_ptr<Packet>> packets; ///< Packets of the savegame, in order; send these "slowly" to the clients.
+	std::unique_ptr<Packet> current;    ///< The packet we're currently writing to.
 	std::mutex mutex;                   ///< Mutex for making threaded saving safe.
 	std::condition_variable exit_sig;   ///< Signal for threaded destruction of this packet writer.
 
-	/**
-	 * Create the packet writer.
-	 * @param cs The socket handler we're making the packets for.
-	 */
-	PacketWriter(ServerNetworkGameSocketHandler *cs) : SaveFilter(nullptr), cs(cs), total_size(0)
+	/** Create the packet writer. */
+	PacketWriter() : SaveFilter(nullptr), clients(0), total_size(0), finished(false)
 	{
 	}
 
@@ -79,29 +81,39 @@ struct PacketWriter : SaveFilter {
 	{
 		std::unique_lock<std::mutex> lock(this->mutex);
 
-		if (this->cs != nullptr) this->exit_sig.wait(lock);
+		while (this->clients != 0) this->exit_sig.wait(lock);
 
-		/* This must all wait until the Destroy function is called. */
+		/* This must all wait until the last client released us. */
 
 		this->packets.clear();
 		this->current.reset();
 	}
 
 	/**
-	 * Begin the destruction of this packet writer. It can happen in two ways:
-	 * in the first case the client disconnected while saving the map. In this
-	 * case the saving has not finished and killed this PacketWriter. In that
-	 * case we simply set cs to nullptr, triggering the appending to fail due to
-	 * the connection problem and eventually triggering the destructor. In the
-	 * second case the destructor is already called, and it is waiting for our
-	 * signal which we will send. Only then the packets will be removed by the
-	 * destructor.
+	 * Add a client which downloads this snapshot.
+	 * This must be done before the saving is started.
+	 */
+	void AddClient()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		this->clients++;
+	}
+
+	/**
+	 * Release this packet writer for a client, because it has received the whole map or disconnected.
+	 * When the last client releases this packet writer, its destruction begins. It can happen in two ways:
+	 * in the first case the saving has not finished yet, and it is aborted as writing fails due to there
+	 * being no clients left, eventually triggering the destructor. In the second case the destructor is
+	 * already called, and it is waiting for our signal which we will send. Only then the packets will be
+	 * removed by the destructor.
 	 */
-	void Destroy()
+	void Release()
 	{
 		std::unique_lock<std::mutex> lock(this->mutex);
 
-		this->cs = nullptr;
+		assert(this->clients > 0);
+		if (--this->clients != 0) return;
 
 		this->exit_sig.notify_all();
 		lock.unlock();
@@ -114,33 +126,34 @@ struct PacketWriter : SaveFilter {
 	}
 
 	/**
-	 * Checks whether there are packets.
-	 * It's not 100% threading safe, but this is only asked for when checking
-	 * whether there still is something to send. Then another call will be made
-	 * to actually get the Packet, which will be the only one popping packets
-	 * and thus eventually setting this on false.
+	 * Get a copy of the next packet to send to a client.
+	 * Once the whole savegame has been written, the size of the savegame is sent first, followed by the remaining packets.
+	 * @param[in,out] next_packet Index of the next packet to send to the client.
+	 * @param[in,out] size_sent Whether the size has been sent to the client.
+	 * @return The packet, or nullptr if the next packet has not been written yet.
 	 */
-	bool HasPackets()
+	std::unique_ptr<Packet> GetPacket(size_t &next_packet, bool &size_sent)
 	{
 		std::lock_guard<std::mutex> lock(this->mutex);
 
-		return !this->packets.empty();
-	}
+		if (this->finished && !size_sent) {
+			/* Fast-track the size to the client. */
+			size_sent = true;
+			std::unique_ptr<Packet> p(new Packet(PACKET_SERVER_MAP_SIZE));
+			p->Send_uint32((uint32)this->total_size);
+			return p;
+		}
 
-	/**
-	 * Pop a single created packet from the queue with packets.
-	 */
-	std::unique_ptr<Packet> PopPacket()
-	{
-		std::lock_guard<std::mutex> lock(this->mutex);
+		if (next_packet >= this->packets.size()) return nullptr;
 
-		if (this->packets.empty()) return nullptr;
-		std::unique_ptr<Packet> p = std::move(this->packets.front());
-		this->packets.pop_front();
+		const Packet *src = this->packets[next_packet++].get();
+		std::unique_ptr<Packet> p(new Packet(PACKET_SERVER_MAP_DATA));
+		memcpy(p->buffer, src->buffer, src->size);
+		p->size = src->size;
 		return p;
 	}
 
-	/** Append the current packet to the queue. */
+	/** Append the current packet to the packets. */
 	void AppendQueue()
 	{
 		if (this->current == nullptr) return;
@@ -148,17 +161,10 @@ struct PacketWriter : SaveFilter {
 		this->packets.push_back(std::move(this->current));
 	}
 
-	void PrependQueue(std::unique_ptr<Packet> p)
-	{
-		if (p == nullptr) return;
-
-		this->packets.push_front(std::move(p));
-	}
-
 	void Write(byte *buf, size_t size) override
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		/* We want to abort the saving when all sockets are closed. */
+		if (this->clients == 0) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
 		if (this->current == nullptr) this->current.reset(new Packet(PACKET_SERVER_MAP_DATA));
 
@@ -182,8 +188,8 @@ struct PacketWriter : SaveFilter {
 
 	void Finish() override
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		/* We want to abort the saving when all sockets are closed. */
+		if (this->clients == 0) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
 		std::lock_guard<std::mutex> lock(this->mutex);
 
@@ -194,10 +200,7 @@ struct PacketWriter : SaveFilter {
 		this->current.reset(new Packet(PACKET_SERVER_MAP_DONE));
 		this->AppendQueue();
 
-		/* Fast-track the size to the client. */
-		std::unique_ptr<Packet> p(new Packet(PACKET_SERVER_MAP_SIZE));
-		p->Send_uint32((uint32)this->total_size);
-		this->PrependQueue(std::move(p));
+		this->finished = true;
 	}
 };
 
@@ -230,7 +233,7 @@ ServerNetworkGameSocketHandler::~ServerNetworkGameSocketHandler()
 	OrderBackup::ResetUser(this->client_id);
 
 	if (this->savegame != nullptr) {
-		this->savegame->Destroy();
+		this->savegame->Release();
 		this->savegame = nullptr;
 	}
 }
@@ -289,9 +292,14 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::CloseConnection(NetworkRecvSta
 
 	this->SendPackets(true);
 
+	bool was_downloading_map = (this->status == STATUS_MAP);
+
 	delete this->GetInfo();
 	delete this;
 
+	/* Let the waiting clients download the map, when this was the last client downloading it. */
+	if (was_downloading_map) ServerNetworkGameSocketHandler::CheckNextClientToSendMap();
+
 	return status;
 }
 
@@ -586,42 +594,83 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWait()
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/**
+ * Start sending the map to the clients which are waiting for it, if no client is downloading the map at the moment.
+ * The first client in the queue starts the download, which takes all other waiting clients along.
+ */
+/* static */ void ServerNetworkGameSocketHandler::CheckNextClientToSendMap()
+{
+	NetworkClientSocket *best = nullptr;
+	for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
+		/* Someone is still downloading the map, the waiting clients get the next snapshot. */
+		if (new_cs->status == STATUS_MAP) return;
+
+		if (new_cs->status == STATUS_MAP_WAIT) {
+			if (best == nullptr || best->GetInfo()->join_date > new_cs->GetInfo()->join_date || (best->GetInfo()->join_date == new_cs->GetInfo()->join_date && best->client_id > new_cs->client_id)) {
+				best = new_cs;
+			}
+		}
+	}
+
+	/* Is there someone else to join? */
+	if (best != nullptr) {
+		best->status = STATUS_AUTHORIZED;
+		best->SendMap();
+	}
+}
+
+/**
+ * Start downloading a snapshot of the map.
+ * The client is sent the frame of the snapshot, and the commands which are queued for execution after that frame.
+ * @param writer The packet writer of the snapshot.
+ */
+void ServerNetworkGameSocketHandler::BeginMapDownload(PacketWriter *writer)
+{
+	this->savegame = writer;
+	this->savegame->AddClient();
+	this->savegame_next_packet = 0;
+	this->savegame_size_sent = false;
+	this->savegame_packets_per_send = 4; // We start with trying 4 packets
+
+	/* Now send the _frame_counter and how many packets are coming */
+	Packet *p = new Packet(PACKET_SERVER_MAP_BEGIN);
+	p->Send_uint32(_frame_counter);
+	this->SendPacket(p);
+
+	NetworkSyncCommandQueue(this);
+	this->status = STATUS_MAP;
+	/* Mark the start of download */
+	this->last_frame = _frame_counter;
+	this->last_frame_server = _frame_counter;
+}
+
 /** This sends the map to the client */
 NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 {
-	static uint sent_packets; // How many packets we did send successfully last time
-
 	if (this->status < STATUS_AUTHORIZED) {
 		/* Illegal call, return error and ignore the packet */
 		return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
 	}
 
 	if (this->status == STATUS_AUTHORIZED) {
-		this->savegame = new PacketWriter(this);
-
-		/* Now send the _frame_counter and how many packets are coming */
-		Packet *p = new Packet(PACKET_SERVER_MAP_BEGIN);
-		p->Send_uint32(_frame_counter);
-		this->SendPacket(p);
-
-		NetworkSyncCommandQueue(this);
-		this->status = STATUS_MAP;
-		/* Mark the start of download */
-		this->last_frame = _frame_counter;
-		this->last_frame_server = _frame_counter;
+		PacketWriter *writer = new PacketWriter();
 
-		sent_packets = 4; // We start with trying 4 packets
+		/* Take a single snapshot for this client and all clients which are waiting for the map at this moment. */
+		this->BeginMapDownload(writer);
+		for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
+			if (new_cs->status == STATUS_MAP_WAIT) new_cs->BeginMapDownload(writer);
+		}
 
 		/* Make a dump of the current game */
-		if (SaveWithFilter(this->savegame, true) != SL_OK) usererror("network savedump failed");
+		if (SaveWithFilter(writer, true) != SL_OK) usererror("network savedump failed");
 	}
 
 	if (this->status == STATUS_MAP) {
 		bool last_packet = false;
 		bool has_packets = true;
 
-		for (uint i = 0; i < sent_packets; i++) {
-			std::unique_ptr<Packet> p = this->savegame->PopPacket();
+		for (uint i = 0; i < this->savegame_packets_per_send; i++) {
+			std::unique_ptr<Packet> p = this->savegame->GetPacket(this->savegame_next_packet, this->savegame_size_sent);
 			if (p == nullptr) {
 				has_packets = false;
 				break;
@@ -638,34 +687,15 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 
 		if (last_packet) {
 			/* Done reading, make sure saving is done as well */
-			this->savegame->Destroy();
+			this->savegame->Release();
 			this->savegame = nullptr;
 
 			/* Set the status to DONE_MAP, no we will wait for the client
 			 *  to send it is ready (maybe that happens like never ;)) */
 			this->status = STATUS_DONE_MAP;
 
-			/* Find the best candidate for joining, i.e. the first joiner. */
-			NetworkClientSocket *best = nullptr;
-			for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
-				if (new_cs->status == STATUS_MAP_WAIT) {
-					if (best == nullptr || best->GetInfo()->join_date > new_cs->GetInfo()->join_date || (best->GetInfo()->join_date == new_cs->GetInfo()->join_date && best->client_id > new_cs->client_id)) {
-						best = new_cs;
-					}
-				}
-			}
-
-			/* Is there someone else to join? */
-			if (best != nullptr) {
-				/* Let the first start joining. */
-				best->status = STATUS_AUTHORIZED;
-				best->SendMap();
-
-				/* And update the rest. */
-				for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
-					if (new_cs->status == STATUS_MAP_WAIT) new_cs->SendWait();
-				}
-			}
+			/* Let the clients which are waiting for the map start, when no one else is downloading the map anymore. */
+			CheckNextClientToSendMap();
 		}
 
 		switch (this->SendPackets()) {
@@ -673,8 +703,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 				return NETWORK_RECV_STATUS_CONN_LOST;
 
 			case SPS_ALL_SENT:
-				/* All are sent, increase the sent_packets */
-				if (has_packets) sent_packets *= 2;
+				/* All are sent, increase the packets per send */
+				if (has_packets) this->savegame_packets_per_send *= 2;
 				break;
 
 			case SPS_PARTLY_SENT:
@@ -682,8 +712,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 				break;
 
 			case SPS_NONE_SENT:
-				/* Not everything is sent, decrease the sent_packets */
-				if (sent_packets > 1) sent_packets /= 2;
+				/* Not everything is sent, decrease the packets per send */
+				if (this->savegame_packets_per_send > 1) this->savegame_packets_per_send /= 2;
 				break;
 		}
 	}
@@ -77,7 +77,10 @@ public:
 	uint32 settings_hash_bits;   ///< Settings password hash entropy bits
 	bool settings_authed = false;///< Authorised to control all game settings
 
-	struct PacketWriter *savegame; ///< Writer used to write the savegame.
+	struct PacketWriter *savegame; ///< Writer used to write the savegame, shared by all clients downloading the same snapshot.
+	size_t savegame_next_packet;   ///< Index of the next savegame packet to send.
+	bool savegame_size_sent;       ///< Whether the savegame size has been sent.
+	uint savegame_packets_per_send; ///< How many savegame packets to try sending at once.
 	NetworkAddress client_address; ///< IP-address of the client (so he can be banned)
 
 	std::string desync_log;
@@ -89,7 +92,9 @@ public:
 	NetworkRecvStatus CloseConnection(NetworkRecvStatus status) override;
 	void GetClientName(char *client_name, const char *last) const;
 
+	void BeginMapDownload(struct PacketWriter *writer);
 	NetworkRecvStatus SendMap();
+	static void CheckNextClientToSendMap();
 	NetworkRecvStatus SendErrorQuit(ClientID client_id, NetworkErrorCode errorno);
 	NetworkRecvStatus SendQuit(ClientID client_id);
 	NetworkRecvStatus SendShutdown();
@@ -126,6 +126,7 @@ struct AnimationBase {
 			default:
 				SetAnimationFrame(tile, callback);
 				AddAnimatedTile(tile);
+				InvalidateLandscapeSpriteCacheTile(tile);
 				break;
 		}
 
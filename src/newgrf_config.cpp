@@ -26,13 +26,8 @@
 #include "fileio_func.h"
 #include "fios.h"
 
-#include "thread.h"
-#include <mutex>
-#include <condition_variable>
-#if defined(__MINGW32__)
-#include "3rdparty/mingw-std-threads/mingw.mutex.h"
-#include "3rdparty/mingw-std-threads/mingw.condition_variable.h"
-#endif
+#include "worker_thread.h"
+#include <deque>
 
 #include "safeguards.h"
 
@@ -338,13 +333,8 @@ struct GRFMD5SumState {
 	FILE *f;
 };
 
-static uint _grf_md5_parallel = 0;
-static uint _grf_md5_threads = 0;
-static std::mutex _grf_md5_lock;
-static std::vector<GRFMD5SumState> _grf_md5_pending;
-static std::condition_variable _grf_md5_full_cv;
-static std::condition_variable _grf_md5_empty_cv;
-static std::condition_variable _grf_md5_done_cv;
+static bool _grf_md5_parallel = false;
+static std::deque<std::shared_ptr<WorkerTask>> _grf_md5_tasks;
 static const uint GRF_MD5_PENDING_MAX = 8;
 
 static void CalcGRFMD5SumFromState(const GRFMD5SumState &state)
@@ -362,42 +352,25 @@ static void CalcGRFMD5SumFromState(const GRFMD5SumState &state)
 	FioFCloseFile(state.f);
 }
 
-void CalcGRFMD5Thread()
+static void CalcGRFMD5Task(void *data, void *, void *)
 {
-	std::unique_lock<std::mutex> lk(_grf_md5_lock);
-	while (_grf_md5_parallel > 0 || !_grf_md5_pending.empty()) {
-		if (_grf_md5_pending.empty()) {
-			_grf_md5_empty_cv.wait(lk);
-		} else {
-			const bool full = _grf_md5_pending.size() == GRF_MD5_PENDING_MAX;
-			GRFMD5SumState state = _grf_md5_pending.back();
-			_grf_md5_pending.pop_back();
-			lk.unlock();
-			if (full) _grf_md5_full_cv.notify_one();
-			CalcGRFMD5SumFromState(state);
-			lk.lock();
-		}
-	}
-	_grf_md5_threads--;
-	if (_grf_md5_threads == 0) {
-		_grf_md5_done_cv.notify_all();
-	}
+	GRFMD5SumState *state = static_cast<GRFMD5SumState *>(data);
+	CalcGRFMD5SumFromState(*state);
+	delete state;
 }
 
 void CalcGRFMD5ThreadingStart()
 {
-	_grf_md5_parallel = std::thread::hardware_concurrency();
-	if (_grf_md5_parallel <= 1) _grf_md5_parallel = 0;
+	_grf_md5_parallel = (_general_worker_pool.GetThreadCount() > 0);
 }
 
 void CalcGRFMD5ThreadingEnd()
 {
-	if (_grf_md5_parallel) {
-		std::unique_lock<std::mutex> lk(_grf_md5_lock);
-		_grf_md5_parallel = 0;
-		_grf_md5_empty_cv.notify_all();
-		_grf_md5_done_cv.wait(lk, []() { return _grf_md5_threads == 0; });
+	for (const std::shared_ptr<WorkerTask> &task : _grf_md5_tasks) {
+		task->Wait();
 	}
+	_grf_md5_tasks.clear();
+	_grf_md5_parallel = false;
 }
 
 /**
@@ -424,28 +397,20 @@ static bool CalcGRFMD5Sum(GRFConfig *config, Subdirectory subdir)
 
 	/* calculate md5sum */
 	GRFMD5SumState state { config, size, f };
-	if (_grf_md5_parallel == 0) {
+	if (!_grf_md5_parallel) {
 		CalcGRFMD5SumFromState(state);
 		return true;
 	}
 
-	std::unique_lock<std::mutex> lk(_grf_md5_lock);
-	if (_grf_md5_pending.size() >= GRF_MD5_PENDING_MAX) {
-		_grf_md5_full_cv.wait(lk);
+	/* Limit the number of open files of pending checksum calculations. */
+	while (!_grf_md5_tasks.empty() && _grf_md5_tasks.front()->IsDone()) {
+		_grf_md5_tasks.pop_front();
 	}
-	_grf_md5_pending.push_back(state);
-	bool notify_reader = (_grf_md5_pending.size() == 1); // queue was empty
-	if ((_grf_md5_threads == 0) || ((_grf_md5_pending.size() > 1) && (_grf_md5_threads < _grf_md5_parallel))) {
-		_grf_md5_threads++;
-		if (!StartNewThread(nullptr, "ottd:grf-md5", &CalcGRFMD5Thread)) {
-			_grf_md5_parallel = 0;
-			lk.unlock();
-			CalcGRFMD5Thread();
-			return true;
-		}
+	if (_grf_md5_tasks.size() >= GRF_MD5_PENDING_MAX) {
+		_grf_md5_tasks.front()->Wait();
+		_grf_md5_tasks.pop_front();
 	}
-	lk.unlock();
-	if (notify_reader) _grf_md5_empty_cv.notify_one();
+	_grf_md5_tasks.push_back(_general_worker_pool.EnqueueTask(WTC_GRF_MD5, &CalcGRFMD5Task, new GRFMD5SumState(state)));
 	return true;
 }
 
@@ -77,9 +77,12 @@
 #include "industry.h"
 #include "cargopacket.h"
 #include "core/checksum_func.hpp"
+#include "worker_thread.h"
 
 #include "linkgraph/linkgraphschedule.h"
 #include "tracerestrict.h"
+#include "pathfinder/water_regions.h"
+#include "pathfinder/yapf/yapf.h"
 
 #include <stdarg.h>
 #include <system_error>
@@ -409,6 +412,7 @@ static void ShutdownGame()
 	free(_config_file);
 
 	LinkGraphSchedule::Clear();
+	_general_worker_pool.Stop();
 	ClearTraceRestrictMapping();
 	ClearBridgeSimulatedSignalMapping();
 	ClearCargoPacketDeferredPayments();
@@ -849,6 +853,8 @@ int openttd_main(int argc, char *argv[])
 
 	LoadFromConfig(true);
 
+	StartGeneralWorkerPool();
+
 	if (resolution.width != 0) _cur_resolution = resolution;
 
 	/*
@@ -1630,6 +1636,7 @@ void CheckCaches(bool force_check, std::function<void(const char *)> log)
 
 	/* Check whether the caches are still valid */
 	for (Vehicle *v : Vehicle::Iterate()) {
+		v->cargo.ApplyPendingAging();
 		byte buff[sizeof(VehicleCargoList)];
 		memcpy(buff, &v->cargo, sizeof(VehicleCargoList));
 		v->cargo.InvalidateCache();
@@ -1662,6 +1669,9 @@ void CheckCaches(bool force_check, std::function<void(const char *)> log)
 		}
 	}
 
+	CheckWaterRegions([&](const char *msg) CCLOG("%s", msg));
+	YapfCheckRoadSegmentCaches([&](const char *msg) CCLOG("%s", msg));
+
 	for (OrderList *order_list : OrderList::Iterate()) {
 		order_list->DebugCheckSanity();
 	}
@@ -1867,6 +1877,8 @@ void GameLoop()
 		_switch_mode = SM_NONE;
 	}
 
+	ApplyPendingGeneralWorkerPoolRestart();
+
 	IncreaseSpriteLRU();
 	InteractiveRandom();
 
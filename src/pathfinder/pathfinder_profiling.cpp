@@ -0,0 +1,306 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pathfinder_profiling.cpp Profiling of pathfinder calls. */
+
+#include "../stdafx.h"
+#include "pathfinder_profiling.h"
+#include "../date_func.h"
+#include "../fileio_func.h"
+#include "../string_func.h"
+#include "../console_func.h"
+#include "../vehicle_base.h"
+#include "../train.h"
+#include "../roadveh.h"
+#include "../ship.h"
+#include "../rail_map.h"
+#include "../road_map.h"
+#include "follow_track.hpp"
+#include "yapf/yapf.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <time.h>
+
+#include "../safeguards.h"
+
+PathfinderProfiler _pathfinder_profiler;
+PathfinderProfileScope *PathfinderProfileScope::current = nullptr;
+
+/** Get the current time in microseconds, for measuring the duration of a call. */
+static inline uint32 GetProfileTimeMicroseconds()
+{
+	using namespace std::chrono;
+	return (uint32)time_point_cast<microseconds>(high_resolution_clock::now()).time_since_epoch().count();
+}
+
+/**
+ * Begin recording a pathfinder call, if the profiler is active.
+ * @param site Where the pathfinder is called from.
+ * @param v The vehicle the path is searched for.
+ * @param tile The tile the search starts from.
+ */
+PathfinderProfileScope::PathfinderProfileScope(PathfinderCallSite site, const Vehicle *v, TileIndex tile) : outer(nullptr), active(_pathfinder_profiler.active)
+{
+	if (!this->active) return;
+
+	this->call.vehicle = v->index;
+	this->call.tile = tile;
+	this->call.searches = 0;
+	this->call.nodes = 0;
+	this->call.cache_hits = 0;
+	this->call.tick = (uint32)(_scaled_date_ticks - _pathfinder_profiler.start_ticks);
+	this->call.site = site;
+	this->call.depth = 0;
+	this->call.result = false;
+
+	this->outer = PathfinderProfileScope::current;
+	for (const PathfinderProfileScope *s = this->outer; s != nullptr; s = s->outer) this->call.depth++;
+	PathfinderProfileScope::current = this;
+
+	this->call.time = GetProfileTimeMicroseconds();
+}
+
+/**
+ * Complete the recording of a pathfinder call.
+ */
+PathfinderProfileScope::~PathfinderProfileScope()
+{
+	if (!this->active) return;
+
+	this->call.time = GetProfileTimeMicroseconds() - this->call.time;
+	PathfinderProfileScope::current = this->outer;
+	_pathfinder_profiler.calls.push_back(this->call);
+}
+
+void PathfinderProfiler::Start()
+{
+	this->Abort();
+	this->active = true;
+	this->start_ticks = _scaled_date_ticks;
+}
+
+uint32 PathfinderProfiler::Finish()
+{
+	if (!this->active) return 0;
+
+	if (this->calls.empty()) {
+		IConsolePrintF(CC_DEBUG, "Finished pathfinder profile, no calls collected, not writing a file");
+		this->Abort();
+		return 0;
+	}
+
+	this->PrintSummary(10);
+
+	std::string filename = this->GetOutputFilename();
+	IConsolePrintF(CC_DEBUG, "Finished pathfinder profile, writing %u calls to %s", (uint)this->calls.size(), filename.c_str());
+
+	FILE *f = FioFOpenFile(filename.c_str(), "wt", Subdirectory::NO_DIRECTORY);
+	FileCloser fcloser(f);
+
+	uint32 total_microseconds = 0;
+
+	fputs("Tick,CallSite,Vehicle,TileX,TileY,Searches,Nodes,CacheHits,Microseconds,Depth,Result\n", f);
+	for (const Call &c : this->calls) {
+		fprintf(f, "%u,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", c.tick, GetCallSiteName(c.site), c.vehicle, TileX(c.tile), TileY(c.tile),
+				c.searches, c.nodes, c.cache_hits, c.time, c.depth, c.result ? 1 : 0);
+		if (c.depth == 0) total_microseconds += c.time;
+	}
+
+	this->Abort();
+
+	return total_microseconds;
+}
+
+void PathfinderProfiler::Abort()
+{
+	this->active = false;
+	this->end_date = MAX_DAY;
+	this->calls.clear();
+}
+
+/**
+ * Print the statistics of the collected calls per call site, and the vehicles which spent the most time in the pathfinders.
+ * @param top_vehicles Number of vehicles to list.
+ */
+void PathfinderProfiler::PrintSummary(uint top_vehicles) const
+{
+	struct Totals {
+		uint32 calls = 0;
+		uint32 found = 0;
+		uint64 nodes = 0;
+		uint64 cache_hits = 0;
+		uint64 time = 0;
+		uint32 max_time = 0;
+	};
+
+	Totals sites[PFCS_END];
+	std::map<uint32, Totals> vehicles;
+	for (const Call &c : this->calls) {
+		/* Nested calls are already included in the time of the enclosing call. */
+		uint32 time = c.depth == 0 ? c.time : 0;
+		for (Totals *t : { &sites[c.site], &vehicles[c.vehicle] }) {
+			t->calls++;
+			if (c.result) t->found++;
+			t->nodes += c.nodes;
+			t->cache_hits += c.cache_hits;
+			t->time += time;
+			t->max_time = max(t->max_time, c.time);
+		}
+	}
+
+	IConsolePrintF(CC_INFO, "Pathfinder calls over " OTTD_PRINTF64 " ticks:", _scaled_date_ticks - this->start_ticks);
+	for (uint i = 0; i < PFCS_END; i++) {
+		const Totals &t = sites[i];
+		if (t.calls == 0) continue;
+		IConsolePrintF(CC_INFO, "  %-22s %7u calls, %3u%% found, %6u nodes/call, %3u%% cache hits, %8u us total, %6u us max",
+				GetCallSiteName((PathfinderCallSite)i), t.calls, t.found * 100 / t.calls, (uint)(t.nodes / t.calls),
+				t.nodes == 0 ? 0 : (uint)(t.cache_hits * 100 / t.nodes), (uint)t.time, t.max_time);
+	}
+
+	std::vector<std::pair<uint32, const Totals *>> sorted;
+	for (const auto &it : vehicles) sorted.emplace_back(it.first, &it.second);
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair<uint32, const Totals *> &a, const std::pair<uint32, const Totals *> &b) {
+		return a.second->time > b.second->time;
+	});
+	if (sorted.size() > top_vehicles) sorted.resize(top_vehicles);
+
+	if (!sorted.empty()) IConsolePrintF(CC_INFO, "Vehicles with the most pathfinder time:");
+	for (const auto &it : sorted) {
+		const Vehicle *v = Vehicle::GetIfValid(it.first);
+		char name[64] = "(deleted)";
+		if (v != nullptr) seprintf(name, lastof(name), "unit %u of company %u", v->unitnumber, v->owner + 1);
+		IConsolePrintF(CC_INFO, "  vehicle %6u %-24s %7u calls, %8u nodes, %8u us total", it.first, name, it.second->calls, (uint)it.second->nodes, (uint)it.second->time);
+	}
+}
+
+/**
+ * Get name of the file that will be written.
+ * @return File name of profiling output file.
+ */
+std::string PathfinderProfiler::GetOutputFilename() const
+{
+	time_t write_time = time(nullptr);
+
+	char timestamp[16] = {};
+	strftime(timestamp, lengthof(timestamp), "%Y%m%d-%H%M", localtime(&write_time));
+
+	char filepath[MAX_PATH] = {};
+	seprintf(filepath, lastof(filepath), "%spfprofile-%s.csv", FiosGetScreenshotDir(), timestamp);
+
+	return std::string(filepath);
+}
+
+/**
+ * Get the name of a call site, as used in the output.
+ * @param site The call site.
+ * @return The name.
+ */
+/* static */ const char *PathfinderProfiler::GetCallSiteName(PathfinderCallSite site)
+{
+	static const char * const names[] = {
+		"train_choose_track",
+		"train_find_depot",
+		"train_find_safe_tile",
+		"train_check_reverse",
+		"road_choose_track",
+		"road_find_depot",
+		"ship_choose_track",
+		"ship_check_reverse",
+	};
+	static_assert(lengthof(names) == PFCS_END, "names must match PathfinderCallSite");
+	return site < PFCS_END ? names[site] : "unknown";
+}
+
+/**
+ * Follow the track of a vehicle to the next tile, where its controller would choose a track.
+ * @param v The vehicle.
+ * @param ft The track follower, which holds the next tile, the enter direction and the trackdirs on success.
+ * @return Whether the vehicle can leave its tile towards another one.
+ */
+template <class Tfollow, class Tvehicle>
+static bool FollowBenchmarkVehicle(const Tvehicle *v, Tfollow &ft)
+{
+	Trackdir td = v->GetVehicleTrackdir();
+	if (td == INVALID_TRACKDIR) return false;
+	TrackStatus ts = GetTileTrackStatus(v->tile, Tfollow::TT(), Tfollow::IsRoadTT() ? (ft.IsTram() ? RTT_TRAM : RTT_ROAD) : 0);
+	if ((TrackStatusToTrackdirBits(ts) & TrackdirToTrackdirBits(td)) == 0) return false;
+	return ft.Follow(v->tile, td);
+}
+
+/**
+ * Run pathfinder queries built from the current state of all vehicles of the loaded game, and show how long they took.
+ * These are the track choices of all vehicles on the tile ahead of them, which neither reserve track nor keep the
+ * found path, the depot searches of trains and road vehicles, and the reverse checks of trains and ships.
+ * The queries do not change the vehicles, but they fill the global segment cost caches and the rail destination trees.
+ * The first iteration fills these caches, so it is shown separately.
+ * @param iterations Number of times to run all queries.
+ */
+void PathfinderRunBenchmark(uint iterations)
+{
+	if (_pathfinder_profiler.active) {
+		IConsolePrintF(CC_WARNING, "Pathfinder profiling is active, stop it before running the benchmark.");
+		return;
+	}
+
+	_pathfinder_profiler.Start();
+
+	uint32 first_time = 0;
+	uint32 min_time = UINT32_MAX;
+	uint64 total_time = 0;
+	bool path_found;
+	RoadVehPathCache road_path_cache;
+	ShipPathCache ship_path_cache;
+	for (uint i = 0; i < iterations; i++) {
+		uint32 start = GetProfileTimeMicroseconds();
+
+		for (const Train *v : Train::Iterate()) {
+			if (!v->IsFrontEngine() || v->IsVirtual() || (v->vehstatus & VS_CRASHED) || v->track == TRACK_BIT_DEPOT || v->track == TRACK_BIT_NONE) continue;
+			CFollowTrackRail ft(v);
+			if (FollowBenchmarkVehicle(v, ft)) {
+				YapfTrainChooseTrack(v, ft.m_new_tile, ft.m_exitdir, TrackdirBitsToTrackBits(ft.m_new_td_bits), path_found, false, nullptr);
+			}
+			if (!IsRailDepotTile(v->tile)) YapfTrainFindNearestDepot(v, 0);
+			YapfTrainCheckReverse(v);
+		}
+		for (const RoadVehicle *v : RoadVehicle::Iterate()) {
+			if (!v->IsFrontEngine() || (v->vehstatus & VS_CRASHED) || IsRoadDepotTile(v->tile)) continue;
+			CFollowTrackRoad ft(v);
+			if (FollowBenchmarkVehicle(v, ft)) {
+				road_path_cache.clear();
+				YapfRoadVehicleChooseTrack(v, ft.m_new_tile, ft.m_exitdir, ft.m_new_td_bits, path_found, road_path_cache);
+			}
+			YapfRoadVehicleFindNearestDepot(v, 0);
+		}
+		for (const Ship *v : Ship::Iterate()) {
+			if (v->vehstatus & VS_CRASHED) continue;
+			CFollowTrackWater ft(v);
+			if (!v->IsInDepot() && FollowBenchmarkVehicle(v, ft)) {
+				ship_path_cache.clear();
+				YapfShipChooseTrack(v, ft.m_new_tile, ft.m_exitdir, TrackdirBitsToTrackBits(ft.m_new_td_bits), path_found, ship_path_cache);
+			}
+			YapfShipCheckReverse(v);
+		}
+
+		uint32 time = GetProfileTimeMicroseconds() - start;
+		if (i == 0) {
+			first_time = time;
+		} else {
+			min_time = min(min_time, time);
+			total_time += time;
+		}
+	}
+
+	IConsolePrintF(CC_INFO, "Pathfinder benchmark, %u queries per iteration:", (uint)(_pathfinder_profiler.calls.size() / iterations));
+	IConsolePrintF(CC_INFO, "  first iteration: %u us", first_time);
+	if (iterations > 1) {
+		IConsolePrintF(CC_INFO, "  other iterations: %u us min, %u us average", min_time, (uint)(total_time / (iterations - 1)));
+	}
+	_pathfinder_profiler.PrintSummary(0);
+	_pathfinder_profiler.Abort();
+}
@@ -0,0 +1,101 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pathfinder_profiling.h Profiling of pathfinder calls. */
+
+#ifndef PATHFINDER_PROFILING_H
+#define PATHFINDER_PROFILING_H
+
+#include "../date_type.h"
+#include "../tile_type.h"
+#include "../vehicle_type.h"
+
+#include <string>
+#include <vector>
+
+/** The places from which the pathfinders are called. */
+enum PathfinderCallSite : byte {
+	PFCS_TRAIN_CHOOSE_TRACK,   ///< YapfTrainChooseTrack()
+	PFCS_TRAIN_FIND_DEPOT,     ///< YapfTrainFindNearestDepot()
+	PFCS_TRAIN_FIND_SAFE_TILE, ///< YapfTrainFindNearestSafeTile()
+	PFCS_TRAIN_CHECK_REVERSE,  ///< YapfTrainCheckReverse()
+	PFCS_ROAD_CHOOSE_TRACK,    ///< YapfRoadVehicleChooseTrack()
+	PFCS_ROAD_FIND_DEPOT,      ///< YapfRoadVehicleFindNearestDepot()
+	PFCS_SHIP_CHOOSE_TRACK,    ///< YapfShipChooseTrack()
+	PFCS_SHIP_CHECK_REVERSE,   ///< YapfShipCheckReverse()
+	PFCS_END,
+};
+
+/**
+ * Profiler of the pathfinder calls of all vehicles.
+ */
+struct PathfinderProfiler {
+	/** Measurement of a single pathfinder call */
+	struct Call {
+		uint32 vehicle;          ///< Index of the vehicle
+		TileIndex tile;          ///< Tile the search started from
+		uint32 searches;         ///< Number of path searches run by the call
+		uint32 nodes;            ///< Number of nodes created by the searches
+		uint32 cache_hits;       ///< Number of node costs taken from the segment cost cache
+		uint32 time;             ///< Time taken by the call (microseconds)
+		uint32 tick;             ///< Scaled game ticks since the profiler was started
+		PathfinderCallSite site; ///< Call site
+		byte depth;              ///< Number of enclosing pathfinder calls
+		bool result;             ///< Whether a path, depot or safe tile was found, or whether to reverse
+	};
+
+	bool active;             ///< Is the profiler collecting data
+	DateTicksScaled start_ticks; ///< Scaled date ticks the profiler was started on
+	Date end_date;           ///< Game date to stop profiling on
+	std::vector<Call> calls; ///< All calls collected so far
+
+	PathfinderProfiler() : active(false), start_ticks(0), end_date(MAX_DAY) {}
+
+	void Start();
+	uint32 Finish();
+	void Abort();
+	void PrintSummary(uint top_vehicles) const;
+	std::string GetOutputFilename() const;
+
+	static const char *GetCallSiteName(PathfinderCallSite site);
+};
+
+/**
+ * Records a pathfinder call into the profiler while it is active.
+ * Create one on the stack for the duration of the call.
+ */
+class PathfinderProfileScope {
+	PathfinderProfiler::Call call;   ///< Data of the call in progress
+	PathfinderProfileScope *outer;   ///< Enclosing call, if any
+	bool active;                     ///< Is this call being recorded
+
+public:
+	PathfinderProfileScope(PathfinderCallSite site, const Vehicle *v, TileIndex tile);
+	~PathfinderProfileScope();
+
+	/** Set the result of the call. */
+	inline void SetResult(bool result)
+	{
+		this->call.result = result;
+	}
+
+	/** Add the statistics of a path search of the call. */
+	inline void AddSearch(uint nodes, uint cache_hits)
+	{
+		this->call.searches++;
+		this->call.nodes += nodes;
+		this->call.cache_hits += cache_hits;
+	}
+
+	static PathfinderProfileScope *current; ///< Innermost call being recorded, nullptr if none
+};
+
+extern PathfinderProfiler _pathfinder_profiler;
+
+void PathfinderRunBenchmark(uint iterations);
+
+#endif /* PATHFINDER_PROFILING_H */
@@ -0,0 +1,407 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.cpp Handles dividing the water in the map into square regions to assist pathfinding. */
+
+#include "../stdafx.h"
+#include "../map_func.h"
+#include "../landscape.h"
+#include "../ship.h"
+#include "../string_func.h"
+#include "../tunnelbridge_map.h"
+#include "follow_track.hpp"
+#include "water_regions.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "../safeguards.h"
+
+static const TWaterRegionPatchLabel FIRST_REGION_LABEL = 1; ///< Label of the first patch of a water region.
+
+static inline uint GetWaterRegionMapSizeX() { return MapSizeX() / WATER_REGION_EDGE_LENGTH; }
+static inline uint GetWaterRegionMapSizeY() { return MapSizeY() / WATER_REGION_EDGE_LENGTH; }
+
+static inline uint GetWaterRegionX(TileIndex tile) { return TileX(tile) / WATER_REGION_EDGE_LENGTH; }
+static inline uint GetWaterRegionY(TileIndex tile) { return TileY(tile) / WATER_REGION_EDGE_LENGTH; }
+
+static inline uint GetWaterRegionIndex(uint region_x, uint region_y) { return region_y * GetWaterRegionMapSizeX() + region_x; }
+static inline uint GetWaterRegionIndex(TileIndex tile) { return GetWaterRegionIndex(GetWaterRegionX(tile), GetWaterRegionY(tile)); }
+
+/** Index of a tile within the labels of its water region. */
+static inline uint GetLocalTileIndex(TileIndex tile)
+{
+	return (TileX(tile) % WATER_REGION_EDGE_LENGTH) + (TileY(tile) % WATER_REGION_EDGE_LENGTH) * WATER_REGION_EDGE_LENGTH;
+}
+
+static inline bool IsAqueductTile(TileIndex tile)
+{
+	return IsBridgeTile(tile) && GetTunnelBridgeTransportType(tile) == TRANSPORT_WATER;
+}
+
+/**
+ * Represents a square section of the map of a fixed size. Within this square individual unconnected patches of water are
+ * identified using a Connected Component Labeling (CCL) algorithm. Note that all information stored in this class applies
+ * only to tiles within the square section, there is no knowledge about the rest of the map. This makes it easy to invalidate
+ * and update a water region if any changes are made to it, such as construction or terraforming.
+ */
+class WaterRegion {
+private:
+	TWaterRegionTraversabilityBits edge_traversability_bits[DIAGDIR_END]; ///< Per edge, the tiles through which ships can leave the region.
+	bool has_cross_region_aqueducts;            ///< Whether an aqueduct leads from this region into another one.
+	bool initialized;                           ///< Whether the labels and traversability bits match the map.
+	TWaterRegionPatchLabel number_of_patches;   ///< 0 = no water, 1 = one single patch of water, etc...
+	std::unique_ptr<TWaterRegionPatchLabel[]> tile_patch_labels; ///< Label of each tile, \c nullptr when all tiles belong to the single patch, or there is no water.
+
+public:
+	WaterRegion() : has_cross_region_aqueducts(false), initialized(false), number_of_patches(0)
+	{
+		MemSetT(this->edge_traversability_bits, 0, DIAGDIR_END);
+	}
+
+	/**
+	 * Returns a set of bits indicating whether an edge tile on a particular side is traversable or not. These
+	 * values can be used to determine whether a ship can enter/leave the region through a particular edge tile.
+	 * @param side Which side of the region we want to know the edge traversability of.
+	 * @return A value holding the edge traversability bits.
+	 */
+	inline TWaterRegionTraversabilityBits GetEdgeTraversabilityBits(DiagDirection side) const { return this->edge_traversability_bits[side]; }
+
+	/** @return The amount of individual water patches present within the water region. */
+	inline int NumberOfPatches() const { return this->number_of_patches; }
+
+	/** @return Whether the water region contains aqueducts that cross the region boundaries. */
+	inline bool HasCrossRegionAqueducts() const { return this->has_cross_region_aqueducts; }
+
+	inline bool IsInitialized() const { return this->initialized; }
+
+	/** Mark the region as out of date; it is updated when it is next needed. */
+	inline void Invalidate() { this->initialized = false; }
+
+	/**
+	 * Returns the patch label that was assigned to the tile.
+	 * @param tile The tile of which we want to retrieve the label; it has to be within the region.
+	 * @return The label assigned to the tile.
+	 */
+	inline TWaterRegionPatchLabel GetLabel(TileIndex tile) const
+	{
+		if (this->number_of_patches == 0) return INVALID_WATER_REGION_PATCH;
+		if (this->tile_patch_labels == nullptr) return FIRST_REGION_LABEL;
+		return this->tile_patch_labels[GetLocalTileIndex(tile)];
+	}
+
+	/**
+	 * Performs the connected component labeling and other data gathering.
+	 * @param region_x The X coordinate of the region.
+	 * @param region_y The Y coordinate of the region.
+	 */
+	void ForceUpdate(uint region_x, uint region_y)
+	{
+		this->has_cross_region_aqueducts = false;
+		MemSetT(this->edge_traversability_bits, 0, DIAGDIR_END);
+
+		TWaterRegionPatchLabel labels[WATER_REGION_NUMBER_OF_TILES];
+		MemSetT(labels, INVALID_WATER_REGION_PATCH, WATER_REGION_NUMBER_OF_TILES);
+
+		const uint left = region_x * WATER_REGION_EDGE_LENGTH;
+		const uint top = region_y * WATER_REGION_EDGE_LENGTH;
+		const TileArea tile_area(TileXY(left, top), WATER_REGION_EDGE_LENGTH, WATER_REGION_EDGE_LENGTH);
+		auto contains_tile = [&](TileIndex tile) -> bool {
+			return TileX(tile) - left < WATER_REGION_EDGE_LENGTH && TileY(tile) - top < WATER_REGION_EDGE_LENGTH;
+		};
+
+		TWaterRegionPatchLabel current_label = FIRST_REGION_LABEL;
+		TWaterRegionPatchLabel highest_assigned_label = INVALID_WATER_REGION_PATCH;
+		uint labelled_tiles = 0;
+
+		/* Perform connected component labeling. This uses a flooding algorithm that expands until no
+		 * additional tiles can be added. Only tiles inside the water region are considered. */
+		std::vector<TileIndex> tiles_to_check;
+		TILE_AREA_LOOP(start_tile, tile_area) {
+			tiles_to_check.clear();
+			tiles_to_check.push_back(start_tile);
+			bool increase_label = false;
+			while (!tiles_to_check.empty()) {
+				const TileIndex tile = tiles_to_check.back();
+				tiles_to_check.pop_back();
+
+				const TrackdirBits valid_dirs = TrackStatusToTrackdirBits(GetTileTrackStatus(tile, TRANSPORT_WATER, 0));
+				if (valid_dirs == TRACKDIR_BIT_NONE) continue;
+
+				TWaterRegionPatchLabel &label = labels[GetLocalTileIndex(tile)];
+				if (label != INVALID_WATER_REGION_PATCH) continue;
+
+				label = current_label;
+				highest_assigned_label = current_label;
+				labelled_tiles++;
+				increase_label = true;
+
+				TrackdirBits dirs = valid_dirs;
+				while (dirs != TRACKDIR_BIT_NONE) {
+					const Trackdir dir = RemoveFirstTrackdir(&dirs);
+
+					/* By using a track follower we "play by the same rules" as the actual ship pathfinder. */
+					CFollowTrackWater ft;
+					if (!ft.Follow(tile, dir)) continue;
+
+					if (contains_tile(ft.m_new_tile)) {
+						tiles_to_check.push_back(ft.m_new_tile);
+					} else if (!ft.m_is_bridge) {
+						assert(DistanceManhattan(ft.m_new_tile, tile) == 1);
+						const DiagDirection side = DiagdirBetweenTiles(tile, ft.m_new_tile);
+						const uint local_x_or_y = DiagDirToAxis(side) == AXIS_X ? TileY(tile) - top : TileX(tile) - left;
+						SetBit(this->edge_traversability_bits[side], local_x_or_y);
+					} else {
+						this->has_cross_region_aqueducts = true;
+					}
+				}
+			}
+
+			/* In the unlikely case of running out of labels, the remaining patches are merged into the last one. */
+			if (increase_label && current_label < UINT8_MAX) current_label++;
+		}
+
+		this->number_of_patches = highest_assigned_label;
+		if (this->number_of_patches == 0 || (this->number_of_patches == 1 && labelled_tiles == WATER_REGION_NUMBER_OF_TILES)) {
+			this->tile_patch_labels.reset();
+		} else {
+			if (this->tile_patch_labels == nullptr) this->tile_patch_labels.reset(new TWaterRegionPatchLabel[WATER_REGION_NUMBER_OF_TILES]);
+			MemCpyT(this->tile_patch_labels.get(), labels, WATER_REGION_NUMBER_OF_TILES);
+		}
+		this->initialized = true;
+	}
+
+	/**
+	 * Check whether the region holds the same data as another one.
+	 * @param other The other region.
+	 * @param region_x The X coordinate of the regions.
+	 * @param region_y The Y coordinate of the regions.
+	 * @return True when the data of the regions is equal.
+	 */
+	bool IsEqual(const WaterRegion &other, uint region_x, uint region_y) const
+	{
+		if (this->number_of_patches != other.number_of_patches) return false;
+		if (this->has_cross_region_aqueducts != other.has_cross_region_aqueducts) return false;
+		if (MemCmpT(this->edge_traversability_bits, other.edge_traversability_bits, DIAGDIR_END) != 0) return false;
+
+		const TileArea tile_area(TileXY(region_x * WATER_REGION_EDGE_LENGTH, region_y * WATER_REGION_EDGE_LENGTH), WATER_REGION_EDGE_LENGTH, WATER_REGION_EDGE_LENGTH);
+		TILE_AREA_LOOP(tile, tile_area) {
+			if (this->GetLabel(tile) != other.GetLabel(tile)) return false;
+		}
+		return true;
+	}
+};
+
+static std::vector<WaterRegion> _water_regions; ///< The water regions of the map, updated when they are needed.
+
+/**
+ * Get a water region, updating it first when it is out of date.
+ * @param region_x The X coordinate of the region.
+ * @param region_y The Y coordinate of the region.
+ * @return The up to date water region.
+ */
+static WaterRegion &GetUpdatedWaterRegion(uint region_x, uint region_y)
+{
+	WaterRegion &result = _water_regions[GetWaterRegionIndex(region_x, region_y)];
+	if (!result.IsInitialized()) result.ForceUpdate(region_x, region_y);
+	return result;
+}
+
+static WaterRegion &GetUpdatedWaterRegion(TileIndex tile)
+{
+	return GetUpdatedWaterRegion(GetWaterRegionX(tile), GetWaterRegionY(tile));
+}
+
+/**
+ * Returns the tile at a position along an edge of a water region.
+ * @param region_x The X coordinate of the region.
+ * @param region_y The Y coordinate of the region.
+ * @param side The edge of the region.
+ * @param x_or_y The position along the edge.
+ * @return The tile.
+ */
+static TileIndex GetEdgeTileCoordinate(uint region_x, uint region_y, DiagDirection side, uint x_or_y)
+{
+	assert(x_or_y < WATER_REGION_EDGE_LENGTH);
+	const uint left = region_x * WATER_REGION_EDGE_LENGTH;
+	const uint top = region_y * WATER_REGION_EDGE_LENGTH;
+	switch (side) {
+		case DIAGDIR_NE: return TileXY(left, top + x_or_y);
+		case DIAGDIR_SW: return TileXY(left + WATER_REGION_EDGE_LENGTH - 1, top + x_or_y);
+		case DIAGDIR_NW: return TileXY(left + x_or_y, top);
+		case DIAGDIR_SE: return TileXY(left + x_or_y, top + WATER_REGION_EDGE_LENGTH - 1);
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Calculates a number that uniquely identifies the provided water region patch.
+ * @param water_region_patch The patch.
+ * @return The hash of the patch.
+ */
+int CalculateWaterRegionPatchHash(const WaterRegionPatchDesc &water_region_patch)
+{
+	return water_region_patch.label | GetWaterRegionIndex(water_region_patch.x, water_region_patch.y) << 8;
+}
+
+/**
+ * Returns the center tile of a particular water region.
+ * @param water_region The water region.
+ * @return The tile closest to the center of the region.
+ */
+TileIndex GetWaterRegionCenterTile(const WaterRegionDesc &water_region)
+{
+	return TileXY(water_region.x * WATER_REGION_EDGE_LENGTH + (WATER_REGION_EDGE_LENGTH / 2), water_region.y * WATER_REGION_EDGE_LENGTH + (WATER_REGION_EDGE_LENGTH / 2));
+}
+
+/**
+ * Returns basic water region information for the provided tile.
+ * @param tile The tile.
+ * @return The water region containing the tile.
+ */
+WaterRegionDesc GetWaterRegionInfo(TileIndex tile)
+{
+	return WaterRegionDesc{ (int)GetWaterRegionX(tile), (int)GetWaterRegionY(tile) };
+}
+
+/**
+ * Returns basic water region patch information for the provided tile.
+ * @param tile The tile.
+ * @return The water region patch containing the tile; its label is #INVALID_WATER_REGION_PATCH when the tile has no water tracks.
+ */
+WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile)
+{
+	const WaterRegion &region = GetUpdatedWaterRegion(tile);
+	return WaterRegionPatchDesc{ (int)GetWaterRegionX(tile), (int)GetWaterRegionY(tile), region.GetLabel(tile) };
+}
+
+/**
+ * Marks the water region that the tile is part of as out of date.
+ * The traversability of the edge of a region depends on the tiles just across it,
+ * so the regions of the neighbouring tiles are marked as out of date as well.
+ * This has to be called for every change of the water tracks of a tile.
+ * @param tile Tile within the water region that we wish to invalidate.
+ */
+void InvalidateWaterRegion(TileIndex tile)
+{
+	if (_water_regions.empty()) return;
+
+	const uint index = GetWaterRegionIndex(tile);
+	_water_regions[index].Invalidate();
+
+	for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+		const TileIndex neighbour = AddTileIndexDiffCWrap(tile, TileIndexDiffCByDiagDir(side));
+		if (neighbour == INVALID_TILE) continue;
+		const uint neighbour_index = GetWaterRegionIndex(neighbour);
+		if (neighbour_index != index) _water_regions[neighbour_index].Invalidate();
+	}
+}
+
+/**
+ * Calls the provided callback function for all water region patches
+ * accessible from one particular side of the starting patch.
+ * @param water_region_patch Water patch within the water region to start searching from.
+ * @param side Side of the water region to look for neighbouring patches of water.
+ * @param callback The function that will be called for each neighbour that is found.
+ */
+static inline void VisitAdjacentWaterRegionPatchNeighbors(const WaterRegionPatchDesc &water_region_patch, DiagDirection side, const TVisitWaterRegionPatchCallBack &callback)
+{
+	const TileIndexDiffC offset = TileIndexDiffCByDiagDir(side);
+	const int nx = water_region_patch.x + offset.x;
+	const int ny = water_region_patch.y + offset.y;
+
+	if (nx < 0 || ny < 0 || nx >= (int)GetWaterRegionMapSizeX() || ny >= (int)GetWaterRegionMapSizeY()) return;
+
+	const WaterRegion &current_region = GetUpdatedWaterRegion(water_region_patch.x, water_region_patch.y);
+	const WaterRegion &neighboring_region = GetUpdatedWaterRegion(nx, ny);
+	const DiagDirection opposite_side = ReverseDiagDir(side);
+
+	/* Indicates via which local x or y coordinates (depends on the "side" parameter) we can cross over into the adjacent region. */
+	const TWaterRegionTraversabilityBits traversability_bits = current_region.GetEdgeTraversabilityBits(side) & neighboring_region.GetEdgeTraversabilityBits(opposite_side);
+	if (traversability_bits == 0) return;
+
+	if (current_region.NumberOfPatches() == 1 && neighboring_region.NumberOfPatches() == 1) {
+		/* No further checks needed because we know there is just one patch for both adjacent regions. */
+		callback(WaterRegionPatchDesc{ nx, ny, FIRST_REGION_LABEL });
+		return;
+	}
+
+	/* Multiple water patches can be reached from the current patch. Check each edge tile individually. */
+	TWaterRegionPatchLabel unique_labels[WATER_REGION_EDGE_LENGTH];
+	uint unique_label_count = 0;
+	for (uint x_or_y = 0; x_or_y < WATER_REGION_EDGE_LENGTH; ++x_or_y) {
+		if (!HasBit(traversability_bits, x_or_y)) continue;
+
+		const TileIndex current_edge_tile = GetEdgeTileCoordinate(water_region_patch.x, water_region_patch.y, side, x_or_y);
+		if (current_region.GetLabel(current_edge_tile) != water_region_patch.label) continue;
+
+		const TileIndex neighbor_edge_tile = GetEdgeTileCoordinate(nx, ny, opposite_side, x_or_y);
+		const TWaterRegionPatchLabel neighbor_label = neighboring_region.GetLabel(neighbor_edge_tile);
+		if (std::find(unique_labels, unique_labels + unique_label_count, neighbor_label) == unique_labels + unique_label_count) {
+			unique_labels[unique_label_count++] = neighbor_label;
+		}
+	}
+	for (uint i = 0; i < unique_label_count; i++) callback(WaterRegionPatchDesc{ nx, ny, unique_labels[i] });
+}
+
+/**
+ * Calls the provided callback function on all accessible water region patches in
+ * each cardinal direction, plus any others that are reachable via aqueducts.
+ * @param water_region_patch Water patch within the water region to start searching from.
+ * @param callback The function that will be called for each accessible water patch that is found.
+ */
+void VisitWaterRegionPatchNeighbors(const WaterRegionPatchDesc &water_region_patch, const TVisitWaterRegionPatchCallBack &callback)
+{
+	const WaterRegion &current_region = GetUpdatedWaterRegion(water_region_patch.x, water_region_patch.y);
+
+	/* Visit adjacent water region patches in each cardinal direction. */
+	for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) VisitAdjacentWaterRegionPatchNeighbors(water_region_patch, side, callback);
+
+	/* Visit neighbouring water patches accessible via cross-region aqueducts. */
+	if (current_region.HasCrossRegionAqueducts()) {
+		const TileArea tile_area(TileXY(water_region_patch.x * WATER_REGION_EDGE_LENGTH, water_region_patch.y * WATER_REGION_EDGE_LENGTH), WATER_REGION_EDGE_LENGTH, WATER_REGION_EDGE_LENGTH);
+		TILE_AREA_LOOP(tile, tile_area) {
+			if (!IsAqueductTile(tile) || current_region.GetLabel(tile) != water_region_patch.label) continue;
+
+			const TileIndex other_end_tile = GetOtherBridgeEnd(tile);
+			if (GetWaterRegionIndex(tile) != GetWaterRegionIndex(other_end_tile)) callback(GetWaterRegionPatchInfo(other_end_tile));
+		}
+	}
+}
+
+/**
+ * Allocates the water regions of the map, all of which are out of date.
+ * Has to be called whenever the map is allocated.
+ */
+void AllocateWaterRegions()
+{
+	std::vector<WaterRegion>(GetWaterRegionMapSizeX() * GetWaterRegionMapSizeY()).swap(_water_regions);
+}
+
+/**
+ * Check the water regions which are up to date against the map.
+ * A mismatch means that a change of the map did not invalidate its water region.
+ * @param log Receives a message for every mismatching water region.
+ */
+void CheckWaterRegions(std::function<void(const char *)> log)
+{
+	char buffer[128];
+	for (uint y = 0; y < GetWaterRegionMapSizeY(); y++) {
+		for (uint x = 0; x < GetWaterRegionMapSizeX(); x++) {
+			const WaterRegion &region = _water_regions[GetWaterRegionIndex(x, y)];
+			if (!region.IsInitialized()) continue;
+
+			WaterRegion check;
+			check.ForceUpdate(x, y);
+			if (!region.IsEqual(check, x, y)) {
+				seprintf(buffer, lastof(buffer), "water region mismatch: region %u x %u (tile 0x%X)", x, y, TileXY(x * WATER_REGION_EDGE_LENGTH, y * WATER_REGION_EDGE_LENGTH));
+				log(buffer);
+			}
+		}
+	}
+}
@@ -0,0 +1,61 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.h Handles dividing the water in the map into square regions to assist pathfinding. */
+
+#ifndef WATER_REGIONS_H
+#define WATER_REGIONS_H
+
+#include "../tile_type.h"
+
+#include <functional>
+
+typedef uint8 TWaterRegionPatchLabel;          ///< Label of a patch of connected water tiles within a water region.
+typedef uint16 TWaterRegionTraversabilityBits; ///< Bitmask of the tiles along an edge of a water region through which ships can leave it.
+
+static const uint WATER_REGION_EDGE_LENGTH = 16; ///< Number of tiles along the edges of a water region.
+static const uint WATER_REGION_NUMBER_OF_TILES = WATER_REGION_EDGE_LENGTH * WATER_REGION_EDGE_LENGTH; ///< Number of tiles in a water region.
+static const TWaterRegionPatchLabel INVALID_WATER_REGION_PATCH = 0; ///< Label of the tiles without water tracks.
+
+/** Describes a single square water region. */
+struct WaterRegionDesc {
+	int x; ///< The X coordinate of the water region, i.e. X=2 is the 3rd water region along the X-axis.
+	int y; ///< The Y coordinate of the water region, i.e. Y=2 is the 3rd water region along the Y-axis.
+
+	inline bool operator==(const WaterRegionDesc &other) const { return this->x == other.x && this->y == other.y; }
+	inline bool operator!=(const WaterRegionDesc &other) const { return !(*this == other); }
+};
+
+/** Describes a single interconnected patch of water within a particular water region. */
+struct WaterRegionPatchDesc {
+	int x;                         ///< The X coordinate of the water region.
+	int y;                         ///< The Y coordinate of the water region.
+	TWaterRegionPatchLabel label;  ///< Unique label of the patch within its water region.
+
+	inline bool operator==(const WaterRegionPatchDesc &other) const { return this->x == other.x && this->y == other.y && this->label == other.label; }
+	inline bool operator!=(const WaterRegionPatchDesc &other) const { return !(*this == other); }
+};
+
+/** Callback for the water region patches which can be reached from another patch. */
+typedef std::function<void(const WaterRegionPatchDesc &)> TVisitWaterRegionPatchCallBack;
+
+int CalculateWaterRegionPatchHash(const WaterRegionPatchDesc &water_region_patch);
+
+TileIndex GetWaterRegionCenterTile(const WaterRegionDesc &water_region);
+
+WaterRegionDesc GetWaterRegionInfo(TileIndex tile);
+WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile);
+
+void InvalidateWaterRegion(TileIndex tile);
+
+void VisitWaterRegionPatchNeighbors(const WaterRegionPatchDesc &water_region_patch, const TVisitWaterRegionPatchCallBack &callback);
+
+void AllocateWaterRegions();
+
+void CheckWaterRegions(std::function<void(const char *)> log);
+
+#endif /* WATER_REGIONS_H */
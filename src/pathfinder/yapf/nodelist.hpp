@@ -10,42 +10,178 @@
 #ifndef NODELIST_HPP
 #define NODELIST_HPP
 
-#include "../../misc/array.hpp"
-#include "../../misc/hashtable.hpp"
-#include "../../misc/binaryheap.hpp"
+#include "../../core/alloc_func.hpp"
+#include "../../misc/str.hpp"
+#include "../../misc/openhashtable.hpp"
+#include "../../misc/daryheap.hpp"
+
+#include <memory>
+#include <new>
+#include <vector>
+
+/**
+ * Storage of the nodes of a search.
+ *  The nodes live in fixed size blocks, so they never move while the search
+ *  runs. Clearing the arena destroys the nodes but keeps the blocks, so the
+ *  next search doesn't have to allocate them again.
+ */
+template <class Titem_, uint Tblock_bits_ = 10>
+class CNodeArenaT {
+protected:
+	static const uint BLOCK_SIZE = 1 << Tblock_bits_; ///< number of items per block
+
+	std::vector<Titem_ *> m_blocks; ///< allocated blocks of items
+	uint m_num_items;               ///< number of constructed items
+
+public:
+	CNodeArenaT() : m_num_items(0) {}
+
+	~CNodeArenaT()
+	{
+		this->Clear();
+		this->Trim(0);
+	}
+
+	/** destroy all items, but keep their memory */
+	inline void Clear()
+	{
+		for (uint i = 0; i < m_num_items; i++) (*this)[i].~Titem_();
+		m_num_items = 0;
+	}
+
+	/** free the unused blocks beyond the given number of blocks */
+	inline void Trim(uint max_blocks)
+	{
+		uint used_blocks = CeilDiv(m_num_items, BLOCK_SIZE);
+		for (uint i = max(max_blocks, used_blocks); i < m_blocks.size(); i++) free(m_blocks[i]);
+		if (m_blocks.size() > max(max_blocks, used_blocks)) m_blocks.resize(max(max_blocks, used_blocks));
+	}
+
+	/** return number of items */
+	inline uint Length() const
+	{
+		return m_num_items;
+	}
+
+	/** allocate and construct new item */
+	inline Titem_ *AppendC()
+	{
+		uint block = m_num_items >> Tblock_bits_;
+		if (block == m_blocks.size()) m_blocks.push_back(MallocT<Titem_>(BLOCK_SIZE));
+		Titem_ *item = m_blocks[block] + (m_num_items & (BLOCK_SIZE - 1));
+		m_num_items++;
+		new (item) Titem_;
+		return item;
+	}
+
+	/** indexed access (non-const) */
+	inline Titem_& operator[](uint index)
+	{
+		return m_blocks[index >> Tblock_bits_][index & (BLOCK_SIZE - 1)];
+	}
+
+	/** indexed access (const) */
+	inline const Titem_& operator[](uint index) const
+	{
+		return m_blocks[index >> Tblock_bits_][index & (BLOCK_SIZE - 1)];
+	}
+
+	/** Helper for creating a human readable output of this data. */
+	template <typename D> void Dump(D &dmp) const
+	{
+		dmp.WriteLine("num_items = %d", m_num_items);
+		CStrA name;
+		for (uint i = 0; i < m_num_items; i++) {
+			name.Format("item[%d]", i);
+			dmp.WriteStructT(name.Data(), &(*this)[i]);
+		}
+	}
+};
 
 /**
  * Hash table based node list multi-container class.
  *  Implements open list, closed list and priority queue for A-star
  *  path finder.
+ *
+ *  The containers are taken from a per thread pool when the node list is
+ *  created, and cleared and given back to it when the node list is destroyed.
+ *  So a search reuses the memory of the previous searches, instead of
+ *  allocating and growing all its containers again.
  */
 template <class Titem_, int Thash_bits_open_, int Thash_bits_closed_>
 class CNodeList_HashTableT {
 public:
-	typedef Titem_ Titem;                                        ///< Make #Titem_ visible from outside of class.
-	typedef typename Titem_::Key Key;                            ///< Make Titem_::Key a property of this class.
-	typedef SmallArray<Titem_, 65536, 256> CItemArray;           ///< Type that we will use as item container.
-	typedef CHashTableT<Titem_, Thash_bits_open_  > COpenList;   ///< How pointers to open nodes will be stored.
-	typedef CHashTableT<Titem_, Thash_bits_closed_> CClosedList; ///< How pointers to closed nodes will be stored.
-	typedef CBinaryHeapT<Titem_> CPriorityQueue;                 ///< How the priority queue will be managed.
+	typedef Titem_ Titem;                           ///< Make #Titem_ visible from outside of class.
+	typedef typename Titem_::Key Key;               ///< Make Titem_::Key a property of this class.
+	typedef CNodeArenaT<Titem_> CItemArray;         ///< Type that we will use as item container.
+	typedef COpenHashTableT<Titem_> COpenList;      ///< How pointers to open nodes will be stored.
+	typedef COpenHashTableT<Titem_> CClosedList;    ///< How pointers to closed nodes will be stored.
+	typedef CDaryHeapT<Titem_> CPriorityQueue;      ///< How the priority queue will be managed.
 
 protected:
-	CItemArray      m_arr;        ///< Here we store full item data (Titem_).
-	COpenList       m_open;       ///< Hash table of pointers to open item data.
-	CClosedList     m_closed;     ///< Hash table of pointers to closed item data.
-	CPriorityQueue  m_open_queue; ///< Priority queue of pointers to open item data.
-	Titem          *m_new_node;   ///< New open node under construction.
+	static const uint MAX_POOLED_STORAGES = 4;      ///< Number of unused storages kept per thread, more are only needed by nested searches.
+	static const uint MAX_POOLED_ARENA_BLOCKS = 32; ///< Number of arena blocks kept by an unused storage.
+
+	/** All containers of a node list. */
+	struct Storage {
+		CItemArray     m_arr;
+		COpenList      m_open;
+		CClosedList    m_closed;
+		CPriorityQueue m_open_queue;
+
+		Storage() : m_open(Thash_bits_open_), m_closed(Thash_bits_closed_), m_open_queue(2048) {}
+
+		void Clear()
+		{
+			m_arr.Clear();
+			m_arr.Trim(MAX_POOLED_ARENA_BLOCKS);
+			m_open.Clear();
+			m_closed.Clear();
+			m_open_queue.Clear();
+		}
+	};
+
+	/** The unused storages of this thread. */
+	static std::vector<std::unique_ptr<Storage>> &GetStoragePool()
+	{
+		static thread_local std::vector<std::unique_ptr<Storage>> pool;
+		return pool;
+	}
+
+	static std::unique_ptr<Storage> AcquireStorage()
+	{
+		std::vector<std::unique_ptr<Storage>> &pool = GetStoragePool();
+		if (pool.empty()) return std::unique_ptr<Storage>(new Storage());
+		std::unique_ptr<Storage> storage = std::move(pool.back());
+		pool.pop_back();
+		return storage;
+	}
+
+	std::unique_ptr<Storage> m_storage; ///< The containers, owned by this node list until it is destroyed.
+	CItemArray      &m_arr;        ///< Here we store full item data (Titem_).
+	COpenList       &m_open;       ///< Hash table of pointers to open item data.
+	CClosedList     &m_closed;     ///< Hash table of pointers to closed item data.
+	CPriorityQueue  &m_open_queue; ///< Priority queue of pointers to open item data.
+	Titem          *m_new_node;    ///< New open node under construction.
 
 public:
 	/** default constructor */
-	CNodeList_HashTableT() : m_open_queue(2048)
+	CNodeList_HashTableT()
+		: m_storage(AcquireStorage())
+		, m_arr(m_storage->m_arr)
+		, m_open(m_storage->m_open)
+		, m_closed(m_storage->m_closed)
+		, m_open_queue(m_storage->m_open_queue)
 	{
 		m_new_node = nullptr;
 	}
 
-	/** destructor */
+	/** destructor, gives the cleared containers back to the pool */
 	~CNodeList_HashTableT()
 	{
+		m_storage->Clear();
+		std::vector<std::unique_ptr<Storage>> &pool = GetStoragePool();
+		if (pool.size() < MAX_POOLED_STORAGES) pool.push_back(std::move(m_storage));
 	}
 
 	/** return number of open nodes */
@@ -135,8 +271,7 @@ public:
 	inline Titem_& PopOpenNode(const Key &key)
 	{
 		Titem_ &item = m_open.Pop(key);
-		uint idxPop = m_open_queue.FindIndex(item);
-		m_open_queue.Remove(idxPop);
+		m_open_queue.Remove(item);
 		return item;
 	}
 
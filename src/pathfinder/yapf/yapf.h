@@ -17,6 +17,8 @@
 #include "../../roadveh.h"
 #include "../pathfinder_type.h"
 
+#include <functional>
+
 /**
  * Finds the best path for given ship using YAPF.
  * @param v        the ship that needs to find a path
@@ -97,4 +99,11 @@ bool YapfTrainCheckReverse(const Train *v);
  */
 bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, bool override_railtype);
 
+/**
+ * Check the global road segment cost caches against the road layout of the map, by walking their segments again.
+ * A mismatch means that a change of the map did not call YapfNotifyRoadLayoutChange().
+ * @param log Receives a message for every mismatching segment.
+ */
+void YapfCheckRoadSegmentCaches(std::function<void(const char *)> log);
+
 #endif /* YAPF_H */
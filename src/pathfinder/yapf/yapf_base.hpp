@@ -12,6 +12,7 @@
 
 #include "../../debug.h"
 #include "../../settings_type.h"
+#include "../pathfinder_profiling.h"
 
 extern int _total_pf_time_us;
 
@@ -105,6 +106,12 @@ public:
 		return _settings_game.pf.yapf;
 	}
 
+	/** set the vehicle, for work which does not go through FindPath() */
+	inline void SetVehicle(const VehicleType *v)
+	{
+		m_veh = v;
+	}
+
 	/**
 	 * Main pathfinder routine:
 	 *   - set startup node(s)
@@ -150,6 +157,10 @@ public:
 
 		bDestFound &= (m_pBestDestNode != nullptr);
 
+		if (PathfinderProfileScope::current != nullptr) {
+			PathfinderProfileScope::current->AddSearch(m_stats_cost_calcs + m_stats_cache_hits, m_stats_cache_hits);
+		}
+
 		perf.Stop();
 		if (_debug_yapf_level >= 2) {
 			int t = perf.Get(1000000);
@@ -256,9 +267,7 @@ public:
 
 		bool bValid = Yapf().PfCalcCost(n, &tf);
 
-		if (bCached) {
-			Yapf().PfNodeCacheFlush(n);
-		}
+		Yapf().PfNodeCacheFlush(n);
 
 		if (bValid) bValid = Yapf().PfCalcEstimate(n);
 
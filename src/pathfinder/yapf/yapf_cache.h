@@ -19,4 +19,15 @@
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+/**
+ * Use this function to notify YAPF that the road layout of a tile has changed.
+ * @param tile the tile that is changed, INVALID_TILE when the road layout of the whole map may have changed
+ */
+void YapfNotifyRoadLayoutChange(TileIndex tile);
+
+/**
+ * Use this function to drop all shared rail destination trees, when a game is started or loaded.
+ */
+void YapfClearRailDestinationTrees();
+
 #endif /* YAPF_CACHE_H */
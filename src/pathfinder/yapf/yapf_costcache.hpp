@@ -11,6 +11,11 @@
 #define YAPF_COSTCACHE_HPP
 
 #include "../../date_func.h"
+#include "../../map_func.h"
+#include "../../transport_type.h"
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
 
 /**
  * CYapfSegmentCostCacheNoneT - the formal only yapf cost cache provider that implements
@@ -40,6 +45,14 @@ public:
 	inline void PfNodeCacheFlush(Node &n)
 	{
 	}
+
+	/**
+	 * Called by the cost provider for each tile of a segment whose cost is being calculated.
+	 *  Current cache implementation doesn't use that.
+	 */
+	inline void PfNodeCacheNoteTile(TileIndex tile)
+	{
+	}
 };
 
 
@@ -69,13 +82,22 @@ protected:
 	}
 
 public:
+	/**
+	 * Called by YAPF to get the key of the segment cost data of the given node.
+	 *  Override it when the segment cost depends on more than the node key.
+	 */
+	inline CacheKey PfNodeCacheKey(Node &n)
+	{
+		return CacheKey(n.GetKey());
+	}
+
 	/**
 	 * Called by YAPF to attach cached or local segment cost data to the given node.
 	 *  @return true if globally cached data were used or false if local data was used
 	 */
 	inline bool PfNodeCacheFetch(Node &n)
 	{
-		CacheKey key(n.GetKey());
+		CacheKey key(Yapf().PfNodeCacheKey(n));
 		Yapf().ConnectNodeToCachedData(n, *new (m_local_cache.Append()) CachedData(key));
 		return false;
 	}
@@ -87,23 +109,74 @@ public:
 	inline void PfNodeCacheFlush(Node &n)
 	{
 	}
+
+	/**
+	 * Called by the cost provider for each tile of a segment whose cost is being calculated.
+	 *  Current cache implementation doesn't use that.
+	 */
+	inline void PfNodeCacheNoteTile(TileIndex tile)
+	{
+	}
 };
 
 
 /**
- * Base class for segment cost cache providers. Contains global counter
- *  of track layout changes and static notification function called whenever
- *  the track layout changes. It is implemented as base class because it needs
- *  to be shared between all rail YAPF types (one shared counter, one notification
- *  function.
+ * Base class for segment cost cache providers. Contains global counters
+ *  of layout changes and static notification functions called whenever
+ *  the track or road layout changes. It is implemented as base class because it needs
+ *  to be shared between all rail and road YAPF types (one counter and one notification
+ *  function per transport type).
+ * A layout change of a single tile only invalidates the cached segments of the
+ *  matching transport type which contain or touch that tile, a change of
+ *  INVALID_TILE flushes all caches of the matching transport type.
  */
 struct CSegmentCostCacheBase
 {
-	static int   s_rail_change_counter;
+	static int   s_change_counter[TRANSPORT_END]; ///< incremented to flush all caches of a transport type
+	static std::vector<CSegmentCostCacheBase *> s_caches; ///< all segment cost caches which exist
+
+	static uint  s_stats_hits;          ///< stats - how many segments were found in a cache
+	static uint  s_stats_misses;        ///< stats - how many segments were not found in a cache and had to be calculated
+	static uint  s_stats_invalidated;   ///< stats - how many cached segments were invalidated by track layout changes
+
+	const TransportType m_transport_type; ///< the transport type of the segments in the cache
+
+	CSegmentCostCacheBase(TransportType transport_type) : m_transport_type(transport_type)
+	{
+		s_caches.push_back(this);
+	}
+
+	virtual ~CSegmentCostCacheBase()
+	{
+		s_caches.erase(std::find(s_caches.begin(), s_caches.end(), this));
+	}
+
+	/**
+	 * Remove the cached segments which contain or touch the given tile from the cache.
+	 * @param tile The tile whose track layout changed.
+	 */
+	virtual void InvalidateTile(TileIndex tile) = 0;
+
+	static void NotifyLayoutChange(TransportType transport_type, TileIndex tile)
+	{
+		if (tile == INVALID_TILE) {
+			/* Flush all caches of the transport type the next time they are used. */
+			s_change_counter[transport_type]++;
+			return;
+		}
+		for (CSegmentCostCacheBase *cache : s_caches) {
+			if (cache->m_transport_type == transport_type) cache->InvalidateTile(tile);
+		}
+	}
 
 	static void NotifyTrackLayoutChange(TileIndex tile, Track track)
 	{
-		s_rail_change_counter++;
+		NotifyLayoutChange(TRANSPORT_RAIL, tile);
+	}
+
+	static void NotifyRoadLayoutChange(TileIndex tile)
+	{
+		NotifyLayoutChange(TRANSPORT_ROAD, tile);
 	}
 };
 
@@ -116,26 +189,35 @@ struct CSegmentCostCacheBase
  *  be always the same (TileIndex + DiagDirection) that represent the beginning
  *  of the segment (origin tile and exit-dir from this tile).
  *  Different CYapfCachedCostT types can share the same type of CSegmentCostCacheT.
- *  Look at CYapfRailSegment (yapf_node_rail.hpp) for the segment example
+ *  Look at CYapfRailSegment (yapf_node_rail.hpp) for the segment example, the segment
+ *  type also tells the transport type of its layout changes (Tsegment::TRANSPORT_TYPE).
  */
 template <class Tsegment>
 struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 	static const int C_HASH_BITS = 14;
+	static const uint C_BLOCK_SHIFT = 3;             ///< the spatial index is made of blocks of (1 << C_BLOCK_SHIFT) x (1 << C_BLOCK_SHIFT) tiles
+	static const uint C_MAX_DEAD_SEGMENTS = 1 << 16; ///< flush the cache when this many invalidated segments occupy the heap
 
 	typedef CHashTableT<Tsegment, C_HASH_BITS> HashTable;
 	typedef SmallArray<Tsegment> Heap;
 	typedef typename Tsegment::Key Key;    ///< key to hash table
+	typedef std::unordered_map<uint32, std::vector<Tsegment *>> BlockIndex;
 
 	HashTable    m_map;
 	Heap         m_heap;
+	BlockIndex   m_block_index;  ///< segments which contain a tile of each block, by block key
+	uint         m_dead_count;   ///< number of segments in the heap which were removed from the hash table
+	std::vector<uint32> m_block_keys; ///< scratch buffer of IndexSegment()
 
-	inline CSegmentCostCacheT() {}
+	inline CSegmentCostCacheT() : CSegmentCostCacheBase(Tsegment::TRANSPORT_TYPE), m_dead_count(0) {}
 
 	/** flush (clear) the cache */
 	inline void Flush()
 	{
 		m_map.Clear();
 		m_heap.Clear();
+		m_block_index.clear();
+		m_dead_count = 0;
 	}
 
 	inline Tsegment& Get(Key &key, bool *found)
@@ -150,6 +232,58 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 		}
 		return *item;
 	}
+
+	static inline uint32 GetBlockKey(uint x, uint y)
+	{
+		return ((x >> C_BLOCK_SHIFT) << 16) | (y >> C_BLOCK_SHIFT);
+	}
+
+	/**
+	 * Add a segment whose cost has been calculated to the spatial index.
+	 * @param segment The segment.
+	 * @param tiles The tiles the segment consists of, may contain duplicates.
+	 */
+	void IndexSegment(Tsegment &segment, const std::vector<TileIndex> &tiles)
+	{
+		m_block_keys.clear();
+		for (TileIndex tile : tiles) {
+			uint32 block_key = GetBlockKey(TileX(tile), TileY(tile));
+			if (m_block_keys.empty() || m_block_keys.back() != block_key) m_block_keys.push_back(block_key);
+		}
+		std::sort(m_block_keys.begin(), m_block_keys.end());
+		m_block_keys.erase(std::unique(m_block_keys.begin(), m_block_keys.end()), m_block_keys.end());
+		for (uint32 block_key : m_block_keys) {
+			m_block_index[block_key].push_back(&segment);
+		}
+	}
+
+	void InvalidateTile(TileIndex tile) override
+	{
+		if (m_block_index.empty()) return;
+
+		/* Where a segment ends also depends on the tiles next to it, so invalidate the segments of the neighbouring tiles too. */
+		const uint x = TileX(tile);
+		const uint y = TileY(tile);
+		const uint bx_end = (x + 1) >> C_BLOCK_SHIFT;
+		const uint by_end = (y + 1) >> C_BLOCK_SHIFT;
+		for (uint bx = (x > 0 ? x - 1 : 0) >> C_BLOCK_SHIFT; bx <= bx_end; bx++) {
+			for (uint by = (y > 0 ? y - 1 : 0) >> C_BLOCK_SHIFT; by <= by_end; by++) {
+				auto iter = m_block_index.find((bx << 16) | by);
+				if (iter == m_block_index.end()) continue;
+				for (Tsegment *segment : iter->second) {
+					/* The segment may be indexed in several blocks, and may already have been invalidated via another one. */
+					if (m_map.Find(segment->GetKey()) != segment) continue;
+					m_map.Pop(*segment);
+					m_dead_count++;
+					s_stats_invalidated++;
+				}
+				m_block_index.erase(iter);
+			}
+		}
+
+		/* Invalidated segments are not removed from the heap, reclaim their space from time to time. */
+		if (m_dead_count > C_MAX_DEAD_SEGMENTS) Flush();
+	}
 };
 
 /**
@@ -170,8 +304,10 @@ public:
 
 protected:
 	Cache &m_global_cache;
+	CachedData *m_new_segment;                ///< global cache item whose cost is currently being calculated, if any
+	std::vector<TileIndex> m_new_segment_tiles; ///< tiles of m_new_segment, for the spatial index of the cache
 
-	inline CYapfSegmentCostCacheGlobalT() : m_global_cache(stGetGlobalCache()) {};
+	inline CYapfSegmentCostCacheGlobalT() : m_global_cache(stGetGlobalCache()), m_new_segment(nullptr) {};
 
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
@@ -181,7 +317,7 @@ protected:
 
 	inline static Cache& stGetGlobalCache()
 	{
-		static int last_rail_change_counter = 0;
+		static int last_change_counter = 0;
 		static Date last_date = 0;
 		static Cache C;
 
@@ -190,11 +326,16 @@ protected:
 			last_date = _date;
 			DEBUG(yapf, 2, "Pf time today: %5d ms", _total_pf_time_us / 1000);
 			_total_pf_time_us = 0;
+			DEBUG(yapf, 2, "Segment cost cache today: %u hits, %u misses, %u invalidated",
+					Cache::s_stats_hits, Cache::s_stats_misses, Cache::s_stats_invalidated);
+			Cache::s_stats_hits = 0;
+			Cache::s_stats_misses = 0;
+			Cache::s_stats_invalidated = 0;
 		}
 
 		/* delete the cache sometimes... */
-		if (last_rail_change_counter != Cache::s_rail_change_counter) {
-			last_rail_change_counter = Cache::s_rail_change_counter;
+		if (last_change_counter != Cache::s_change_counter[CachedData::TRANSPORT_TYPE]) {
+			last_change_counter = Cache::s_change_counter[CachedData::TRANSPORT_TYPE];
 			C.Flush();
 		}
 		return C;
@@ -207,22 +348,44 @@ public:
 	 */
 	inline bool PfNodeCacheFetch(Node &n)
 	{
+		m_new_segment = nullptr;
 		if (!Yapf().CanUseGlobalCache(n)) {
 			return Tlocal::PfNodeCacheFetch(n);
 		}
-		CacheKey key(n.GetKey());
+		CacheKey key(Yapf().PfNodeCacheKey(n));
 		bool found;
 		CachedData &item = m_global_cache.Get(key, &found);
 		Yapf().ConnectNodeToCachedData(n, item);
+		if (item.m_cost < 0) {
+			/* The segment cost is going to be calculated, remember its tiles. */
+			m_new_segment = &item;
+			m_new_segment_tiles.clear();
+			Cache::s_stats_misses++;
+		} else {
+			Cache::s_stats_hits++;
+		}
 		return found;
 	}
 
 	/**
 	 * Called by YAPF to flush the cached segment cost data back into cache storage.
-	 *  Current cache implementation doesn't use that.
+	 *  Adds newly calculated segments to the spatial index of the global cache.
 	 */
 	inline void PfNodeCacheFlush(Node &n)
 	{
+		if (m_new_segment == nullptr) return;
+		if (n.m_segment == m_new_segment && m_new_segment->m_cost >= 0) {
+			m_global_cache.IndexSegment(*m_new_segment, m_new_segment_tiles);
+		}
+		m_new_segment = nullptr;
+	}
+
+	/**
+	 * Called by the cost provider for each tile of a segment whose cost is being calculated.
+	 */
+	inline void PfNodeCacheNoteTile(TileIndex tile)
+	{
+		if (m_new_segment != nullptr) m_new_segment_tiles.push_back(tile);
 	}
 };
 
@@ -529,6 +529,16 @@ public:
 
 no_entry_cost: // jump here at the beginning if the node has no parent (it is the first node)
 
+			/* Let the segment cost cache know which tiles the segment consists of. */
+			Yapf().PfNodeCacheNoteTile(cur.tile);
+			if (tf->m_is_station) {
+				/* The skipped platform tiles are part of the segment too. */
+				TileIndexDiff diff = TileOffsByDiagDir(tf->m_exitdir);
+				for (int i = 1; i <= tf->m_tiles_skipped; i++) {
+					Yapf().PfNodeCacheNoteTile(cur.tile - i * diff);
+				}
+			}
+
 			/* All other tile costs will be calculated here. */
 			segment_cost += Yapf().OneTileCost(cur.tile, cur.td);
 
@@ -666,6 +676,9 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 			/* Gather the next tile/trackdir/tile_type/rail_type. */
 			TILE next(tf_local.m_new_tile, (Trackdir)FindFirstBit2x64(tf_local.m_new_td_bits));
 
+			/* The segment may end because of the next tile, which is not necessarily adjacent (tunnels, bridges). */
+			Yapf().PfNodeCacheNoteTile(next.tile);
+
 			if (TrackFollower::DoTrackMasking() && IsTileType(next.tile, MP_RAILWAY)) {
 				if (HasSignalOnTrackdir(next.tile, next.td) && IsPbsSignal(GetSignalType(next.tile, TrackdirToTrack(next.td)))) {
 					/* Possible safe tile. */
@@ -791,6 +804,11 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 	{
 		m_disable_cache = disable;
 	}
+
+	inline bool IsCacheDisabled() const
+	{
+		return m_disable_cache;
+	}
 };
 
 #endif /* YAPF_COSTRAIL_HPP */
@@ -118,6 +118,7 @@ protected:
 	TileIndex    m_destTile;
 	TrackdirBits m_destTrackdirs;
 	StationID    m_dest_station_id;
+	std::shared_ptr<const CYapfRailDestinationTree> m_dest_tree; ///< shared reverse search tree of the destination station, if used
 
 	/** to access inherited path finder */
 	Tpf& Yapf()
@@ -144,6 +145,9 @@ public:
 				m_destTile = CalcClosestStationTile(v->current_order.GetDestination(), v->tile, v->current_order.IsType(OT_GOTO_STATION) ? STATION_RAIL : STATION_WAYPOINT);
 				m_dest_station_id = v->current_order.GetDestination();
 				m_destTrackdirs = INVALID_TRACKDIR_BIT;
+				if (v->current_order.IsType(OT_GOTO_STATION) && Yapf().PfGetSettings().rail_use_destination_trees) {
+					m_dest_tree = YapfGetRailDestinationTree(m_dest_station_id, !Yapf().IsCacheDisabled());
+				}
 				break;
 
 			default:
@@ -197,6 +201,18 @@ public:
 		int dmin = min(dx, dy);
 		int dxy = abs(dx - dy);
 		int d = dmin * YAPF_TILE_CORNER_LENGTH + (dxy - 1) * (YAPF_TILE_LENGTH / 2);
+
+		if (m_dest_tree != nullptr) {
+			int tree_cost = m_dest_tree->GetCost(tile, exitdir);
+			/* Nodes from which the destination can't be reached are examined after all others. */
+			d = tree_cost >= 0 ? tree_cost : (int)m_dest_tree->GetMaxCost() + 1 + max(d, 0);
+			n.m_estimate = n.m_cost + d;
+			/* The tree doesn't know about reversing trains, so its estimate isn't always consistent.
+			 * Never let the estimate of a node fall below the one of its parent (pathmax). */
+			if (n.m_parent != nullptr) n.m_estimate = max(n.m_estimate, n.m_parent->m_estimate);
+			return true;
+		}
+
 		n.m_estimate = n.m_cost + d;
 		assert(n.m_estimate >= n.m_parent->m_estimate);
 		return true;
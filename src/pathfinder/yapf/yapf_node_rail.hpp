@@ -64,6 +64,8 @@ struct CYapfRailSegment
 {
 	typedef CYapfRailSegmentKey Key;
 
+	static const TransportType TRANSPORT_TYPE = TRANSPORT_RAIL;
+
 	CYapfRailSegmentKey    m_key;
 	TileIndex              m_last_tile;
 	Trackdir               m_last_td;
@@ -10,17 +10,106 @@
 #ifndef YAPF_NODE_ROAD_HPP
 #define YAPF_NODE_ROAD_HPP
 
+/**
+ * Key for cached segment cost for road YAPF.
+ * Where a road segment ends and what it costs also depends on the vehicle: its road
+ * type decides which roads it may use, its owner which depots it may enter and its
+ * maximum speed the penalty of slow bridges. Those are part of the key as well.
+ */
+struct CYapfRoadSegmentKey
+{
+	TileIndex m_tile;
+	Trackdir  m_td;
+	RoadType  m_roadtype;
+	Owner     m_owner;
+	uint16    m_max_speed;
+
+	inline CYapfRoadSegmentKey(const CYapfNodeKeyExitDir &node_key, RoadType roadtype, Owner owner, uint16 max_speed)
+		: m_tile(node_key.m_tile), m_td(node_key.m_td), m_roadtype(roadtype), m_owner(owner), m_max_speed(max_speed)
+	{}
+
+	inline int32 CalcHash() const
+	{
+		return (m_td | (m_tile << 4)) ^ (m_max_speed << 16) ^ (m_roadtype << 8) ^ m_owner;
+	}
+
+	inline bool operator==(const CYapfRoadSegmentKey &other) const
+	{
+		return m_tile == other.m_tile && m_td == other.m_td && m_roadtype == other.m_roadtype && m_owner == other.m_owner && m_max_speed == other.m_max_speed;
+	}
+
+	void Dump(DumpTarget &dmp) const
+	{
+		dmp.WriteTile("m_tile", m_tile);
+		dmp.WriteEnumT("m_td", m_td);
+		dmp.WriteLine("m_roadtype = %d", m_roadtype);
+		dmp.WriteLine("m_owner = %d", m_owner);
+		dmp.WriteLine("m_max_speed = %d", m_max_speed);
+	}
+};
+
+/** cached segment cost for road YAPF */
+struct CYapfRoadSegment
+{
+	typedef CYapfRoadSegmentKey Key;
+
+	static const TransportType TRANSPORT_TYPE = TRANSPORT_ROAD;
+
+	CYapfRoadSegmentKey    m_key;
+	TileIndex              m_last_tile;
+	Trackdir               m_last_td;
+	int                    m_cost;        ///< cost of the segment without the tiles skipped before it, -1 when not calculated yet
+	bool                   m_is_loop;     ///< the segment leads back to its start without any junction
+	CYapfRoadSegment      *m_hash_next;
+
+	inline CYapfRoadSegment(const CYapfRoadSegmentKey &key)
+		: m_key(key)
+		, m_last_tile(INVALID_TILE)
+		, m_last_td(INVALID_TRACKDIR)
+		, m_cost(-1)
+		, m_is_loop(false)
+		, m_hash_next(nullptr)
+	{}
+
+	inline const Key& GetKey() const
+	{
+		return m_key;
+	}
+
+	inline CYapfRoadSegment *GetHashNext()
+	{
+		return m_hash_next;
+	}
+
+	inline void SetHashNext(CYapfRoadSegment *next)
+	{
+		m_hash_next = next;
+	}
+
+	void Dump(DumpTarget &dmp) const
+	{
+		dmp.WriteStructT("m_key", &m_key);
+		dmp.WriteTile("m_last_tile", m_last_tile);
+		dmp.WriteEnumT("m_last_td", m_last_td);
+		dmp.WriteLine("m_cost = %d", m_cost);
+		dmp.WriteLine("m_is_loop = %d", m_is_loop);
+	}
+};
+
 /** Yapf Node for road YAPF */
 template <class Tkey_>
 struct CYapfRoadNodeT : CYapfNodeT<Tkey_, CYapfRoadNodeT<Tkey_> > {
 	typedef CYapfNodeT<Tkey_, CYapfRoadNodeT<Tkey_> > base;
+	typedef CYapfRoadSegment CachedData;
 
+	CYapfRoadSegment *m_segment;
 	TileIndex m_segment_last_tile;
 	Trackdir  m_segment_last_td;
 
 	void Set(CYapfRoadNodeT *parent, TileIndex tile, Trackdir td, bool is_choice)
 	{
 		base::Set(parent, tile, td, is_choice);
+		m_segment = nullptr;
 		m_segment_last_tile = tile;
 		m_segment_last_td = td;
 	}
@@ -13,6 +13,7 @@
 #include "yapf_cache.h"
 #include "yapf_node_rail.hpp"
 #include "yapf_costrail.hpp"
+#include "yapf_rail_tree.h"
 #include "yapf_destrail.hpp"
 #include "../../viewport_func.h"
 #include "../../newgrf_station.h"
@@ -90,6 +91,7 @@ private:
 	TileIndex m_res_fail_tile;    ///< The tile where the reservation failed
 	Trackdir  m_res_fail_td;      ///< The trackdir where the reservation failed
 	TileIndex m_origin_tile;      ///< Tile our reservation will originate from
+	std::vector<TileIndex> m_res_tiles; ///< Tiles reserved by TryReservePath
 
 	bool FindSafePositionProc(TileIndex tile, Trackdir td)
 	{
@@ -111,6 +113,7 @@ private:
 			if (HasStationReservation(tile)) return false;
 			SetRailStationReservation(tile, true);
 			MarkTileDirtyByTile(tile, ZOOM_LVL_DRAW_MAP);
+			m_res_tiles.push_back(tile);
 			tile = TILE_ADD(tile, diff);
 		} while (IsCompatibleTrainStationTile(tile, start) && tile != m_origin_tile);
 
@@ -135,6 +138,7 @@ private:
 				m_res_fail_td = td;
 				return false;
 			}
+			m_res_tiles.push_back(tile);
 		}
 
 		return tile != m_res_dest || td != m_res_dest_td;
@@ -183,6 +187,7 @@ public:
 	{
 		m_res_fail_tile = INVALID_TILE;
 		m_origin_tile = origin;
+		m_res_tiles.clear();
 
 		if (target != nullptr) {
 			target->tile = m_res_dest;
@@ -225,7 +230,10 @@ public:
 		if (target != nullptr) target->okay = true;
 
 		if (Yapf().CanUseGlobalCache(*m_res_node)) {
-			YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+			/* Only segments followed with track masking depend on reservations, and these contain or end next to a newly reserved tile. */
+			for (TileIndex tile : m_res_tiles) {
+				CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, INVALID_TRACK);
+			}
 		}
 
 		return true;
@@ -650,6 +658,8 @@ struct CYapfAnySafeTileRail2 : CYapfT<CYapfRail_TypesT<CYapfAnySafeTileRail2, CF
 
 Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
 {
+	PathfinderProfileScope profile(PFCS_TRAIN_CHOOSE_TRACK, v, tile);
+
 	/* default is YAPF type 2 */
 	typedef Trackdir (*PfnChooseRailTrack)(const Train*, TileIndex, DiagDirection, TrackBits, bool&, bool, PBSTileInfo*);
 	PfnChooseRailTrack pfnChooseRailTrack = &CYapfRail1::stChooseRailTrack;
@@ -660,11 +670,14 @@ Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdi
 	}
 
 	Trackdir td_ret = pfnChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target);
+	profile.SetResult(path_found);
 	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : FindFirstTrack(tracks);
 }
 
 bool YapfTrainCheckReverse(const Train *v)
 {
+	PathfinderProfileScope profile(PFCS_TRAIN_CHECK_REVERSE, v, v->tile);
+
 	const Train *last_veh = v->Last();
 
 	/* get trackdirs of both ends */
@@ -720,12 +733,15 @@ bool YapfTrainCheckReverse(const Train *v)
 	if (reverse_penalty == 0) reverse_penalty = 1;
 
 	bool reverse = pfnCheckReverseTrain(v, tile, td, tile_rev, td_rev, reverse_penalty);
+	profile.SetResult(reverse);
 
 	return reverse;
 }
 
 FindDepotData YapfTrainFindNearestDepot(const Train *v, int max_penalty)
 {
+	PathfinderProfileScope profile(PFCS_TRAIN_FIND_DEPOT, v, v->tile);
+
 	const Train *last_veh = v->Last();
 
 	PBSTileInfo origin = FollowTrainReservation(v);
@@ -740,11 +756,15 @@ FindDepotData YapfTrainFindNearestDepot(const Train *v, int max_penalty)
 		pfnFindNearestDepotTwoWay = &CYapfAnyDepotRail2::stFindNearestDepotTwoWay; // Trackdir, forbid 90-deg
 	}
 
-	return pfnFindNearestDepotTwoWay(v, origin.tile, origin.trackdir, last_tile, td_rev, max_penalty, YAPF_INFINITE_PENALTY);
+	FindDepotData result = pfnFindNearestDepotTwoWay(v, origin.tile, origin.trackdir, last_tile, td_rev, max_penalty, YAPF_INFINITE_PENALTY);
+	profile.SetResult(result.tile != INVALID_TILE);
+	return result;
 }
 
 bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, bool override_railtype)
 {
+	PathfinderProfileScope profile(PFCS_TRAIN_FIND_SAFE_TILE, v, tile);
+
 	typedef bool (*PfnFindNearestSafeTile)(const Train*, TileIndex, Trackdir, bool);
 	PfnFindNearestSafeTile pfnFindNearestSafeTile = CYapfAnySafeTileRail1::stFindNearestSafeTile;
 
@@ -753,15 +773,22 @@ bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, b
 		pfnFindNearestSafeTile = &CYapfAnySafeTileRail2::stFindNearestSafeTile;
 	}
 
-	return pfnFindNearestSafeTile(v, tile, td, override_railtype);
+	bool found = pfnFindNearestSafeTile(v, tile, td, override_railtype);
+	profile.SetResult(found);
+	return found;
 }
 
-/** if any track changes, this counter is incremented - that will invalidate segment cost cache */
-int CSegmentCostCacheBase::s_rail_change_counter = 0;
+/** if all tracks or roads may have changed, the counter of the transport type is incremented - that will flush its segment cost caches */
+int CSegmentCostCacheBase::s_change_counter[TRANSPORT_END] = {};
+std::vector<CSegmentCostCacheBase *> CSegmentCostCacheBase::s_caches;
+uint CSegmentCostCacheBase::s_stats_hits = 0;
+uint CSegmentCostCacheBase::s_stats_misses = 0;
+uint CSegmentCostCacheBase::s_stats_invalidated = 0;
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
+	if (tile != INVALID_TILE) YapfInvalidateRailDestinationTrees(tile);
 }
 
 void YapfCheckRailSignalPenalties()
@@ -0,0 +1,225 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_rail_tree.cpp Shared reverse search trees of the cost to reach rail stations, used as cost estimate by YAPF rail. */
+
+#include "../../stdafx.h"
+#include "../../station_base.h"
+#include "../../rail_map.h"
+#include "../../tunnelbridge_map.h"
+#include "../../tunnelbridge.h"
+#include "../../tile_cmd.h"
+#include "../../debug.h"
+#include "../pathfinder_type.h"
+
+#include "yapf_cache.h"
+#include "yapf_rail_tree.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "../../safeguards.h"
+
+static const uint MAX_RAIL_DESTINATION_TREE_STATES = 1 << 16;  ///< Number of states after which the search of a destination tree stops.
+static const size_t MAX_RAIL_DESTINATION_TREES_SIZE = 1 << 19; ///< Total size of the kept destination trees, see CYapfRailDestinationTree::Size().
+
+/** The kept destination trees, the most recently used last. As many are kept as fit into #MAX_RAIL_DESTINATION_TREES_SIZE. */
+static std::vector<std::shared_ptr<const CYapfRailDestinationTree>> _rail_destination_trees;
+
+/** Get the trackdirs of the rail track on a tile. */
+static inline TrackdirBits GetRailTrackdirs(TileIndex tile)
+{
+	if (IsPlainRailTile(tile)) return (TrackdirBits)(GetTrackBits(tile) * 0x101);
+	return TrackStatusToTrackdirBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0));
+}
+
+/**
+ * Get everything about a tile the search of a destination tree depends on.
+ * @param tile The tile.
+ * @param station The destination station.
+ * @return The signature of the tile, which only changes when the tile matters differently to the search.
+ */
+static uint32 GetTileSignature(TileIndex tile, StationID station)
+{
+	uint32 signature = GetRailTrackdirs(tile) | GetTileType(tile) << 16;
+	if (IsRailDepotTile(tile)) signature |= GetRailDepotDirection(tile) << 20;
+	if (IsTileType(tile, MP_TUNNELBRIDGE)) signature |= GetTunnelBridgeDirection(tile) << 20;
+	if (HasStationTileRail(tile) && GetStationIndex(tile) == station) SetBit(signature, 22);
+	return signature;
+}
+
+/** Lower bound of the cost of a tile, see CYapfCostRailT::OneTileCost(). */
+static inline uint32 GetTileCost(Trackdir td)
+{
+	return IsDiagonalTrackdir(td) ? YAPF_TILE_LENGTH : YAPF_TILE_CORNER_LENGTH;
+}
+
+CYapfRailDestinationTree::CYapfRailDestinationTree(StationID station) : m_station(station), m_max_cost(0), m_bound(-1)
+{
+	this->Build();
+}
+
+/**
+ * Calculate the costs by a Dijkstra search from the platforms against the direction of travel.
+ * Each state is a tile together with the direction in which it is left. Its predecessors are
+ * found by reversing the trackdirs of the tile, which leave the tile towards the predecessors.
+ * When the search stops early, only the states cheaper than the next state to examine are kept,
+ * as the costs of these are final and all other states cost at least as much as that state.
+ */
+void CYapfRailDestinationTree::Build()
+{
+	typedef std::pair<uint32, uint32> QueueItem; ///< cost and key of a state
+	std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+	auto relax = [&](TileIndex tile, DiagDirection exitdir, uint32 cost) {
+		this->m_tiles.insert({ tile, GetTileSignature(tile, this->m_station) });
+		bool can_exit = false;
+		for (TrackdirBits tds = GetRailTrackdirs(tile); tds != TRACKDIR_BIT_NONE; tds = KillFirstBit(tds)) {
+			if (TrackdirToExitdir((Trackdir)FindFirstBit2x64(tds)) == exitdir) can_exit = true;
+		}
+		if (!can_exit) return;
+
+		uint32 key = GetKey(tile, exitdir);
+		auto result = this->m_costs.insert({ key, cost });
+		if (!result.second) {
+			if (result.first->second <= cost) return;
+			result.first->second = cost;
+		}
+		queue.push({ cost, key });
+	};
+
+	/* The tile is entered on trackdir td, from where the cost to the destination is cost. */
+	auto enter = [&](TileIndex tile, Trackdir td, uint32 cost) {
+		DiagDirection back = TrackdirToExitdir(ReverseTrackdir(td));
+		cost += GetTileCost(td);
+		if (IsTileType(tile, MP_TUNNELBRIDGE) && GetTunnelBridgeDirection(tile) == back) {
+			/* Entered through the tunnel or over the bridge. */
+			TileIndex other_end = GetOtherTunnelBridgeEnd(tile);
+			relax(other_end, ReverseDiagDir(back), cost + YAPF_TILE_LENGTH * GetTunnelBridgeLength(tile, other_end));
+		} else {
+			relax(TileAddByDiagDir(tile, back), ReverseDiagDir(back), cost);
+		}
+	};
+
+	const Station *st = Station::GetIfValid(this->m_station);
+	if (st != nullptr) {
+		TILE_AREA_LOOP(tile, st->train_station) {
+			if (!HasStationTileRail(tile) || GetStationIndex(tile) != this->m_station) continue;
+			this->m_tiles.insert({ tile, GetTileSignature(tile, this->m_station) });
+			Trackdir td = TrackToTrackdir(GetRailStationTrack(tile));
+			enter(tile, td, 0);
+			enter(tile, ReverseTrackdir(td), 0);
+		}
+	}
+
+	uint states = 0;
+	while (!queue.empty()) {
+		QueueItem item = queue.top();
+		if (this->m_costs[item.second] != item.first) {
+			queue.pop();
+			continue;
+		}
+		if (states == MAX_RAIL_DESTINATION_TREE_STATES) {
+			this->m_bound = item.first;
+			break;
+		}
+		queue.pop();
+		states++;
+
+		uint32 cost = item.first;
+		TileIndex tile = item.second >> 2;
+		DiagDirection exitdir = (DiagDirection)(item.second & 3);
+		this->m_max_cost = std::max(this->m_max_cost, cost);
+
+		for (TrackdirBits tds = GetRailTrackdirs(tile); tds != TRACKDIR_BIT_NONE; tds = KillFirstBit(tds)) {
+			Trackdir td = (Trackdir)FindFirstBit2x64(tds);
+			if (TrackdirToExitdir(td) == exitdir) enter(tile, td, cost);
+		}
+
+		/* Trains reverse in depots, see CFollowTrackT::ForcedReverse(). */
+		if (IsRailDepotTile(tile) && GetRailDepotDirection(tile) == exitdir) {
+			relax(tile, ReverseDiagDir(exitdir), cost + YAPF_TILE_LENGTH);
+		}
+	}
+
+	if (this->m_bound >= 0) {
+		for (auto it = this->m_costs.begin(); it != this->m_costs.end();) {
+			if ((int)it->second >= this->m_bound) {
+				it = this->m_costs.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	DEBUG(yapf, 3, "Built destination tree of station %u: %u states, max cost %u, bound %d", this->m_station, (uint)this->m_costs.size(), this->m_max_cost, this->m_bound);
+}
+
+/**
+ * Check whether a changed tile may change the costs of the tree.
+ * The search only depends on the tiles it read and on the platforms of the destination, so the
+ * tree stays valid as long as these look the same to it. That way changes of signals, rail types
+ * or routing restrictions keep the tree.
+ * @param tile The changed tile.
+ * @return True if the tree has to be rebuilt.
+ */
+bool CYapfRailDestinationTree::IsAffectedByTile(TileIndex tile) const
+{
+	uint32 signature = GetTileSignature(tile, this->m_station);
+	auto it = this->m_tiles.find(tile);
+	if (it == this->m_tiles.end()) return HasBit(signature, 22);
+	return it->second != signature;
+}
+
+/**
+ * Get the destination tree of a station.
+ * @param station The destination station.
+ * @param use_cache Whether a kept tree may be used, otherwise a new tree is built which is not kept.
+ * @return The tree.
+ */
+std::shared_ptr<const CYapfRailDestinationTree> YapfGetRailDestinationTree(StationID station, bool use_cache)
+{
+	if (!use_cache) return std::make_shared<const CYapfRailDestinationTree>(station);
+
+	auto it = std::find_if(_rail_destination_trees.begin(), _rail_destination_trees.end(),
+			[&](const std::shared_ptr<const CYapfRailDestinationTree> &tree) { return tree->GetStation() == station; });
+	if (it != _rail_destination_trees.end()) {
+		std::rotate(it, it + 1, _rail_destination_trees.end());
+		return _rail_destination_trees.back();
+	}
+
+	_rail_destination_trees.push_back(std::make_shared<const CYapfRailDestinationTree>(station));
+
+	/* Drop the least recently used trees until the others fit, but always keep the new one. */
+	size_t size = 0;
+	for (const auto &tree : _rail_destination_trees) size += tree->Size();
+	auto first = _rail_destination_trees.begin();
+	while (size > MAX_RAIL_DESTINATION_TREES_SIZE && first + 1 != _rail_destination_trees.end()) {
+		size -= (*first)->Size();
+		++first;
+	}
+	_rail_destination_trees.erase(_rail_destination_trees.begin(), first);
+	return _rail_destination_trees.back();
+}
+
+/**
+ * Drop the destination trees which are affected by a track layout change.
+ * @param tile The changed tile.
+ */
+void YapfInvalidateRailDestinationTrees(TileIndex tile)
+{
+	_rail_destination_trees.erase(std::remove_if(_rail_destination_trees.begin(), _rail_destination_trees.end(),
+			[&](const std::shared_ptr<const CYapfRailDestinationTree> &tree) { return tree->IsAffectedByTile(tile); }),
+			_rail_destination_trees.end());
+}
+
+void YapfClearRailDestinationTrees()
+{
+	_rail_destination_trees.clear();
+}
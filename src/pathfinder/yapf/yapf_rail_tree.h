@@ -0,0 +1,77 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_rail_tree.h Shared reverse search trees of the cost to reach rail stations, used as cost estimate by YAPF rail. */
+
+#ifndef YAPF_RAIL_TREE_H
+#define YAPF_RAIL_TREE_H
+
+#include "../../tile_type.h"
+#include "../../direction_type.h"
+#include "../../station_type.h"
+
+#include <memory>
+#include <unordered_map>
+
+/**
+ * Lower bounds of the cost to reach any platform of a rail station, by tile and exit direction.
+ * The tree is the result of a reverse Dijkstra search from the platforms over all rail track.
+ * It ignores rail types, owners, signals and all penalties, so it only depends on the track
+ * layout and its costs never exceed the costs YAPF calculates for the same route.
+ * The search stops after a number of states, the states it didn't reach cost at least m_bound.
+ */
+class CYapfRailDestinationTree {
+	StationID m_station;                           ///< the destination station
+	std::unordered_map<uint32, uint32> m_costs;    ///< cost to the destination after leaving a tile, by GetKey()
+	std::unordered_map<TileIndex, uint32> m_tiles; ///< signatures of the tiles read by the search, see GetTileSignature()
+	uint32 m_max_cost;                             ///< the highest cost in the tree
+	int m_bound;                                   ///< lower bound of the cost of the states missing from the tree, or -1 when the search reached all states
+
+	static inline uint32 GetKey(TileIndex tile, DiagDirection exitdir)
+	{
+		return (tile << 2) | exitdir;
+	}
+
+	void Build();
+
+public:
+	CYapfRailDestinationTree(StationID station);
+
+	inline StationID GetStation() const
+	{
+		return m_station;
+	}
+
+	/**
+	 * Get the lower bound of the cost to reach the destination after leaving a tile.
+	 * @param tile The tile which is left.
+	 * @param exitdir The direction in which the tile is left.
+	 * @return The cost, the lower bound of the states the search didn't reach, or -1 when the destination can't be reached from there.
+	 */
+	inline int GetCost(TileIndex tile, DiagDirection exitdir) const
+	{
+		auto it = m_costs.find(GetKey(tile, exitdir));
+		return it != m_costs.end() ? (int)it->second : m_bound;
+	}
+
+	inline uint32 GetMaxCost() const
+	{
+		return m_max_cost;
+	}
+
+	inline size_t Size() const
+	{
+		return m_costs.size() + m_tiles.size();
+	}
+
+	bool IsAffectedByTile(TileIndex tile) const;
+};
+
+std::shared_ptr<const CYapfRailDestinationTree> YapfGetRailDestinationTree(StationID station, bool use_cache);
+void YapfInvalidateRailDestinationTrees(TileIndex tile);
+
+#endif /* YAPF_RAIL_TREE_H */
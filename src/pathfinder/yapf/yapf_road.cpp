@@ -12,6 +12,9 @@
 #include "yapf_node_road.hpp"
 #include "../../roadstop_base.h"
 
+#include <map>
+#include <tuple>
+
 #include "../../safeguards.h"
 
 /**
@@ -31,6 +34,7 @@ public:
 	typedef typename Types::TrackFollower TrackFollower; ///< track follower helper
 	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
 	typedef typename Node::Key Key;    ///< key to hash tables
+	typedef typename Node::CachedData CachedData;
 
 protected:
 	int m_max_cost;
@@ -108,40 +112,43 @@ protected:
 		return cost;
 	}
 
-public:
-	inline void SetMaxCost(int max_cost)
-	{
-		m_max_cost = max_cost;
-	}
-
 	/**
-	 * Called by YAPF to calculate the cost from the origin to the given node.
-	 *  Calculates only the cost of given node, adds it to the parent node cost
-	 *  and stores the result into Node::m_cost member
+	 * Walk from the start of the segment of the given node to its end and calculate the cost of the segment.
+	 * @param n The node.
+	 * @param base_cost The cost of the path up to the start of the segment.
+	 * @param[out] last_tile The last tile of the segment.
+	 * @param[out] last_td The last trackdir of the segment.
+	 * @param[out] segment_cost The cost of the segment.
+	 * @param[out] cacheable Whether the segment may be kept in the global segment cost cache.
+	 * @return false if the segment is not valid, i.e. it exceeded the maximum cost or loops back to its start.
 	 */
-	inline bool PfCalcCost(Node &n, const TrackFollower *tf)
+	bool WalkSegment(const Node &n, int base_cost, TileIndex &last_tile, Trackdir &last_td, int &segment_cost, bool &cacheable)
 	{
-		/* this is to handle the case where the starting tile is a junction custom bridge head,
-		 * and we have advanced across the bridge in the initial step */
-		int segment_cost = tf->m_tiles_skipped * YAPF_TILE_LENGTH;
+		last_tile = INVALID_TILE;
+		last_td = INVALID_TRACKDIR;
+		segment_cost = 0;
+		cacheable = true;
 
 		uint tiles = 0;
 		/* start at n.m_key.m_tile / n.m_key.m_td and walk to the end of segment */
 		TileIndex tile = n.m_key.m_tile;
 		Trackdir trackdir = n.m_key.m_td;
-		int parent_cost = (n.m_parent != nullptr) ? n.m_parent->m_cost : 0;
+		Yapf().PfNodeCacheNoteTile(tile);
 
 		for (;;) {
 			/* base tile cost depending on distance between edges */
 			segment_cost += Yapf().OneTileCost(tile, trackdir);
 
+			/* the cost of road stops depends on their occupancy */
+			if (IsTileType(tile, MP_STATION)) cacheable = false;
+
 			const RoadVehicle *v = Yapf().GetVehicle();
 			/* we have reached the vehicle's destination - segment should end here to avoid target skipping */
 			if (Yapf().PfDetectDestinationTile(tile, trackdir)) break;
 
 			/* Finish if we already exceeded the maximum path cost (i.e. when
 			 * searching for the nearest depot). */
-			if (m_max_cost > 0 && (parent_cost + segment_cost) > m_max_cost) {
+			if (m_max_cost > 0 && (base_cost + segment_cost) > m_max_cost) {
 				return false;
 			}
 
@@ -153,7 +160,13 @@ public:
 
 			/* if there are no reachable trackdirs on new tile, we have end of road */
 			TrackFollower F(Yapf().GetVehicle());
-			if (!F.Follow(tile, trackdir)) break;
+			bool followed = F.Follow(tile, trackdir);
+			if (F.m_new_tile != INVALID_TILE) Yapf().PfNodeCacheNoteTile(F.m_new_tile);
+			if (!followed) {
+				/* whether the vehicle may use the next tile changes with its owner */
+				if (F.m_err == TrackFollower::EC_OWNER) cacheable = false;
+				break;
+			}
 
 			/* if we skipped some tunnel tiles, add their cost */
 			/* with custom bridge heads, this cost must be added before checking if the segment has ended */
@@ -184,14 +197,167 @@ public:
 			if (tiles > MAX_RV_PF_TILES) break;
 		}
 
+		last_tile = tile;
+		last_td = trackdir;
+		return true;
+	}
+
+public:
+	inline void SetMaxCost(int max_cost)
+	{
+		m_max_cost = max_cost;
+	}
+
+	/**
+	 * Called by YAPF to calculate the cost from the origin to the given node.
+	 *  Calculates only the cost of given node, adds it to the parent node cost
+	 *  and stores the result into Node::m_cost member
+	 */
+	inline bool PfCalcCost(Node &n, const TrackFollower *tf)
+	{
+		/* this is to handle the case where the starting tile is a junction custom bridge head,
+		 * and we have advanced across the bridge in the initial step */
+		int segment_entry_cost = tf->m_tiles_skipped * YAPF_TILE_LENGTH;
+		int parent_cost = (n.m_parent != nullptr) ? n.m_parent->m_cost : 0;
+
+		CachedData &segment = *n.m_segment;
+		TileIndex last_tile;
+		Trackdir last_td;
+		int segment_cost;
+		bool valid;
+		if (segment.m_cost >= 0) {
+			/* reuse the segment calculated before */
+			last_tile = segment.m_last_tile;
+			last_td = segment.m_last_td;
+			segment_cost = segment.m_cost;
+			valid = !segment.m_is_loop;
+		} else {
+			bool cacheable;
+			valid = WalkSegment(n, parent_cost + segment_entry_cost, last_tile, last_td, segment_cost, cacheable);
+			/* There is no global cache when there is a maximum cost, so an invalid cached segment is a loop. */
+			if (cacheable) {
+				segment.m_last_tile = last_tile;
+				segment.m_last_td = last_td;
+				segment.m_cost = segment_cost;
+				segment.m_is_loop = !valid;
+			}
+		}
+		if (!valid) return false;
+
 		/* save end of segment back to the node */
-		n.m_segment_last_tile = tile;
-		n.m_segment_last_td = trackdir;
+		n.m_segment_last_tile = last_tile;
+		n.m_segment_last_td = last_td;
 
 		/* save also tile cost */
-		n.m_cost = parent_cost + segment_cost;
+		n.m_cost = parent_cost + segment_entry_cost + segment_cost;
 		return true;
 	}
+
+	/**
+	 * Whether the segment of the given node may be taken from, and kept in, the global segment cost cache.
+	 * Segments end early at the destination and when the maximum cost is exceeded; as other
+	 * vehicles have other destinations, only searches for a station without a maximum cost
+	 * can use the cache. Road stops never are part of a cached segment.
+	 */
+	inline bool CanUseGlobalCache(Node &n)
+	{
+		return m_max_cost == 0 && n.m_parent != nullptr && Yapf().IsDestinationSegmentCacheable();
+	}
+
+	/**
+	 * Walk a segment of the global segment cost cache again, and compare the result with the cached one.
+	 * @param segment The cached segment, whose cost has been calculated.
+	 * @return Whether the cached segment still matches the road layout of the map.
+	 */
+	inline bool PfCheckCachedSegment(const CachedData &segment)
+	{
+		Node n;
+		n.Set(nullptr, segment.m_key.m_tile, segment.m_key.m_td, false);
+		TileIndex last_tile;
+		Trackdir last_td;
+		int segment_cost;
+		bool cacheable;
+		bool valid = WalkSegment(n, 0, last_tile, last_td, segment_cost, cacheable);
+		return cacheable && valid == !segment.m_is_loop && last_tile == segment.m_last_tile && last_td == segment.m_last_td && segment_cost == segment.m_cost;
+	}
+
+	inline void ConnectNodeToCachedData(Node &n, CachedData &ci)
+	{
+		n.m_segment = &ci;
+	}
+};
+
+
+/**
+ * Segment cost cache provider for road YAPF: the global segment cost cache, with the
+ * road type, owner and maximum speed of the vehicle as part of the key of the segments.
+ */
+template <class Types>
+class CYapfSegmentCostCacheRoadT : public CYapfSegmentCostCacheGlobalT<Types>
+{
+public:
+	typedef CYapfSegmentCostCacheGlobalT<Types> Tglobal;
+	typedef typename Types::Tpf Tpf;              ///< the pathfinder class (derived from THIS class)
+	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
+	typedef typename Node::CachedData CachedData;
+	typedef typename CachedData::Key CacheKey;
+
+protected:
+	inline CYapfSegmentCostCacheRoadT()
+	{
+		/* The cached segment costs include these penalties, and which depots may be entered depends on infrastructure sharing. */
+		static uint64 last_settings = 0;
+		const YAPFSettings &settings = _settings_game.pf.yapf;
+		uint64 current_settings = settings.road_slope_penalty;
+		current_settings = current_settings * 31 + settings.road_curve_penalty;
+		current_settings = current_settings * 31 + settings.road_crossing_penalty;
+		current_settings = current_settings * 2 + (_settings_game.economy.infrastructure_sharing[VEH_ROAD] ? 1 : 0);
+		if (current_settings != last_settings) {
+			last_settings = current_settings;
+			this->m_global_cache.Flush();
+		}
+	}
+
+	/** to access inherited path finder */
+	inline Tpf& Yapf()
+	{
+		return *static_cast<Tpf *>(this);
+	}
+
+public:
+	inline CacheKey PfNodeCacheKey(Node &n)
+	{
+		const RoadVehicle *v = Yapf().GetVehicle();
+		return CacheKey(n.GetKey(), v->roadtype, v->owner, v->GetDisplayMaxSpeed());
+	}
+
+	/**
+	 * Check the calculated segments of the global cache against the road layout of the map.
+	 * @param vehicles A road vehicle for each road type, owner and maximum speed; segments of other vehicles are not checked.
+	 * @param log Receives a message for every mismatching segment.
+	 */
+	static void stCheckGlobalCache(const std::map<std::tuple<RoadType, Owner, uint16>, const RoadVehicle *> &vehicles, std::function<void(const char *)> log)
+	{
+		typename Tglobal::Cache &cache = Tglobal::stGetGlobalCache();
+		Tpf pf;
+		char buffer[128];
+		const typename Tglobal::Cache::Heap &heap = cache.m_heap;
+		for (uint i = 0; i < heap.Length(); i++) {
+			const CachedData &segment = heap[i];
+			/* Skip the segments which have been invalidated, or whose search has not calculated them. */
+			if (segment.m_cost < 0 || cache.m_map.Find(segment.GetKey()) != &segment) continue;
+
+			auto iter = vehicles.find(std::make_tuple(segment.m_key.m_roadtype, segment.m_key.m_owner, segment.m_key.m_max_speed));
+			if (iter == vehicles.end()) continue;
+
+			pf.SetVehicle(iter->second);
+			if (!pf.PfCheckCachedSegment(segment)) {
+				seprintf(buffer, lastof(buffer), "road segment cache mismatch: tile 0x%X, trackdir %u, road type %u, owner %u, max speed %u",
+						segment.m_key.m_tile, segment.m_key.m_td, segment.m_key.m_roadtype, segment.m_key.m_owner, segment.m_key.m_max_speed);
+				log(buffer);
+			}
+		}
+	}
 };
 
 
@@ -221,6 +387,12 @@ public:
 		return IsRoadDepotTile(tile);
 	}
 
+	/** Any depot may lie within a segment cached for another vehicle. */
+	inline bool IsDestinationSegmentCacheable() const
+	{
+		return false;
+	}
+
 	/**
 	 * Called by YAPF to calculate cost estimate. Calculates distance to the destination
 	 *  adds it to the actual cost from origin and stores the sum to the Node::m_estimate
@@ -243,9 +415,9 @@ public:
 	typedef typename Node::Key Key;                      ///< key to hash tables
 
 protected:
-	TileIndex    m_destTile;
-	TrackdirBits m_destTrackdirs;
-	StationID    m_dest_station;
+	TileIndex    m_destTile = INVALID_TILE;
+	TrackdirBits m_destTrackdirs = TRACKDIR_BIT_NONE;
+	StationID    m_dest_station = INVALID_STATION;
 	bool         m_bus;
 	bool         m_non_artic;
 
@@ -270,6 +442,12 @@ public:
 		return m_dest_station != INVALID_STATION ? Station::GetIfValid(m_dest_station) : nullptr;
 	}
 
+	/** Cached segments contain no road stops, so they never skip a destination station. */
+	inline bool IsDestinationSegmentCacheable() const
+	{
+		return m_dest_station != INVALID_STATION;
+	}
+
 protected:
 	/** to access inherited path finder */
 	Tpf& Yapf()
@@ -533,7 +711,7 @@ struct CYapfRoad_TypesT
 	typedef CYapfFollowRoadT<Types>           PfFollow;
 	typedef CYapfOriginTileT<Types>           PfOrigin;
 	typedef Tdestination<Types>               PfDestination;
-	typedef CYapfSegmentCostCacheNoneT<Types> PfCache;
+	typedef CYapfSegmentCostCacheRoadT<Types> PfCache;
 	typedef CYapfCostRoadT<Types>             PfCost;
 };
 
@@ -546,6 +724,8 @@ struct CYapfRoadAnyDepot2 : CYapfT<CYapfRoad_TypesT<CYapfRoadAnyDepot2, CRoadNod
 
 Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs, bool &path_found, RoadVehPathCache &path_cache)
 {
+	PathfinderProfileScope profile(PFCS_ROAD_CHOOSE_TRACK, v, tile);
+
 	/* default is YAPF type 2 */
 	typedef Trackdir (*PfnChooseRoadTrack)(const RoadVehicle*, TileIndex, DiagDirection, bool &path_found, RoadVehPathCache &path_cache);
 	PfnChooseRoadTrack pfnChooseRoadTrack = &CYapfRoad2::stChooseRoadTrack; // default: ExitDir, allow 90-deg
@@ -556,6 +736,7 @@ Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDi
 	}
 
 	Trackdir td_ret = pfnChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
+	profile.SetResult(path_found);
 	return (td_ret != INVALID_TRACKDIR) ? td_ret : (Trackdir)FindFirstBit2x64(trackdirs);
 }
 
@@ -576,5 +757,24 @@ FindDepotData YapfRoadVehicleFindNearestDepot(const RoadVehicle *v, int max_dist
 		pfnFindNearestDepot = &CYapfRoadAnyDepot1::stFindNearestDepot; // Trackdir
 	}
 
-	return pfnFindNearestDepot(v, tile, trackdir, max_distance);
+	PathfinderProfileScope profile(PFCS_ROAD_FIND_DEPOT, v, tile);
+	FindDepotData result = pfnFindNearestDepot(v, tile, trackdir, max_distance);
+	profile.SetResult(result.tile != INVALID_TILE);
+	return result;
+}
+
+void YapfNotifyRoadLayoutChange(TileIndex tile)
+{
+	CSegmentCostCacheBase::NotifyRoadLayoutChange(tile);
+}
+
+void YapfCheckRoadSegmentCaches(std::function<void(const char *)> log)
+{
+	std::map<std::tuple<RoadType, Owner, uint16>, const RoadVehicle *> vehicles;
+	for (const RoadVehicle *v : RoadVehicle::Iterate()) {
+		if (v->IsFrontEngine()) vehicles.emplace(std::make_tuple(v->roadtype, v->owner, (uint16)v->GetDisplayMaxSpeed()), v);
+	}
+
+	CYapfRoad1::stCheckGlobalCache(vehicles, log);
+	CYapfRoad2::stCheckGlobalCache(vehicles, log);
 }
@@ -14,9 +14,12 @@
 
 #include "yapf.hpp"
 #include "yapf_node_ship.hpp"
+#include "yapf_ship_regions.h"
 
 #include "../../safeguards.h"
 
+static const int NUMBER_OF_WATER_REGIONS_LOOKAHEAD = 4; ///< Number of water regions ahead of the ship that the low level pathfinder searches to.
+
 template <class Types>
 class CYapfDestinationTileWaterT
 {
@@ -31,6 +34,10 @@ protected:
 	TrackdirBits m_destTrackdirs;
 	StationID    m_destStation;
 
+	bool                 m_has_intermediate_dest = false;
+	TileIndex            m_intermediate_dest_tile;
+	WaterRegionPatchDesc m_intermediate_dest_region_patch;
+
 public:
 	void SetDestination(const Ship *v)
 	{
@@ -45,6 +52,17 @@ public:
 		}
 	}
 
+	/**
+	 * Search only up to a water region patch on the way to the destination, instead of all the way to the destination.
+	 * @param water_region_patch The patch to search to.
+	 */
+	void SetIntermediateDestination(const WaterRegionPatchDesc &water_region_patch)
+	{
+		m_has_intermediate_dest = true;
+		m_intermediate_dest_tile = GetWaterRegionCenterTile(WaterRegionDesc{ water_region_patch.x, water_region_patch.y });
+		m_intermediate_dest_region_patch = water_region_patch;
+	}
+
 protected:
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
@@ -61,6 +79,12 @@ public:
 
 	inline bool PfDetectDestinationTile(TileIndex tile, Trackdir trackdir)
 	{
+		if (m_has_intermediate_dest) {
+			/* Comparing the regions first avoids updating the labels of every region the search passes through. */
+			if (GetWaterRegionInfo(tile) != WaterRegionDesc{ m_intermediate_dest_region_patch.x, m_intermediate_dest_region_patch.y }) return false;
+			return GetWaterRegionPatchInfo(tile) == m_intermediate_dest_region_patch;
+		}
+
 		if (m_destStation != INVALID_STATION) {
 			return IsDockingTile(tile) && IsShipDestinationTile(tile, m_destStation);
 		}
@@ -85,8 +109,9 @@ public:
 		DiagDirection exitdir = TrackdirToExitdir(n.m_segment_last_td);
 		int x1 = 2 * TileX(tile) + dg_dir_to_x_offs[(int)exitdir];
 		int y1 = 2 * TileY(tile) + dg_dir_to_y_offs[(int)exitdir];
-		int x2 = 2 * TileX(m_destTile);
-		int y2 = 2 * TileY(m_destTile);
+		const TileIndex destination_tile = m_has_intermediate_dest ? m_intermediate_dest_tile : m_destTile;
+		int x2 = 2 * TileX(destination_tile);
+		int y2 = 2 * TileY(destination_tile);
 		int dx = abs(x1 - x2);
 		int dy = abs(y1 - y2);
 		int dmin = min(dx, dy);
@@ -110,13 +135,32 @@ public:
 	typedef typename Node::Key Key;                      ///< key to hash tables
 
 protected:
+	std::vector<WaterRegionPatchDesc> m_search_corridor; ///< When not empty, the water region patches the search is restricted to.
+
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
 	{
 		return *static_cast<Tpf *>(this);
 	}
 
+	/** Whether the search may enter the given tile. */
+	inline bool IsInSearchCorridor(TileIndex tile) const
+	{
+		if (m_search_corridor.empty()) return true;
+		const WaterRegionPatchDesc patch = GetWaterRegionPatchInfo(tile);
+		return std::find(m_search_corridor.begin(), m_search_corridor.end(), patch) != m_search_corridor.end();
+	}
+
 public:
+	/**
+	 * Restrict the search to the given water region patches.
+	 * @param path The patches of the path found by the water region pathfinder.
+	 */
+	void RestrictSearch(const std::vector<WaterRegionPatchDesc> &path)
+	{
+		m_search_corridor = path;
+	}
+
 	/**
 	 * Called by YAPF to move from the given node to the next tile. For each
 	 *  reachable trackdir on the new tile creates new node, initializes it
@@ -125,7 +169,7 @@ public:
 	inline void PfFollowNode(Node &old_node)
 	{
 		TrackFollower F(Yapf().GetVehicle());
-		if (F.Follow(old_node.m_key.m_tile, old_node.m_key.m_td)) {
+		if (F.Follow(old_node.m_key.m_tile, old_node.m_key.m_td) && IsInSearchCorridor(F.m_new_tile)) {
 			Yapf().AddMultipleNodes(&old_node, F);
 		}
 	}
@@ -158,22 +202,52 @@ public:
 		/* convert origin trackdir to TrackdirBits */
 		TrackdirBits trackdirs = TrackdirToTrackdirBits(trackdir);
 
-		/* create pathfinder instance */
-		Tpf pf;
-		/* set origin and destination nodes */
-		pf.SetOrigin(src_tile, trackdirs);
-		pf.SetDestination(v);
-		/* find best path */
-		path_found = pf.FindPath(v);
+		/* Find the path over the water regions first. When the destination is far away, the search below
+		 * only has to find the path to a water region a few regions ahead, instead of all the way. */
+		const std::vector<WaterRegionPatchDesc> high_level_path = YapfShipFindWaterRegionPath(v, tile, NUMBER_OF_WATER_REGIONS_LOOKAHEAD + 1);
+		const bool is_intermediate_destination = (int)high_level_path.size() >= NUMBER_OF_WATER_REGIONS_LOOKAHEAD + 1;
+
+		/* The first attempt is not restricted to the water regions of the high level path, as that gives more natural paths.
+		 * When it fails, for example because of maze-like terrain or long aqueducts, the search is restricted to those regions. */
+		const int attempts = is_intermediate_destination ? 2 : 1;
+		for (int attempt = 0; attempt < attempts; attempt++) {
+			/* create pathfinder instance */
+			Tpf pf;
+			/* set origin and destination nodes */
+			pf.SetOrigin(src_tile, trackdirs);
+			pf.SetDestination(v);
+			if (is_intermediate_destination) pf.SetIntermediateDestination(high_level_path.back());
+			if (attempt > 0) pf.RestrictSearch(high_level_path);
+			/* find best path */
+			path_found = pf.FindPath(v);
+			if (!path_found && attempt + 1 < attempts) continue;
+
+			return ExtractPath(pf, tile, path_found, is_intermediate_destination, path_cache);
+		}
+		NOT_REACHED();
+	}
 
+	/**
+	 * Fill the path cache from the result of a search, and return the first trackdir of the path.
+	 * @param pf The pathfinder that finished its search.
+	 * @param tile The tile the ship is about to enter.
+	 * @param path_found Whether the search reached its destination.
+	 * @param is_intermediate_destination Whether the search was only to an intermediate destination.
+	 * @param path_cache The path cache of the ship.
+	 * @return The trackdir for \a tile, or #INVALID_TRACKDIR when no path was found.
+	 */
+	static Trackdir ExtractPath(Tpf &pf, TileIndex tile, bool path_found, bool is_intermediate_destination, ShipPathCache &path_cache)
+	{
 		Trackdir next_trackdir = INVALID_TRACKDIR; // this would mean "path not found"
 
 		Node *pNode = pf.GetBestNode();
 		if (pNode != nullptr) {
 			uint steps = 0;
 			for (Node *n = pNode; n->m_parent != nullptr; n = n->m_parent) steps++;
+			/* Skip tiles at the end of the path near the destination, but not near an intermediate destination
+			 * as the path towards it will be searched again from further along anyway. */
 			uint skip = 0;
-			if (path_found) skip = YAPF_SHIP_PATH_CACHE_LENGTH / 2;
+			if (path_found && !is_intermediate_destination) skip = YAPF_SHIP_PATH_CACHE_LENGTH / 2;
 
 			/* walk through the path back to the origin */
 			Node *pPrevNode = nullptr;
@@ -192,7 +266,7 @@ public:
 			assert(best_next_node.GetTile() == tile);
 			next_trackdir = best_next_node.GetTrackdir();
 			/* remove last element for the special case when tile == dest_tile */
-			if (path_found && !path_cache.empty()) path_cache.pop_back();
+			if (path_found && !is_intermediate_destination && !path_cache.empty()) path_cache.pop_back();
 		}
 		return next_trackdir;
 	}
@@ -350,6 +424,8 @@ static inline bool RequireTrackdirKey()
 /** Ship controller helper - path finder invoker */
 Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache)
 {
+	PathfinderProfileScope profile(PFCS_SHIP_CHOOSE_TRACK, v, tile);
+
 	/* default is YAPF type 2 */
 	typedef Trackdir (*PfnChooseShipTrack)(const Ship*, TileIndex, DiagDirection, TrackBits, bool &path_found, ShipPathCache &path_cache);
 	PfnChooseShipTrack pfnChooseShipTrack = CYapfShip2::ChooseShipTrack; // default: ExitDir
@@ -360,11 +436,14 @@ Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir,
 	}
 
 	Trackdir td_ret = pfnChooseShipTrack(v, tile, enterdir, tracks, path_found, path_cache);
+	profile.SetResult(path_found);
 	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : INVALID_TRACK;
 }
 
 bool YapfShipCheckReverse(const Ship *v)
 {
+	PathfinderProfileScope profile(PFCS_SHIP_CHECK_REVERSE, v, v->tile);
+
 	Trackdir td = v->GetVehicleTrackdir();
 	Trackdir td_rev = ReverseTrackdir(td);
 	TileIndex tile = v->tile;
@@ -378,6 +457,7 @@ bool YapfShipCheckReverse(const Ship *v)
 	}
 
 	bool reverse = pfnCheckReverseShip(v, tile, td, td_rev);
+	profile.SetResult(reverse);
 
 	return reverse;
 }
@@ -0,0 +1,184 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_ship_regions.cpp Implementation of YAPF for water regions, which are used for finding intermediate ship destinations. */
+
+#include "../../stdafx.h"
+#include "../../ship.h"
+#include "../../station_base.h"
+
+#include "yapf.hpp"
+#include "yapf_ship_regions.h"
+
+#include "../../safeguards.h"
+
+static const int MAX_NUMBER_OF_NODES = 65536; ///< Maximum number of water region patches that are examined by one search.
+
+/** Yapf Node Key that represents a single patch of interconnected water within a water region. */
+struct CYapfRegionPatchNodeKey {
+	WaterRegionPatchDesc m_water_region_patch;
+
+	inline void Set(const WaterRegionPatchDesc &water_region_patch)
+	{
+		m_water_region_patch = water_region_patch;
+	}
+
+	inline int CalcHash() const
+	{
+		return CalculateWaterRegionPatchHash(m_water_region_patch);
+	}
+
+	inline bool operator==(const CYapfRegionPatchNodeKey &other) const
+	{
+		return m_water_region_patch == other.m_water_region_patch;
+	}
+};
+
+/** Manhattan distance between two water regions, in regions. */
+static inline int ManhattanDistance(const WaterRegionPatchDesc &a, const WaterRegionPatchDesc &b)
+{
+	return abs(a.x - b.x) + abs(a.y - b.y);
+}
+
+/** Yapf Node for water region patches. */
+struct CYapfRegionNodeT {
+	typedef CYapfRegionPatchNodeKey Key;
+	typedef CYapfRegionNodeT Node;
+
+	Key   m_key;
+	uint  m_heap_index;
+	Node *m_parent;
+	int   m_cost;
+	int   m_estimate;
+
+	inline void Set(Node *parent, const WaterRegionPatchDesc &water_region_patch)
+	{
+		m_key.Set(water_region_patch);
+		m_parent = parent;
+		m_cost = 0;
+		m_estimate = 0;
+	}
+
+	inline uint GetHeapIndex() const { return m_heap_index; }
+	inline void SetHeapIndex(uint index) { m_heap_index = index; }
+	inline const Key &GetKey() const { return m_key; }
+	inline const WaterRegionPatchDesc &GetWaterRegionPatch() const { return m_key.m_water_region_patch; }
+
+	inline bool operator<(const Node &other) const
+	{
+		return m_estimate < other.m_estimate;
+	}
+};
+
+typedef CNodeList_HashTableT<CYapfRegionNodeT, 12, 12> CRegionNodeListWater;
+
+/**
+ * Pathfinder over the water region patches of the map.
+ * The search runs backwards, from the patches of the destination of the ship towards the patch of
+ * the ship, so that following the parents of the node of the ship yields the path in travel order.
+ */
+class CYapfRegionWater {
+public:
+	typedef CYapfRegionNodeT Node;
+	typedef Node::Key Key;
+
+protected:
+	CRegionNodeListWater m_nodes;         ///< Open and closed nodes of the search.
+	WaterRegionPatchDesc m_origin_patch;  ///< Patch of the ship, which is the target of the backwards search.
+
+public:
+	explicit CYapfRegionWater(const WaterRegionPatchDesc &origin_patch) : m_origin_patch(origin_patch) {}
+
+	/**
+	 * Add a patch the ship may want to reach as start node of the search.
+	 * @param water_region_patch The patch.
+	 */
+	void AddDestinationPatch(const WaterRegionPatchDesc &water_region_patch)
+	{
+		if (water_region_patch.label == INVALID_WATER_REGION_PATCH) return;
+		if (m_nodes.FindOpenNode(Key{ water_region_patch }) != nullptr) return;
+
+		Node &node = *m_nodes.CreateNewNode();
+		node.Set(nullptr, water_region_patch);
+		node.m_estimate = ManhattanDistance(water_region_patch, m_origin_patch);
+		m_nodes.InsertOpenNode(node);
+	}
+
+	/**
+	 * Run the search.
+	 * @return The node of the patch of the ship, or \c nullptr when it could not be reached.
+	 */
+	Node *FindPath()
+	{
+		Node *node;
+		while ((node = m_nodes.PopBestOpenNode()) != nullptr) {
+			m_nodes.InsertClosedNode(*node);
+			if (node->GetWaterRegionPatch() == m_origin_patch) return node;
+			if (m_nodes.ClosedCount() >= MAX_NUMBER_OF_NODES) break;
+
+			VisitWaterRegionPatchNeighbors(node->GetWaterRegionPatch(), [&](const WaterRegionPatchDesc &neighbour) {
+				this->AddNeighbour(*node, neighbour);
+			});
+		}
+		return nullptr;
+	}
+
+protected:
+	void AddNeighbour(Node &parent, const WaterRegionPatchDesc &water_region_patch)
+	{
+		const Key key{ water_region_patch };
+		if (m_nodes.FindClosedNode(key) != nullptr) return;
+
+		/* Aqueducts may connect regions which are further apart. */
+		const int cost = parent.m_cost + ManhattanDistance(parent.GetWaterRegionPatch(), water_region_patch);
+
+		Node *open_node = m_nodes.FindOpenNode(key);
+		if (open_node != nullptr) {
+			if (open_node->m_cost <= cost) return;
+			m_nodes.PopOpenNode(key);
+		} else {
+			open_node = m_nodes.CreateNewNode();
+		}
+		open_node->Set(&parent, water_region_patch);
+		open_node->m_cost = cost;
+		open_node->m_estimate = cost + ManhattanDistance(water_region_patch, m_origin_patch);
+		m_nodes.InsertOpenNode(*open_node);
+	}
+};
+
+/**
+ * Finds a path over the water regions from the ship towards its destination.
+ * @param v The ship to find a path for.
+ * @param start_tile The tile the ship is about to enter.
+ * @param max_returned_path_length The maximum number of patches to return.
+ * @return The patches of the path, starting with the patch of \a start_tile; empty when no path was found.
+ */
+std::vector<WaterRegionPatchDesc> YapfShipFindWaterRegionPath(const Ship *v, TileIndex start_tile, int max_returned_path_length)
+{
+	std::vector<WaterRegionPatchDesc> path;
+
+	const WaterRegionPatchDesc start_patch = GetWaterRegionPatchInfo(start_tile);
+	if (start_patch.label == INVALID_WATER_REGION_PATCH) return path;
+
+	CYapfRegionWater pf(start_patch);
+	if (v->current_order.IsType(OT_GOTO_STATION)) {
+		const StationID station = v->current_order.GetDestination();
+		const Station *st = Station::GetIfValid(station);
+		if (st == nullptr) return path;
+		TILE_AREA_LOOP(tile, st->docking_station) {
+			if (IsDockingTile(tile) && IsShipDestinationTile(tile, station)) pf.AddDestinationPatch(GetWaterRegionPatchInfo(tile));
+		}
+	} else {
+		if (v->dest_tile == INVALID_TILE) return path;
+		pf.AddDestinationPatch(GetWaterRegionPatchInfo(v->dest_tile));
+	}
+
+	for (const CYapfRegionWater::Node *node = pf.FindPath(); node != nullptr && (int)path.size() < max_returned_path_length; node = node->m_parent) {
+		path.push_back(node->GetWaterRegionPatch());
+	}
+	return path;
+}
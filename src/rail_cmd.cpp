@@ -2519,6 +2519,8 @@ void MarkSingleSignalDirty(TileIndex tile, Trackdir td)
 		0,  // TRACKDIR_RVREV_NW
 	};
 
+	InvalidateLandscapeSpriteCacheTile(tile);
+
 	uint x, y;
 	GetSignalXY(tile, trackdir_to_pos[td], x, y);
 	Point pt = RemapCoords(x, y, GetSaveSlopeZ(x, y, TrackdirToTrack(td)));
@@ -3893,4 +3895,5 @@ extern const TileTypeProcs _tile_type_rail_procs = {
 	VehicleEnter_Track,       // vehicle_enter_tile_proc
 	GetFoundation_Track,      // get_foundation_proc
 	TerraformTile_Track,      // terraform_tile_proc
+	nullptr,                  // tile_loop_precheck_proc
 };
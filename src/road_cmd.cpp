@@ -580,6 +580,8 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 					TrackBits tracks = GetCrossingRailBits(tile);
 					bool reserved = HasCrossingReservation(tile);
 					MakeRailNormal(tile, GetTileOwner(tile), tracks, GetRailType(tile));
+					/* The tile is no road tile any more, without a road type having been set. */
+					YapfNotifyRoadLayoutChange(tile);
 					if (reserved) SetTrackReservation(tile, tracks);
 
 					/* Update rail count for level crossings. The plain track should still be accounted
@@ -2755,4 +2757,5 @@ extern const TileTypeProcs _tile_type_road_procs = {
 	VehicleEnter_Road,       // vehicle_enter_tile_proc
 	GetFoundation_Road,      // get_foundation_proc
 	TerraformTile_Road,      // terraform_tile_proc
+	nullptr,                 // tile_loop_precheck_proc
 };
@@ -15,6 +15,7 @@
 #include "rail_type.h"
 #include "road_func.h"
 #include "tile_map.h"
+#include "pathfinder/yapf/yapf_cache.h"
 
 
 /** The different types of road tiles. */
@@ -161,6 +162,7 @@ static inline void SetRoadBits(TileIndex t, RoadBits r, RoadTramType rtt)
 	} else {
 		SB(_m[t].m5, 0, 4, r);
 	}
+	YapfNotifyRoadLayoutChange(t);
 }
 
 static inline RoadType GetRoadTypeRoad(TileIndex t)
@@ -318,6 +320,7 @@ static inline void SetDisallowedRoadDirections(TileIndex t, DisallowedRoadDirect
 	assert_tile(IsNormalRoad(t), t);
 	assert(drd < DRD_END);
 	SB(_m[t].m5, 4, 2, drd);
+	YapfNotifyRoadLayoutChange(t);
 }
 
 /**
@@ -551,6 +554,7 @@ static inline void StartRoadWorks(TileIndex t)
 		case ROADSIDE_GRASS:  SetRoadside(t, ROADSIDE_GRASS_ROAD_WORKS); break;
 		default:              SetRoadside(t, ROADSIDE_PAVED_ROAD_WORKS); break;
 	}
+	YapfNotifyRoadLayoutChange(t);
 }
 
 /**
@@ -564,6 +568,7 @@ static inline void TerminateRoadWorks(TileIndex t)
 	SetRoadside(t, (Roadside)(GetRoadside(t) - ROADSIDE_GRASS_ROAD_WORKS + ROADSIDE_GRASS));
 	/* Stop the counter */
 	SB(_me[t].m7, 0, 4, 0);
+	YapfNotifyRoadLayoutChange(t);
 }
 
 
@@ -591,6 +596,7 @@ static inline void SetRoadTypeRoad(TileIndex t, RoadType rt)
 	assert(MayHaveRoad(t));
 	assert(rt == INVALID_ROADTYPE || RoadTypeIsRoad(rt));
 	SB(_m[t].m4, 0, 6, rt);
+	YapfNotifyRoadLayoutChange(t);
 }
 
 /**
@@ -603,6 +609,7 @@ static inline void SetRoadTypeTram(TileIndex t, RoadType rt)
 	assert(MayHaveRoad(t));
 	assert(rt == INVALID_ROADTYPE || RoadTypeIsTram(rt));
 	SB(_me[t].m8, 6, 6, rt);
+	YapfNotifyRoadLayoutChange(t);
 }
 
 /**
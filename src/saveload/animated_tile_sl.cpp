@@ -11,6 +11,7 @@
 #include "../tile_type.h"
 #include "../core/alloc_func.hpp"
 #include "../core/smallvec_type.hpp"
+#include "../animated_tile_func.h"
 
 #include "saveload.h"
 
@@ -23,6 +24,7 @@ extern std::vector<TileIndex> _animated_tiles;
  */
 static void Save_ANIT()
 {
+	CompactAnimatedTiles();
 	SlSetLength(_animated_tiles.size() * sizeof(_animated_tiles.front()));
 	SlArray(_animated_tiles.data(), _animated_tiles.size(), SLE_UINT32);
 }
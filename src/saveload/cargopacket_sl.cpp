@@ -133,6 +133,9 @@ const SaveLoad *GetCargoPacketDesc()
  */
 static void Save_CAPA()
 {
+	/* Vehicles defer aging their cargo until it is next accessed, apply it before saving the packets. */
+	for (Vehicle *v : Vehicle::Iterate()) v->cargo.ApplyPendingAging();
+
 	std::vector<SaveLoad> filtered_packet_desc = SlFilterObject(GetCargoPacketDesc());
 	for (CargoPacket *cp : CargoPacket::Iterate()) {
 		SlSetArrayIndex(cp->index);
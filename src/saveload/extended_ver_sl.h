@@ -81,6 +81,7 @@ enum SlXvFeatureIndex {
 	XSLFI_STATION_GOODS_EXTRA,                    ///< Extra station goods entry statuses
 	XSLFI_DOCKING_CACHE_VER,                      ///< Multiple docks - docking tile cache version
 	XSLFI_EXTRA_CHEATS,                           ///< Extra cheats
+	XSLFI_CHUNK_TABLE_OF_CONTENTS,                ///< Table of contents of the chunks
 
 	XSLFI_RIFF_HEADER_60_BIT,                     ///< Size field in RIFF chunk header is 60 bit
 	XSLFI_HEIGHT_8_BIT,                           ///< Map tile height is 8 bit instead of 4 bit, but savegame version may be before this became true in trunk
@@ -13,7 +13,9 @@
 #include "../core/endian_func.hpp"
 #include "../core/endian_type.hpp"
 #include "../fios.h"
+#include "../worker_thread.h"
 #include <array>
+#include <vector>
 
 #include "saveload.h"
 #include "saveload_buffer.h"
@@ -212,6 +214,32 @@ static void Load_MAP8()
 	}
 }
 
+/** Number of tiles of the WMAP chunk which are read and then decoded together. */
+static const uint WMAP_DECODE_SLICE_TILES = 1 << 20;
+
+/**
+ * Read a part of the WMAP chunk, which holds a record of the same size for each tile,
+ * and decode the records in parallel batches on the worker threads.
+ * @param reader The read buffer.
+ * @param record_size The size of the record of a tile.
+ * @param decode Procedure to decode the record of a tile.
+ */
+template <typename F>
+static void LoadWMAPRecords(ReadBuffer *reader, uint record_size, F decode)
+{
+	std::vector<byte> buf;
+	const TileIndex size = MapSize();
+
+	for (TileIndex start = 0; start < size; start += WMAP_DECODE_SLICE_TILES) {
+		const uint count = min<uint>(size - start, WMAP_DECODE_SLICE_TILES);
+		buf.resize((size_t)count * record_size);
+		reader->CopyBytes(buf.data(), buf.size());
+		RunParallelFor(_general_worker_pool, count, 16384, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) decode(start + (TileIndex)i, buf.data() + i * record_size);
+		});
+	}
+}
+
 static void Load_WMAP()
 {
 	assert_compile(sizeof(Tile) == 8);
@@ -219,43 +247,35 @@ static void Load_WMAP()
 	assert(_sl_xv_feature_versions[XSLFI_WHOLE_MAP_CHUNK] == 1 || _sl_xv_feature_versions[XSLFI_WHOLE_MAP_CHUNK] == 2);
 
 	ReadBuffer *reader = ReadBuffer::GetCurrent();
-	const TileIndex size = MapSize();
 
 #if TTD_ENDIAN == TTD_LITTLE_ENDIAN
-	reader->CopyBytes((byte *) _m, size * 8);
+	reader->CopyBytes((byte *) _m, MapSize() * 8);
 #else
-	for (TileIndex i = 0; i != size; i++) {
-		reader->CheckBytes(8);
-		_m[i].type = reader->RawReadByte();
-		_m[i].height = reader->RawReadByte();
-		uint16 m2 = reader->RawReadByte();
-		m2 |= ((uint16) reader->RawReadByte()) << 8;
-		_m[i].m2 = m2;
-		_m[i].m1 = reader->RawReadByte();
-		_m[i].m3 = reader->RawReadByte();
-		_m[i].m4 = reader->RawReadByte();
-		_m[i].m5 = reader->RawReadByte();
-	}
+	LoadWMAPRecords(reader, 8, [](TileIndex t, const byte *r) {
+		_m[t].type = r[0];
+		_m[t].height = r[1];
+		_m[t].m2 = r[2] | (r[3] << 8);
+		_m[t].m1 = r[4];
+		_m[t].m3 = r[5];
+		_m[t].m4 = r[6];
+		_m[t].m5 = r[7];
+	});
 #endif
 
 	if (_sl_xv_feature_versions[XSLFI_WHOLE_MAP_CHUNK] == 1) {
-		for (TileIndex i = 0; i != size; i++) {
-			reader->CheckBytes(2);
-			_me[i].m6 = reader->RawReadByte();
-			_me[i].m7 = reader->RawReadByte();
-		}
+		LoadWMAPRecords(reader, 2, [](TileIndex t, const byte *r) {
+			_me[t].m6 = r[0];
+			_me[t].m7 = r[1];
+		});
 	} else if (_sl_xv_feature_versions[XSLFI_WHOLE_MAP_CHUNK] == 2) {
 #if TTD_ENDIAN == TTD_LITTLE_ENDIAN
-		reader->CopyBytes((byte *) _me, size * 4);
+		reader->CopyBytes((byte *) _me, MapSize() * 4);
 #else
-		for (TileIndex i = 0; i != size; i++) {
-			reader->CheckBytes(4);
-			_me[i].m6 = reader->RawReadByte();
-			_me[i].m7 = reader->RawReadByte();
-			uint16 m8 = reader->RawReadByte();
-			m8 |= ((uint16) reader->RawReadByte()) << 8;
-			_me[i].m8 = m8;
-		}
+		LoadWMAPRecords(reader, 4, [](TileIndex t, const byte *r) {
+			_me[t].m6 = r[0];
+			_me[t].m7 = r[1];
+			_me[t].m8 = r[2] | (r[3] << 8);
+		});
 #endif
 	} else {
 		NOT_REACHED();
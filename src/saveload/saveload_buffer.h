@@ -40,6 +40,16 @@ struct ReadBuffer {
 	{
 	}
 
+	/**
+	 * Initialise our variables to read data which is already in memory, before reading from the filter.
+	 * @param data The data, which must remain valid while it is read.
+	 * @param length The length of the data.
+	 * @param reader The filter to read the data following it.
+	 */
+	ReadBuffer(byte *data, size_t length, LoadFilter *reader) : bufp(data), bufe(data + length), reader(reader), read(length)
+	{
+	}
+
 	static ReadBuffer *GetCurrent();
 
 	void SkipBytesSlowPath(size_t bytes);
@@ -214,6 +224,20 @@ struct MemoryDumper {
 		*this->buf++ = b;
 	}
 
+	/**
+	 * Reserve space in the dump, which is written to later.
+	 * @param bytes The number of bytes to reserve, at most #MEMORY_CHUNK_SIZE.
+	 * @return The reserved space.
+	 */
+	inline byte *ReserveBytes(size_t bytes)
+	{
+		assert(bytes <= MEMORY_CHUNK_SIZE);
+		this->CheckBytes(bytes);
+		byte *ptr = this->buf;
+		this->buf += bytes;
+		return ptr;
+	}
+
 	inline void RawWriteUint16(uint16 v)
 	{
 #if OTTD_ALIGNMENT == 0
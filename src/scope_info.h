@@ -21,7 +21,7 @@ struct Window;
 
 #ifdef USE_SCOPE_INFO
 
-extern std::vector<std::function<int(char *, const char *)>> _scope_stack;
+extern thread_local std::vector<std::function<int(char *, const char *)>> _scope_stack; ///< Per thread, such that threads other than the main thread can use SCOPE_INFO_FMT too.
 
 struct scope_info_func_obj {
 	scope_info_func_obj(std::function<int(char *, const char *)> func)
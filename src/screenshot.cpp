@@ -27,9 +27,12 @@
 #include "landscape.h"
 #include "smallmap_colours.h"
 #include "smallmap_gui.h"
+#include "worker_thread.h"
 
 #include "table/strings.h"
 
+#include <atomic>
+
 #include "safeguards.h"
 
 static const char * const SCREENSHOT_NAME = "screenshot"; ///< Default filename of a saved screenshot.
@@ -630,8 +633,6 @@ static void CurrentScreenCallback(void *userdata, void *buf, uint y, uint pitch,
 static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
 {
 	ViewPort *vp = (ViewPort *)userdata;
-	DrawPixelInfo dpi, *old_dpi;
-	int wx, left;
 
 	/* We are no longer rendering to the screen */
 	DrawPixelInfo old_screen = _screen;
@@ -643,32 +644,36 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 	_screen.pitch = pitch;
 	_screen_disable_anim = true;
 
-	old_dpi = _cur_dpi;
-	_cur_dpi = &dpi;
-
-	dpi.dst_ptr = buf;
-	dpi.height = n;
-	dpi.width = vp->width;
-	dpi.pitch = pitch;
-	dpi.zoom = ZOOM_LVL_WORLD_SCREENSHOT;
-	dpi.left = 0;
-	dpi.top = y;
-
-	/* Render viewport in blocks of 1600 pixels width */
-	left = 0;
-	while (vp->width - left != 0) {
-		wx = min(vp->width - left, 1600);
-		left += wx;
-
-		ViewportDoDraw(vp,
-			ScaleByZoom(left - wx - vp->left, vp->zoom) + vp->virtual_left,
-			ScaleByZoom(y - vp->top, vp->zoom) + vp->virtual_top,
-			ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left,
-			ScaleByZoom((y + n) - vp->top, vp->zoom) + vp->virtual_top
-		);
-	}
+	/* Render viewport in blocks of 1600 pixels width. The blocks do not overlap, so they are drawn in parallel;
+	 * the caller has to allow this with BeginViewportParallelDraw(). */
+	const uint blocks = CeilDiv(vp->width, 1600);
+	RunParallelFor(_general_worker_pool, blocks, 1, [&](size_t begin, size_t end) {
+		DrawPixelInfo dpi;
+		DrawPixelInfo *old_dpi = _cur_dpi;
+		_cur_dpi = &dpi;
+
+		dpi.dst_ptr = buf;
+		dpi.height = n;
+		dpi.width = vp->width;
+		dpi.pitch = pitch;
+		dpi.zoom = ZOOM_LVL_WORLD_SCREENSHOT;
+		dpi.left = 0;
+		dpi.top = y;
+
+		for (size_t block = begin; block < end; block++) {
+			const int left = (int)block * 1600;
+			const int right = min<int>(vp->width, left + 1600);
+
+			ViewportDoDraw(vp,
+				ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left,
+				ScaleByZoom(y - vp->top, vp->zoom) + vp->virtual_top,
+				ScaleByZoom(right - vp->left, vp->zoom) + vp->virtual_left,
+				ScaleByZoom((y + n) - vp->top, vp->zoom) + vp->virtual_top
+			);
+		}
 
-	_cur_dpi = old_dpi;
+		_cur_dpi = old_dpi;
+	});
 
 	/* Switch back to rendering to the screen */
 	_screen = old_screen;
@@ -677,6 +682,23 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 	ClearViewPortCache(vp);
 }
 
+/**
+ * Generate the name of a screenshot, without extension, if none was given.
+ * @param default_fn Default filename.
+ * @return True if the name was generated.
+ */
+static bool GenerateScreenshotName(const char *default_fn)
+{
+	if (!StrEmpty(_screenshot_name)) return false;
+
+	if (_game_mode == GM_EDITOR || _game_mode == GM_MENU || _local_company == COMPANY_SPECTATOR) {
+		strecpy(_screenshot_name, default_fn, lastof(_screenshot_name));
+	} else {
+		GenerateDefaultSaveName(_screenshot_name, lastof(_screenshot_name));
+	}
+	return true;
+}
+
 /**
  * Construct a pathname for a screenshot file.
  * @param default_fn Default filename.
@@ -686,15 +708,7 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
  */
 static const char *MakeScreenshotName(const char *default_fn, const char *ext, bool crashlog = false)
 {
-	bool generate = StrEmpty(_screenshot_name);
-
-	if (generate) {
-		if (_game_mode == GM_EDITOR || _game_mode == GM_MENU || _local_company == COMPANY_SPECTATOR) {
-			strecpy(_screenshot_name, default_fn, lastof(_screenshot_name));
-		} else {
-			GenerateDefaultSaveName(_screenshot_name, lastof(_screenshot_name));
-		}
-	}
+	bool generate = GenerateScreenshotName(default_fn);
 
 	/* Add extension to screenshot file */
 	size_t len = strlen(_screenshot_name);
@@ -749,7 +763,8 @@ void SetupScreenshotViewport(ScreenshotType t, ViewPort *vp)
 			vp->overlay = w->viewport->overlay;
 			break;
 		}
-		case SC_WORLD: {
+		case SC_WORLD:
+		case SC_WORLD_TILES: {
 			/* Determine world coordinates of screenshot */
 			vp->zoom = ZOOM_LVL_WORLD_SCREENSHOT;
 
@@ -806,8 +821,119 @@ static bool MakeLargeWorldScreenshot(ScreenshotType t)
 	SetupScreenshotViewport(t, &vp);
 
 	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
-	return sf->proc(MakeScreenshotName(SCREENSHOT_NAME, sf->extension), LargeWorldCallback, &vp, vp.width, vp.height,
+	BeginViewportParallelDraw();
+	bool ret = sf->proc(MakeScreenshotName(SCREENSHOT_NAME, sf->extension), LargeWorldCallback, &vp, vp.width, vp.height,
 			BlitterFactory::GetCurrentBlitter()->GetScreenDepth(), _cur_palette.palette);
+	EndViewportParallelDraw();
+	return ret;
+}
+
+static const uint SCREENSHOT_TILE_SIZE = 256; ///< Width and height of the images of a tiled world screenshot.
+
+/** An image of a tiled world screenshot, rendered into memory. */
+struct ScreenshotTile {
+	const byte *buf; ///< The rendered image.
+	uint bpp;        ///< Bytes per pixel of the rendered image.
+};
+
+/**
+ * Callback of the screenshot generator that copies a rendered image of a tiled world screenshot.
+ * @see ScreenshotCallback
+ */
+static void ScreenshotTileCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+{
+	const ScreenshotTile *tile = (const ScreenshotTile *)userdata;
+	memcpy(buf, tile->buf + y * pitch * tile->bpp, n * pitch * tile->bpp);
+}
+
+/**
+ * Make a screenshot of the whole map as square images in a z/x/y directory structure, as used by web map viewers.
+ * Only the most detailed zoom level z is made, at which the map is 2^z images wide or high.
+ * The images are rendered and written in parallel, each thread only needs the memory of one image.
+ * @return true on success
+ */
+static bool MakeTiledWorldScreenshot()
+{
+	ViewPort vp;
+	SetupScreenshotViewport(SC_WORLD_TILES, &vp);
+
+	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
+	const int depth = BlitterFactory::GetCurrentBlitter()->GetScreenDepth();
+	if (depth == 0) return false;
+	const uint bpp = depth / 8;
+
+	const uint columns = CeilDiv(vp.width, SCREENSHOT_TILE_SIZE);
+	const uint rows = CeilDiv(vp.height, SCREENSHOT_TILE_SIZE);
+	uint zoom = 0;
+	while ((1U << zoom) < max(columns, rows)) zoom++;
+
+	GenerateScreenshotName(SCREENSHOT_NAME);
+	char dir[MAX_PATH];
+	if (seprintf(dir, lastof(dir), "%s%s" PATHSEP "%u" PATHSEP, FiosGetScreenshotDir(), _screenshot_name, zoom) >= (int)lengthof(dir) - 32) {
+		DEBUG(misc, 0, "Can't make a tiled world screenshot, the path of its directory is too long: %s", dir);
+		return false;
+	}
+	for (uint x = 0; x < columns; x++) {
+		char column_dir[MAX_PATH];
+		seprintf(column_dir, lastof(column_dir), "%s%u", dir, x);
+		FioCreateDirectory(column_dir);
+	}
+
+	/* We are no longer rendering to the screen */
+	DrawPixelInfo old_screen = _screen;
+	bool old_disable_anim = _screen_disable_anim;
+
+	_screen.dst_ptr = nullptr;
+	_screen.width = SCREENSHOT_TILE_SIZE;
+	_screen.height = SCREENSHOT_TILE_SIZE;
+	_screen.pitch = SCREENSHOT_TILE_SIZE;
+	_screen_disable_anim = true;
+
+	std::atomic<bool> ret(true);
+	BeginViewportParallelDraw();
+	RunParallelFor(_general_worker_pool, (size_t)columns * rows, 1, [&](size_t begin, size_t end) {
+		std::vector<byte> buf(SCREENSHOT_TILE_SIZE * SCREENSHOT_TILE_SIZE * bpp);
+		DrawPixelInfo dpi;
+		DrawPixelInfo *old_dpi = _cur_dpi;
+		_cur_dpi = &dpi;
+
+		for (size_t i = begin; i < end; i++) {
+			const uint x = (uint)(i % columns);
+			const uint y = (uint)(i / columns);
+			const int left = x * SCREENSHOT_TILE_SIZE;
+			const int top = y * SCREENSHOT_TILE_SIZE;
+
+			std::fill(buf.begin(), buf.end(), 0);
+			dpi.dst_ptr = buf.data();
+			dpi.left = left;
+			dpi.top = top;
+			dpi.width = SCREENSHOT_TILE_SIZE;
+			dpi.height = SCREENSHOT_TILE_SIZE;
+			dpi.pitch = SCREENSHOT_TILE_SIZE;
+			dpi.zoom = ZOOM_LVL_WORLD_SCREENSHOT;
+
+			ViewportDoDraw(&vp,
+				ScaleByZoom(left - vp.left, vp.zoom) + vp.virtual_left,
+				ScaleByZoom(top - vp.top, vp.zoom) + vp.virtual_top,
+				ScaleByZoom(left + SCREENSHOT_TILE_SIZE - vp.left, vp.zoom) + vp.virtual_left,
+				ScaleByZoom(top + SCREENSHOT_TILE_SIZE - vp.top, vp.zoom) + vp.virtual_top
+			);
+
+			char name[MAX_PATH];
+			seprintf(name, lastof(name), "%s%u" PATHSEP "%u.%s", dir, x, y, sf->extension);
+			ScreenshotTile tile = { buf.data(), bpp };
+			if (!sf->proc(name, ScreenshotTileCallback, &tile, SCREENSHOT_TILE_SIZE, SCREENSHOT_TILE_SIZE, depth, _cur_palette.palette)) ret = false;
+		}
+
+		_cur_dpi = old_dpi;
+	});
+	EndViewportParallelDraw();
+
+	/* Switch back to rendering to the screen */
+	_screen = old_screen;
+	_screen_disable_anim = old_disable_anim;
+
+	return ret;
 }
 
 /**
@@ -943,6 +1069,10 @@ bool MakeScreenshot(ScreenshotType t, const char *name)
 			ret = MakeLargeWorldScreenshot(t);
 			break;
 
+		case SC_WORLD_TILES:
+			ret = MakeTiledWorldScreenshot();
+			break;
+
 		case SC_HEIGHTMAP: {
 			const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
 			ret = MakeHeightmapScreenshot(MakeScreenshotName(HEIGHTMAP_NAME, sf->extension));
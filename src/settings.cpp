@@ -70,6 +70,7 @@
 #include "void_map.h"
 #include "station_base.h"
 #include "infrastructure_func.h"
+#include "worker_thread.h"
 
 #if defined(WITH_FREETYPE) || defined(_WIN32)
 #define HAS_TRUETYPE_FONT
@@ -1486,6 +1487,12 @@ static bool CheckSharingAir(int32 p1)
 	return CheckSharingChangePossible(VEH_AIRCRAFT);
 }
 
+static bool WorkerThreadsChanged(int32 p1)
+{
+	if (!RestartGeneralWorkerPool()) ShowErrorMessage(STR_CONFIG_SETTING_WORKER_THREADS_PENDING, INVALID_STRING_ID, WL_INFO);
+	return true;
+}
+
 static bool MaxVehiclesChanged(int32 p1)
 {
 	InvalidateWindowClassesData(WC_BUILD_TOOLBAR);
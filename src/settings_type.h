@@ -187,6 +187,7 @@ struct GUISettings : public TimeSettings {
 	bool   show_train_weight_ratios_in_details;   ///< show train weight ratios in vehicle details window top widget
 	bool   show_vehicle_group_in_details;    ///< show vehicle group in vehicle details window top widget
 	bool   show_restricted_signal_default;   ///< Show restricted electric signals using the default sprite
+	bool   cache_viewport_landscape;         ///< Keep the sprites of the drawn tiles to replay them on the next redraw
 	bool   show_adv_tracerestrict_features;  ///< Show advanced trace restrict features in UI
 	bool   show_progsig_ui;                  ///< Show programmable pre-signals feature in UI
 	bool   show_veh_list_cargo_filter;       ///< Show cargo list filter in UI
@@ -331,6 +332,11 @@ struct NetworkSettings {
 	bool   no_http_content_downloads;                     ///< do not do content downloads over HTTP
 };
 
+/** Settings related to the use of worker threads. */
+struct ThreadingSettings {
+	uint8  worker_threads;                                ///< number of threads used for parallel processing, including the main thread (0 = automatic)
+};
+
 /** Settings related to the creation of games. */
 struct GameCreationSettings {
 	uint32 generation_seed;                  ///< noise seed for world generation
@@ -477,6 +483,7 @@ struct YAPFSettings {
 	uint32 rail_pbs_station_penalty;         ///< penalty for crossing a reserved station tile
 	uint32 rail_pbs_signal_back_penalty;     ///< penalty for passing a pbs signal from the backside
 	uint32 rail_doubleslip_penalty;          ///< penalty for passing a double slip switch
+	bool   rail_use_destination_trees;       ///< use shared reverse search trees of the destination stations as cost estimate
 
 	uint32 rail_longer_platform_penalty;           ///< penalty for longer  station platform than train
 	uint32 rail_longer_platform_per_tile_penalty;  ///< penalty for longer  station platform than train (per tile)
@@ -687,6 +694,7 @@ struct ClientSettings {
 	SoundSettings        sound;              ///< sound effect settings
 	MusicSettings        music;              ///< settings related to music/sound
 	NewsSettings         news_display;       ///< news display settings.
+	ThreadingSettings    threading;          ///< worker thread settings
 };
 
 /** The current settings for this game. */
@@ -30,6 +30,7 @@
 #include "table/strings.h"
 
 #include <bitset>
+#include <memory>
 
 #include "safeguards.h"
 
@@ -644,6 +645,174 @@ void SmallMapWindow::SetZoomLevel(ZoomLevelChange change, const Point *zoom_pt)
 	}
 }
 
+/**
+ * Persistent colours of the smallmap pixels of one #SmallMapType, by group of tiles shown as one pixel.
+ * The colours are filled in lazily by drawing the smallmap, and forgotten when a tile of the group changes,
+ * such that refreshing the smallmap only has to look at the tiles which changed since the previous refresh.
+ */
+struct SmallMapColourCache {
+	static const uint SHIFT = 6;         ///< Log2 of the number of tile groups along the edges of a block.
+	static const uint MAX_BLOCKS = 1024; ///< Number of blocks after which the cache is emptied at the next draw.
+
+	/** Colours of a square of tile groups. */
+	struct Block {
+		uint64 valid[(1 << (2 * SHIFT)) / 64]; ///< Bitmask of the tile groups with a known colour.
+		uint32 colours[1 << (2 * SHIFT)];      ///< Colour, by tile group.
+
+		Block() { memset(this->valid, 0, sizeof(this->valid)); }
+	};
+
+	std::vector<std::unique_ptr<Block>> blocks; ///< Blocks of colours, allocated when first drawn.
+	uint blocks_x;   ///< Number of blocks in x direction.
+	uint allocated;  ///< Number of allocated blocks.
+	uint64 signature; ///< Signature of the settings the colours were computed with.
+	uint zoom;       ///< Number of tiles along the edges of a tile group.
+	uint phase_x;    ///< X coordinate of the first tile of the groups, modulo #zoom.
+	uint phase_y;    ///< Y coordinate of the first tile of the groups, modulo #zoom.
+
+	SmallMapColourCache() : blocks_x(0), allocated(0), signature(0), zoom(0), phase_x(0), phase_y(0) {}
+
+	void Clear()
+	{
+		for (auto &block : this->blocks) block.reset();
+		this->allocated = 0;
+	}
+
+	/**
+	 * Make the cache ready for drawing, emptying it when the tile groups or the colour settings have changed.
+	 * @param signature Signature of the current colour settings.
+	 * @param zoom Number of tiles along the edges of a tile group.
+	 * @param phase_x X coordinate of the first tile of a tile group, modulo \a zoom.
+	 * @param phase_y Y coordinate of the first tile of a tile group, modulo \a zoom.
+	 */
+	void Prepare(uint64 signature, uint zoom, uint phase_x, uint phase_y)
+	{
+		const uint blocks_x = (MapSizeX() / zoom + 1) / (1 << SHIFT) + 1;
+		const uint blocks_y = (MapSizeY() / zoom + 1) / (1 << SHIFT) + 1;
+		if (this->blocks_x != blocks_x || this->blocks.size() != blocks_x * blocks_y || this->zoom != zoom ||
+				this->phase_x != phase_x || this->phase_y != phase_y) {
+			this->Clear();
+			std::vector<std::unique_ptr<Block>>(blocks_x * blocks_y).swap(this->blocks);
+			this->blocks_x = blocks_x;
+			this->zoom = zoom;
+			this->phase_x = phase_x;
+			this->phase_y = phase_y;
+		} else if (this->signature != signature || this->allocated >= MAX_BLOCKS) {
+			this->Clear();
+		}
+		this->signature = signature;
+	}
+
+	/**
+	 * Get the colour of the tile group starting at a tile, computing and storing it when it is not known yet.
+	 * @param xc X coordinate of the first tile of the group.
+	 * @param yc Y coordinate of the first tile of the group.
+	 * @param compute Functor computing the colour.
+	 * @return The colour.
+	 * @pre The cache is prepared and (\a xc, \a yc) is a tile on the map.
+	 */
+	template <typename F>
+	inline uint32 GetColour(uint xc, uint yc, F compute)
+	{
+		const uint gx = (xc - this->phase_x) / this->zoom;
+		const uint gy = (yc - this->phase_y) / this->zoom;
+		std::unique_ptr<Block> &block = this->blocks[(gy >> SHIFT) * this->blocks_x + (gx >> SHIFT)];
+		if (!block) {
+			if (this->allocated >= MAX_BLOCKS) return compute();
+			block.reset(new Block());
+			this->allocated++;
+		}
+
+		const uint mask = (1 << SHIFT) - 1;
+		const uint slot = ((gy & mask) << SHIFT) | (gx & mask);
+		const uint64 bit = (uint64)1 << (slot & 63);
+		if (block->valid[slot >> 6] & bit) return block->colours[slot];
+
+		const uint32 colour = compute();
+		block->colours[slot] = colour;
+		block->valid[slot >> 6] |= bit;
+		return colour;
+	}
+
+	/**
+	 * Forget the colour of the tile group containing a tile.
+	 * @param tile The changed tile.
+	 */
+	void InvalidateTile(TileIndex tile)
+	{
+		if (this->allocated == 0) return;
+		const uint tx = TileX(tile);
+		const uint ty = TileY(tile);
+		if (tx < this->phase_x || ty < this->phase_y) return;
+
+		const uint gx = (tx - this->phase_x) / this->zoom;
+		const uint gy = (ty - this->phase_y) / this->zoom;
+		const size_t index = (gy >> SHIFT) * this->blocks_x + (gx >> SHIFT);
+		if ((gx >> SHIFT) >= this->blocks_x || index >= this->blocks.size() || !this->blocks[index]) return;
+
+		const uint slot = ((gy & ((1 << SHIFT) - 1)) << SHIFT) | (gx & ((1 << SHIFT) - 1));
+		this->blocks[index]->valid[slot >> 6] &= ~((uint64)1 << (slot & 63));
+	}
+};
+
+/**
+ * Empty the smallmap colour caches of all map types.
+ */
+void ClearSmallMapColourCache()
+{
+	for (SmallMapColourCache &cache : SmallMapWindow::colour_caches) {
+		cache.Clear();
+		std::vector<std::unique_ptr<SmallMapColourCache::Block>>().swap(cache.blocks);
+		cache.blocks_x = 0;
+	}
+}
+
+/**
+ * Forget the smallmap colours of a changed tile.
+ * @param tile The changed tile.
+ */
+void InvalidateSmallMapColourCacheTile(TileIndex tile)
+{
+	for (SmallMapColourCache &cache : SmallMapWindow::colour_caches) cache.InvalidateTile(tile);
+}
+
+/**
+ * Get a signature of all the state, apart from the tiles, which the colours of the current map type depend on.
+ * @return The signature.
+ */
+uint64 SmallMapWindow::GetColourSignature() const
+{
+	/* FNV-1a */
+	uint64 signature = 0xCBF29CE484222325ULL;
+	auto add = [&](uint64 value) {
+		signature = (signature ^ value) * 0x100000001B3ULL;
+	};
+
+	add(_settings_client.gui.smallmap_land_colour);
+	add(_settings_game.construction.max_heightlevel);
+	add(_settings_game.construction.freeform_edges);
+	add(_settings_game.game_creation.landscape);
+	add(_smallmap_show_heightmap);
+	switch (this->map_type) {
+		case SMT_INDUSTRY:
+			for (const LegendAndColour &legend : _legend_from_industries) add(legend.show_on_map);
+			break;
+
+		case SMT_OWNER:
+			for (const LegendAndColour &legend : _legend_land_owners) {
+				add(legend.show_on_map);
+				add(legend.colour);
+				add(legend.company);
+				if (legend.end) break;
+			}
+			break;
+
+		default:
+			break;
+	}
+	return signature;
+}
+
 /**
  * Decide which colours to show to the user for a group of tiles.
  * @param ta Tile area to investigate.
@@ -736,9 +905,10 @@ inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
  * @param start_pos Position of first pixel to draw.
  * @param end_pos Position of last pixel to draw (exclusive).
  * @param blitter current blitter
+ * @param cache Colours of the tile groups of the current map type, or \c nullptr to compute all colours.
  * @note If pixel position is below \c 0, skip drawing.
  */
-void SmallMapWindow::DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch, int reps, int start_pos, int end_pos, Blitter *blitter) const
+void SmallMapWindow::DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch, int reps, int start_pos, int end_pos, Blitter *blitter, SmallMapColourCache *cache) const
 {
 	void *dst_ptr_abs_end = blitter->MoveTo(_screen.dst_ptr, 0, _screen.height);
 	uint min_xy = _settings_game.construction.freeform_edges ? 1 : 0;
@@ -762,7 +932,7 @@ void SmallMapWindow::DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch,
 		}
 		ta.ClampToMap(); // Clamp to map boundaries (may contain MP_VOID tiles!).
 
-		uint32 val = this->GetTileColours(ta);
+		uint32 val = (cache != nullptr) ? cache->GetColour(xc, yc, [&]() { return this->GetTileColours(ta); }) : this->GetTileColours(ta);
 		uint8 *val8 = (uint8 *)&val;
 		int idx = max(0, -start_pos);
 		for (int pos = max(0, start_pos); pos < end_pos; pos++) {
@@ -866,8 +1036,11 @@ void SmallMapWindow::DrawMapIndicators() const
  * Basically, the small map is draw column of pixels by column of pixels. The pixels
  * are drawn directly into the screen buffer. The final map is drawn in multiple passes.
  * The passes are:
- * <ol><li>The colours of tiles in the different modes.</li>
+ * <ol><li>The colours of tiles in the different modes, from the colour cache of the mode.</li>
+ * <li>The vehicles or link stats overlay, depending on the mode.</li>
  * <li>Town names (optional)</li></ol>
+ * Only the tiles which changed since the previous draw are looked at for the first pass,
+ * so refreshing the smallmap mostly costs the overlays.
  *
  * @param dpi pointer to pixel to write onto
  */
@@ -888,6 +1061,13 @@ void SmallMapWindow::DrawSmallMap(DrawPixelInfo *dpi, bool draw_indicators) cons
 	int tile_x = this->scroll_x / (int)TILE_SIZE + tile.x;
 	int tile_y = this->scroll_y / (int)TILE_SIZE + tile.y;
 
+	/* The blinking highlight changes the colour of industries without the tiles changing, so do not cache those. */
+	SmallMapColourCache *cache = nullptr;
+	if (this->map_type != SMT_INDUSTRY || _smallmap_industry_highlight == INVALID_INDUSTRYTYPE) {
+		cache = &SmallMapWindow::colour_caches[this->map_type];
+		cache->Prepare(this->GetColourSignature(), this->zoom, ((tile_x % this->zoom) + this->zoom) % this->zoom, ((tile_y % this->zoom) + this->zoom) % this->zoom);
+	}
+
 	void *ptr = blitter->MoveTo(dpi->dst_ptr, -dx - 4, 0);
 	int x = - dx - 4;
 	int y = 0;
@@ -900,7 +1080,7 @@ void SmallMapWindow::DrawSmallMap(DrawPixelInfo *dpi, bool draw_indicators) cons
 			int end_pos = min(dpi->width, x + 4);
 			int reps = (dpi->height - y + 1) / 2; // Number of lines.
 			if (reps > 0) {
-				this->DrawSmallMapColumn(ptr, tile_x, tile_y, dpi->pitch * 2, reps, x, end_pos, blitter);
+				this->DrawSmallMapColumn(ptr, tile_x, tile_y, dpi->pitch * 2, reps, x, end_pos, blitter, cache);
 			}
 		}
 
@@ -1001,6 +1181,7 @@ SmallMapWindow::~SmallMapWindow()
 {
 	delete this->overlay;
 	this->BreakIndustryChainLink();
+	ClearSmallMapColourCache();
 }
 
 /**
@@ -1508,8 +1689,14 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 	}
 	_smallmap_industry_highlight_state = !_smallmap_industry_highlight_state;
 
-	this->refresh.SetInterval(_smallmap_industry_highlight != INVALID_INDUSTRYTYPE ? BLINK_PERIOD : FORCE_REFRESH_PERIOD);
-	this->SetDirty();
+	if (_smallmap_industry_highlight != INVALID_INDUSTRYTYPE) {
+		this->refresh.SetInterval(BLINK_PERIOD);
+		this->SetDirty();
+	} else {
+		/* Only the map changes; its tile colours come from the cache, so this mostly redraws the overlays. */
+		this->refresh.SetInterval(FORCE_REFRESH_PERIOD);
+		this->SetWidgetDirty(WID_SM_MAP);
+	}
 }
 
 /**
@@ -1662,6 +1849,7 @@ void SmallMapWindow::ScreenshotCallbackHandler(void *buf, uint y, uint pitch, ui
 SmallMapWindow::SmallMapType SmallMapWindow::map_type = SMT_CONTOUR;
 bool SmallMapWindow::show_towns = true;
 int SmallMapWindow::max_heightlevel = -1;
+SmallMapColourCache SmallMapWindow::colour_caches[SmallMapWindow::SMT_END];
 
 /**
  * Custom container class for displaying smallmap with a vertically resizing legend panel.
@@ -50,6 +50,10 @@ void BuildIndustriesLegend();
 void ShowSmallMap();
 void BuildLandLegend();
 void BuildOwnerLegend();
+void ClearSmallMapColourCache();
+void InvalidateSmallMapColourCacheTile(TileIndex tile);
+
+struct SmallMapColourCache;
 
 /** Structure for holding relevant data for legends in small map */
 struct LegendAndColour {
@@ -75,6 +79,7 @@ protected:
 		SMT_ROUTES,
 		SMT_VEGETATION,
 		SMT_OWNER,
+		SMT_END,
 	};
 
 	/** Available kinds of zoomlevel changes. */
@@ -87,6 +92,7 @@ protected:
 	static SmallMapType map_type; ///< Currently displayed legends.
 	static bool show_towns;       ///< Display town names in the smallmap.
 	static int max_heightlevel;   ///< Currently used/cached maximum heightlevel.
+	static SmallMapColourCache colour_caches[SMT_END]; ///< Colours of the tile groups, by map type.
 
 	static const uint LEGEND_BLOB_WIDTH = 8;              ///< Width of the coloured blob in front of a line text in the #WID_SM_LEGEND widget.
 	static const uint INDUSTRY_MIN_NUMBER_OF_COLUMNS = 2; ///< Minimal number of columns in the #WID_SM_LEGEND widget for the #SMT_INDUSTRY legend.
@@ -177,7 +183,7 @@ protected:
 	void SetNewScroll(int sx, int sy, int sub);
 
 	void DrawMapIndicators() const;
-	void DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch, int reps, int start_pos, int end_pos, Blitter *blitter) const;
+	void DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch, int reps, int start_pos, int end_pos, Blitter *blitter, SmallMapColourCache *cache) const;
 	void DrawVehicles(const DrawPixelInfo *dpi, Blitter *blitter) const;
 	void DrawTowns(const DrawPixelInfo *dpi) const;
 	void DrawSmallMap(DrawPixelInfo *dpi, bool draw_indicators = true) const;
@@ -189,11 +195,14 @@ protected:
 	void SetOverlayCargoMask();
 	void SetupWidgetData();
 	uint32 GetTileColours(const TileArea &ta) const;
+	uint64 GetColourSignature() const;
 
 	int GetPositionOnLegend(Point pt);
 
 public:
 	friend class NWidgetSmallmapDisplay;
+	friend void ClearSmallMapColourCache();
+	friend void InvalidateSmallMapColourCacheTile(TileIndex tile);
 
 	SmallMapWindow(WindowDesc *desc, int window_number);
 	virtual ~SmallMapWindow();
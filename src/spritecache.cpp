@@ -19,6 +19,7 @@
 #include "core/math_func.hpp"
 #include "core/mem_func.hpp"
 #include "scope_info.h"
+#include "worker_thread.h"
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -28,6 +29,10 @@
 
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "safeguards.h"
 
@@ -61,6 +66,19 @@ public:
 		this->size = 0;
 	}
 
+	/**
+	 * Take ownership of memory which has been allocated elsewhere, e.g. by a background sprite load.
+	 * @param ptr The memory, allocated with MallocT.
+	 * @param size The size of the memory.
+	 */
+	void Adopt(void *ptr, uint32 size)
+	{
+		this->Clear();
+		this->ptr = ptr;
+		this->size = size;
+		_spritecache_bytes_used += this->size;
+	}
+
 	SpriteDataBuffer() {}
 
 	SpriteDataBuffer(uint32 size) { this->Allocate(size); }
@@ -94,7 +112,8 @@ PACK_N(struct SpriteCache {
 	uint16 file_slot;
 
 	/**
-	 * Bits 6 - 0:  SpriteType type  In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
+	 * Bits 5 - 0:  SpriteType type  In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
+	 * Bit      6:  bool prefetching True iff the sprite is being loaded in the background, see PrefetchSprite().
 	 * Bit      7:  bool warned      True iff the user has been warned about incorrect use of this sprite.
 	 */
 	byte type_field;
@@ -103,8 +122,10 @@ PACK_N(struct SpriteCache {
 
 	void *GetPtr() { return this->buffer.GetPtr(); }
 
-	SpriteType GetType() const { return (SpriteType) GB(this->type_field, 0, 7); }
-	void SetType(SpriteType type) { SB(this->type_field, 0, 7, type); }
+	SpriteType GetType() const { return (SpriteType) GB(this->type_field, 0, 6); }
+	void SetType(SpriteType type) { SB(this->type_field, 0, 6, type); }
+	bool GetPrefetching() const { return GB(this->type_field, 6, 1); }
+	void SetPrefetching(bool prefetching) { SB(this->type_field, 6, 1, prefetching ? 1 : 0); }
 	bool GetWarned() const { return GB(this->type_field, 7, 1); }
 	void SetWarned(bool warned) { SB(this->type_field, 7, 1, warned ? 1 : 0); }
 }, 4);
@@ -133,6 +154,7 @@ static SpriteCache *AllocateSpriteCache(uint index)
 }
 
 static uint32 _sprite_lru_counter;
+static uint32 _sprite_cache_misses; ///< Number of requested sprites which were not in the sprite cache, see GetSpriteCacheMisses().
 
 static void *AllocSprite(size_t mem_req);
 
@@ -448,6 +470,57 @@ static void *ReadRecolourSprite(uint16 file_slot, uint num)
 	return dest;
 }
 
+/**
+ * Load all available zoom levels of a sprite from disk, preferring 32bpp sprites when the blitter draws those.
+ * This does not touch the sprite cache, so it may be called from a background thread.
+ * @param[out] sprite    The sprites to fill with data.
+ * @param file_slot      File slot of the sprite.
+ * @param file_pos       Position of the sprite in the file.
+ * @param sprite_type    Type of sprite.
+ * @param container_ver  Container version of the GRF the sprite is from.
+ * @return Bit mask of the zoom levels which have been loaded, or 0 if the sprite could not be loaded.
+ */
+static uint8 LoadSpriteZoomLevels(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos, SpriteType sprite_type, byte container_ver)
+{
+	uint8 sprite_avail = 0;
+	sprite[ZOOM_LVL_NORMAL].type = sprite_type;
+
+	SpriteLoaderGrf sprite_loader(container_ver);
+	if (sprite_type != ST_MAPGEN && BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 32) {
+		/* Try for 32bpp sprites first. */
+		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, true);
+	}
+	if (sprite_avail == 0) {
+		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, false);
+	}
+	return sprite_avail;
+}
+
+/**
+ * Create the missing zoom levels of a loaded sprite, such that it can be encoded by the blitter.
+ * This does not touch the sprite cache, so it may be called from a background thread.
+ * @param[in,out] sprite The loaded sprites.
+ * @param sprite_avail   Bit mask of the loaded zoom levels.
+ * @param file_slot      File slot of the sprite.
+ * @param id             Sprite number in the GRF.
+ * @return True if the sprite could be resized.
+ */
+static bool FinishSpriteZoomLevels(SpriteLoader::Sprite *sprite, uint8 sprite_avail, uint file_slot, uint32 id)
+{
+	if (!ResizeSprites(sprite, sprite_avail, file_slot, id)) return false;
+
+	if (sprite->type == ST_FONT && ZOOM_LVL_FONT != ZOOM_LVL_NORMAL) {
+		/* Make ZOOM_LVL_NORMAL be ZOOM_LVL_FONT */
+		sprite[ZOOM_LVL_NORMAL].width  = sprite[ZOOM_LVL_FONT].width;
+		sprite[ZOOM_LVL_NORMAL].height = sprite[ZOOM_LVL_FONT].height;
+		sprite[ZOOM_LVL_NORMAL].x_offs = sprite[ZOOM_LVL_FONT].x_offs;
+		sprite[ZOOM_LVL_NORMAL].y_offs = sprite[ZOOM_LVL_FONT].y_offs;
+		sprite[ZOOM_LVL_NORMAL].data   = sprite[ZOOM_LVL_FONT].data;
+	}
+
+	return true;
+}
+
 /**
  * Read a sprite from disk.
  * @param sc          Location of sprite.
@@ -470,17 +543,7 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 	DEBUG(sprite, 9, "Load sprite %d", id);
 
 	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT];
-	uint8 sprite_avail = 0;
-	sprite[ZOOM_LVL_NORMAL].type = sprite_type;
-
-	SpriteLoaderGrf sprite_loader(sc->container_ver);
-	if (sprite_type != ST_MAPGEN && BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 32) {
-		/* Try for 32bpp sprites first. */
-		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, true);
-	}
-	if (sprite_avail == 0) {
-		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, false);
-	}
+	uint8 sprite_avail = LoadSpriteZoomLevels(sprite, file_slot, file_pos, sprite_type, sc->container_ver);
 
 	if (sprite_avail == 0) {
 		if (sprite_type == ST_MAPGEN) return nullptr;
@@ -516,20 +579,11 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 		return s;
 	}
 
-	if (!ResizeSprites(sprite, sprite_avail, file_slot, sc->id)) {
+	if (!FinishSpriteZoomLevels(sprite, sprite_avail, file_slot, sc->id)) {
 		if (id == SPR_IMG_QUERY) usererror("Okay... something went horribly wrong. I couldn't resize the fallback sprite. What should I do?");
 		return (void*)GetRawSprite(SPR_IMG_QUERY, ST_NORMAL, allocator);
 	}
 
-	if (sprite->type == ST_FONT && ZOOM_LVL_FONT != ZOOM_LVL_NORMAL) {
-		/* Make ZOOM_LVL_NORMAL be ZOOM_LVL_FONT */
-		sprite[ZOOM_LVL_NORMAL].width  = sprite[ZOOM_LVL_FONT].width;
-		sprite[ZOOM_LVL_NORMAL].height = sprite[ZOOM_LVL_FONT].height;
-		sprite[ZOOM_LVL_NORMAL].x_offs = sprite[ZOOM_LVL_FONT].x_offs;
-		sprite[ZOOM_LVL_NORMAL].y_offs = sprite[ZOOM_LVL_FONT].y_offs;
-		sprite[ZOOM_LVL_NORMAL].data   = sprite[ZOOM_LVL_FONT].data;
-	}
-
 	return BlitterFactory::GetCurrentBlitter()->Encode(sprite, allocator);
 }
 
@@ -666,6 +720,179 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	scnew->container_ver = scold->container_ver;
 }
 
+/** Maximum number of sprites which are loaded in the background at the same time. */
+static const size_t MAX_SPRITE_PREFETCH_JOBS = 512;
+
+/** A sprite which is being loaded in the background, see PrefetchSprite(). */
+struct SpritePrefetchJob {
+	SpriteID sprite;                 ///< The sprite.
+	SpriteType type;                 ///< Type of the sprite.
+	uint16 file_slot;                ///< File slot of the sprite.
+	byte container_ver;              ///< Container version of the GRF the sprite is from.
+	uint32 id;                       ///< Sprite number in the GRF.
+	size_t file_pos;                 ///< Position of the sprite in the file.
+	std::atomic<bool> cancelled;     ///< Set when the result is no longer wanted, a job which has not started yet then does nothing.
+	void *data = nullptr;            ///< The encoded sprite, allocated with MallocT, or nullptr when it could not be loaded.
+	size_t size = 0;                 ///< Size of #data.
+	std::shared_ptr<WorkerTask> task;
+
+	SpritePrefetchJob(SpriteID sprite, const SpriteCache *sc) : sprite(sprite), type(sc->GetType()), file_slot(sc->file_slot), container_ver(sc->container_ver),
+			id(sc->id), file_pos(sc->file_pos), cancelled(false) {}
+
+	~SpritePrefetchJob()
+	{
+		free(this->data);
+	}
+};
+
+/** The sprites being loaded in the background; only accessed by the main thread, or while holding the lock of a shared sprite cache. */
+static std::unordered_map<SpriteID, std::unique_ptr<SpritePrefetchJob>> _sprite_prefetch_jobs;
+/** The job of the background sprite load running on this thread, for #PrefetchAllocSprite. */
+static thread_local SpritePrefetchJob *_sprite_prefetch_current_job = nullptr;
+
+static void *PrefetchAllocSprite(size_t mem_req)
+{
+	SpritePrefetchJob *job = _sprite_prefetch_current_job;
+	assert(job->data == nullptr);
+	job->data = MallocT<byte>(mem_req);
+	job->size = mem_req;
+	return job->data;
+}
+
+/**
+ * Load and encode a sprite, on a worker thread.
+ * Only the job is written to, the sprite cache itself is left to the main thread.
+ */
+static void SpritePrefetchJobFunc(void *data, void *, void *)
+{
+	SpritePrefetchJob *job = static_cast<SpritePrefetchJob *>(data);
+	if (job->cancelled.load(std::memory_order_relaxed)) return;
+
+	FioPrivateReaderScope reader;
+	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT];
+	uint8 sprite_avail = LoadSpriteZoomLevels(sprite, job->file_slot, job->file_pos, job->type, job->container_ver);
+	if (sprite_avail == 0 || !FinishSpriteZoomLevels(sprite, sprite_avail, job->file_slot, job->id)) return;
+
+	_sprite_prefetch_current_job = job;
+	BlitterFactory::GetCurrentBlitter()->Encode(sprite, PrefetchAllocSprite);
+	_sprite_prefetch_current_job = nullptr;
+}
+
+/**
+ * Put the result of a finished background load into the sprite cache.
+ * The result is dropped if the cache entry has changed in the meantime.
+ * @param job The finished job.
+ */
+static void FinishSpritePrefetch(SpritePrefetchJob &job)
+{
+	SpriteCache *sc = GetSpriteCache(job.sprite);
+	sc->SetPrefetching(false);
+	if (job.data == nullptr) return;
+	if (sc->GetPtr() != nullptr || sc->GetType() != job.type || sc->file_slot != job.file_slot || sc->file_pos != job.file_pos) return;
+
+	sc->buffer.Adopt(job.data, (uint32)job.size);
+	sc->lru = ++_sprite_lru_counter;
+	job.data = nullptr;
+}
+
+/**
+ * Start loading a sprite in the background, if it is not in the sprite cache yet.
+ * The loaded sprite is added to the cache when the load has finished, or when the sprite is requested.
+ * @param sprite The sprite, which is expected to be drawn soon.
+ * @return Whether the sprite is not in the sprite cache yet.
+ */
+bool PrefetchSprite(SpriteID sprite)
+{
+	if (!SpriteExists(sprite)) return false;
+
+	SpriteCache *sc = GetSpriteCache(sprite);
+	if (sc->GetType() != ST_NORMAL || sc->GetPtr() != nullptr) return false;
+	if (sc->GetPrefetching() || _sprite_prefetch_jobs.size() >= MAX_SPRITE_PREFETCH_JOBS || _general_worker_pool.GetThreadCount() == 0) return true;
+
+	sc->SetPrefetching(true);
+	SpritePrefetchJob *job = new SpritePrefetchJob(sprite, sc);
+	_sprite_prefetch_jobs[sprite].reset(job);
+	job->task = _general_worker_pool.EnqueueTask(WTC_SPRITE_PREFETCH, &SpritePrefetchJobFunc, job);
+	return true;
+}
+
+/**
+ * Get the number of requested sprites which were not in the sprite cache, and had to be loaded or waited for.
+ * This only changes when sprites not seen before are drawn, or when the cache has been trimmed.
+ * @return The number of sprite cache misses, which wraps around.
+ */
+uint32 GetSpriteCacheMisses()
+{
+	return _sprite_cache_misses;
+}
+
+/**
+ * Wait for the background load of a sprite which is needed now; the load is cancelled if it has not started yet.
+ * @param sprite The sprite, which is being prefetched.
+ */
+static void WaitForSpritePrefetch(SpriteID sprite)
+{
+	auto iter = _sprite_prefetch_jobs.find(sprite);
+	assert(iter != _sprite_prefetch_jobs.end());
+
+	SpritePrefetchJob &job = *iter->second;
+	job.cancelled.store(true, std::memory_order_relaxed);
+	job.task->Wait();
+	FinishSpritePrefetch(job);
+	_sprite_prefetch_jobs.erase(iter);
+}
+
+/** Move the sprites of the finished background loads into the sprite cache. */
+static void CollectPrefetchedSprites()
+{
+	for (auto iter = _sprite_prefetch_jobs.begin(); iter != _sprite_prefetch_jobs.end();) {
+		if (iter->second->task->IsDone()) {
+			FinishSpritePrefetch(*iter->second);
+			iter = _sprite_prefetch_jobs.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+}
+
+/**
+ * Cancel all background sprite loads and wait for the running ones, dropping their results.
+ * This has to be done before the sprite cache, the loaded GRF files or the blitter change.
+ */
+void CancelSpritePrefetch()
+{
+	for (auto &it : _sprite_prefetch_jobs) {
+		it.second->cancelled.store(true, std::memory_order_relaxed);
+	}
+	for (auto &it : _sprite_prefetch_jobs) {
+		it.second->task->Wait();
+		if (it.first < _spritecache.size()) GetSpriteCache(it.first)->SetPrefetching(false);
+	}
+	_sprite_prefetch_jobs.clear();
+}
+
+static std::recursive_mutex _sprite_cache_shared_mutex; ///< Serialises GetRawSprite() while the sprite cache is shared, see BeginSpriteCacheSharing().
+static bool _sprite_cache_shared = false;                ///< Whether several threads may use the sprite cache at once.
+
+/**
+ * Allow several threads to get sprites at once, until EndSpriteCacheSharing().
+ * Sprites are then loaded one at a time, waiting for their background loads included. The cache
+ * is not trimmed meanwhile, as that only happens in IncreaseSpriteLRU(), so the returned sprites stay valid.
+ * The main thread must not do anything else with the sprite cache while it is shared.
+ */
+void BeginSpriteCacheSharing()
+{
+	assert(!_sprite_cache_shared);
+	_sprite_cache_shared = true;
+}
+
+/** End the sharing of the sprite cache, see BeginSpriteCacheSharing(). */
+void EndSpriteCacheSharing()
+{
+	assert(_sprite_cache_shared);
+	_sprite_cache_shared = false;
+}
+
 static size_t GetSpriteCacheUsage()
 {
 	return _spritecache_bytes_used;
@@ -737,6 +964,8 @@ static void DeleteEntriesFromSpriteCache(size_t target)
 
 void IncreaseSpriteLRU()
 {
+	CollectPrefetchedSprites();
+
 	int bpp = BlitterFactory::GetCurrentBlitter()->GetScreenDepth();
 	uint target_size = (bpp > 0 ? _sprite_cache_size * bpp / 8 : 1) * 1024 * 1024;
 	if (_spritecache_bytes_used > target_size) {
@@ -828,6 +1057,9 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 	assert(type != ST_MAPGEN || IsMapgenSpriteID(sprite));
 	assert(type < ST_INVALID);
 
+	std::unique_lock<std::recursive_mutex> shared_lock(_sprite_cache_shared_mutex, std::defer_lock);
+	if (_sprite_cache_shared) shared_lock.lock();
+
 	if (!SpriteExists(sprite)) {
 		DEBUG(sprite, 1, "Tried to load non-existing sprite #%d. Probable cause: Wrong/missing NewGRFs", sprite);
 
@@ -844,6 +1076,10 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 
 		/* Update LRU */
 		sc->lru = ++_sprite_lru_counter;
+		if (sc->GetPtr() == nullptr) _sprite_cache_misses++;
+
+		/* A background load of the sprite may already be underway. */
+		if (sc->GetPtr() == nullptr && sc->GetPrefetching()) WaitForSpritePrefetch(sprite);
 
 		/* Load the sprite, if it is not loaded, yet */
 		if (sc->GetPtr() == nullptr) {
@@ -958,6 +1194,8 @@ uint32 GetSpriteMainColour(SpriteID sprite_id, PaletteID palette_id)
 
 void GfxInitSpriteMem()
 {
+	CancelSpritePrefetch();
+
 	/* Reset the spritecache 'pool' */
 	_spritecache.clear();
 	assert(_spritecache_bytes_used == 0);
@@ -969,6 +1207,8 @@ void GfxInitSpriteMem()
  */
 void GfxClearSpriteCache()
 {
+	CancelSpritePrefetch();
+
 	/* Clear sprite ptr for all cached items */
 	for (uint i = 0; i != _spritecache.size(); i++) {
 		SpriteCache *sc = GetSpriteCache(i);
@@ -976,4 +1216,4 @@ void GfxClearSpriteCache()
 	}
 }
 
-/* static */ ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_COUNT];
+/* static */ thread_local ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_COUNT];
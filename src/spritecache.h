@@ -50,6 +50,11 @@ static inline const byte *GetNonSprite(SpriteID sprite, SpriteType type)
 void GfxInitSpriteMem();
 void GfxClearSpriteCache();
 void IncreaseSpriteLRU();
+bool PrefetchSprite(SpriteID sprite);
+uint32 GetSpriteCacheMisses();
+void CancelSpritePrefetch();
+void BeginSpriteCacheSharing();
+void EndSpriteCacheSharing();
 
 void ReadGRFSpriteOffsets(byte container_version);
 size_t GetGRFSpriteOffset(uint32 id);
@@ -17,6 +17,7 @@
 #include "../core/math_func.hpp"
 #include "../core/alloc_type.hpp"
 #include "../core/bitmath_func.hpp"
+#include "../thread.h"
 #include "grf.hpp"
 
 #include "../safeguards.h"
@@ -42,6 +43,9 @@ DECLARE_ENUM_AS_BIT_SET(SpriteColourComponent)
  */
 static bool WarnCorruptSprite(uint file_slot, size_t file_pos, int line)
 {
+	/* Sprites loaded in the background are loaded again on the main thread when they fail, which warns then. */
+	if (IsNonMainThread()) return false;
+
 	static byte warning_level = 0;
 	if (warning_level == 0) {
 		SetDParamStr(0, FioGetFilename(file_slot));
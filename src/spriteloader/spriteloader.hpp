@@ -46,8 +46,8 @@ public:
 		 */
 		void AllocateData(ZoomLevel zoom, size_t size) { this->data = Sprite::buffer[zoom].ZeroAllocate(size); }
 	private:
-		/** Allocated memory to pass sprite data around */
-		static ReusableBuffer<SpriteLoader::CommonPixel> buffer[ZOOM_LVL_COUNT];
+		/** Allocated memory to pass sprite data around, per thread as sprites may be loaded in the background. */
+		static thread_local ReusableBuffer<SpriteLoader::CommonPixel> buffer[ZOOM_LVL_COUNT];
 	};
 
 	/**
@@ -145,6 +145,21 @@ typedef Foundation GetFoundationProc(TileIndex tile, Slope tileh);
  */
 typedef CommandCost TerraformTileProc(TileIndex tile, DoCommandFlag flags, int z_new, Slope tileh_new);
 
+/**
+ * Tile callback function signature of the tile loop precheck callback.
+ *
+ * The function is called on a worker thread for a chunk of the tiles which are about to be looped over by RunTileLoop.
+ * It may only read the map, it must not modify any state and must not call anything which consumes random numbers or resolves NewGRF callbacks.
+ * If it can determine that the tile loop of the tile is equivalent to a cheaper procedure, it returns that procedure,
+ * which is then called instead of the tile loop proc, in the same order as the tile loop would be.
+ *
+ * @note The result is only used if no tile within distance 1 has been passed to InvalidateTileLoopPrecheck since the chunk was prechecked.
+ *
+ * @param tile The tile to check.
+ * @return Procedure to run instead of the tile loop proc of the tile, or nullptr to run the tile loop proc.
+ */
+typedef TileLoopProc *TileLoopPrecheckProc(TileIndex tile);
+
 /**
  * Set of callback functions for performing tile operations of a given tile type.
  * @see TileType
@@ -164,6 +179,7 @@ struct TileTypeProcs {
 	VehicleEnterTileProc *vehicle_enter_tile_proc; ///< Called when a vehicle enters a tile
 	GetFoundationProc *get_foundation_proc;
 	TerraformTileProc *terraform_tile_proc;        ///< Called when a terraforming operation is about to take place
+	TileLoopPrecheckProc *tile_loop_precheck_proc; ///< Called concurrently to find a cheaper equivalent of the tile loop of a tile, may be nullptr
 };
 
 extern const TileTypeProcs * const _tile_type_procs[16];
@@ -3989,6 +3989,7 @@ extern const TileTypeProcs _tile_type_town_procs = {
 	nullptr,                    // vehicle_enter_tile_proc
 	GetFoundation_Town,      // get_foundation_proc
 	TerraformTile_Town,      // terraform_tile_proc
+	nullptr,                 // tile_loop_precheck_proc
 };
 
 
@@ -28,6 +28,9 @@ const char *VideoDriver_Null::Start(const StringList &parm)
 
 	this->ticks = GetDriverParamInt(parm, "ticks", 1000);
 	this->until_exit = GetDriverParamBool(parm, "until_exit");
+	this->render_benchmark = GetDriverParamInt(parm, "render_benchmark", 0);
+	const char *blitter = GetDriverParam(parm, "benchmark_blitter");
+	this->benchmark_blitter = blitter != nullptr ? blitter : "";
 	_screen.width  = _screen.pitch = _cur_resolution.width;
 	_screen.height = _cur_resolution.height;
 	_screen.dst_ptr = nullptr;
@@ -43,9 +46,24 @@ void VideoDriver_Null::Stop() { }
 
 void VideoDriver_Null::MakeDirty(int left, int top, int width, int height) {}
 
+static void PrintRenderBenchmarkLine(const char *line)
+{
+	fprintf(stdout, "%s\n", line);
+}
+
 void VideoDriver_Null::MainLoop()
 {
-	if (this->until_exit) {
+	if (this->render_benchmark > 0) {
+		/* Load the game given on the command line, then only render it. */
+		GameLoop();
+		UpdateWindows();
+
+		extern bool ViewportRunRenderBenchmark(uint iterations, const char *blitter_name, void (*print)(const char *));
+		if (!ViewportRunRenderBenchmark(this->render_benchmark, this->benchmark_blitter.empty() ? nullptr : this->benchmark_blitter.c_str(), PrintRenderBenchmarkLine)) {
+			usererror("Viewport render benchmark failed");
+		}
+		fflush(stdout);
+	} else if (this->until_exit) {
 		while (!_exit_game) {
 			GameLoop();
 			GameLoopPaletteAnimations();
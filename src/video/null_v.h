@@ -17,6 +17,8 @@ class VideoDriver_Null : public VideoDriver {
 private:
 	int ticks; ///< Amount of ticks to run.
 	bool until_exit;
+	uint render_benchmark;         ///< Number of iterations of the viewport render benchmark to run instead of the game, 0 if none.
+	std::string benchmark_blitter; ///< Blitter to run the render benchmark with.
 
 public:
 	const char *Start(const StringList &param) override;
@@ -107,12 +107,21 @@
 #include "tunnelbridge_map.h"
 #include "video/video_driver.hpp"
 #include "scope_info.h"
+#include "worker_thread.h"
+#include "console_func.h"
+#include "spritecache.h"
+#include "fontcache.h"
+#include "thread.h"
 
+#include <atomic>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <math.h>
 #include <algorithm>
 #include <tuple>
+#include <chrono>
 
 #include "table/strings.h"
 #include "table/string_colours.h"
@@ -139,6 +148,7 @@ struct StringSpriteToDraw {
 	int32 y;
 	uint64 params[2];
 	uint16 width;
+	const ViewportSign *sign; ///< Sign the string belongs to, whose formatted texts are cached.
 };
 
 struct TileSpriteToDraw {
@@ -174,6 +184,22 @@ typedef std::vector<StringSpriteToDraw> StringSpriteToDrawVector;
 typedef std::vector<ParentSpriteToDraw> ParentSpriteToDrawVector;
 typedef std::vector<ChildScreenSpriteToDraw> ChildScreenSpriteToDrawVector;
 
+/** Formatted text of a string drawn on a viewport sign. */
+struct ViewportSignText {
+	StringID string;  ///< String the text was formatted from.
+	uint64 params[2]; ///< Parameters the text was formatted with.
+	std::string text; ///< The formatted text.
+};
+
+/** Formatted texts of a viewport sign; a sign draws at most a normal, a small and a shadow string at once. */
+struct ViewportSignTexts {
+	ViewportSignText texts[3]; ///< The texts.
+	uint8 next;                ///< Text to replace when a string is not found.
+};
+
+static const size_t MAX_VIEWPORT_SIGN_TEXT_CACHE = 65536; ///< Number of signs after which the text cache is emptied at the next draw.
+static std::unordered_map<const ViewportSign *, ViewportSignTexts> _viewport_sign_text_cache; ///< Formatted texts of the viewport signs, forgotten by ViewportSign::UpdatePosition().
+
 typedef std::vector<std::pair<int, OrderType> > RankOrderTypeList;
 typedef std::map<TileIndex, RankOrderTypeList> RouteStepsMap;
 
@@ -263,8 +289,9 @@ static void MarkViewportDirty(ViewPort * const vp, int left, int top, int right,
 static void MarkRouteStepDirty(RouteStepsMap::const_iterator cit);
 static void MarkRouteStepDirty(const TileIndex tile, uint order_nr);
 
-static DrawPixelInfo _dpi_for_text;
-static ViewportDrawer _vd;
+/* The drawing state is per thread, as viewports may be drawn by several threads at once, see BeginViewportParallelDraw(). */
+static thread_local DrawPixelInfo _dpi_for_text;
+static thread_local ViewportDrawer _vd;
 
 static std::vector<ViewPort *> _viewport_window_cache;
 
@@ -303,11 +330,152 @@ std::vector<DrawnPathRouteTileLine> _vp_route_paths_last_mark_dirty;
 static void MarkRoutePathsDirty(const std::vector<DrawnPathRouteTileLine> &lines);
 
 TileHighlightData _thd;
-static TileInfo *_cur_ti;
+static thread_local TileInfo *_cur_ti;
 bool _draw_bounding_boxes = false;
 bool _draw_dirty_blocks = false;
 uint _dirty_block_colour = 0;
 static VpSpriteSorter _vp_sprite_sorter = nullptr;
+static bool _vp_sprite_sorter_capture = false;                         ///< Whether to capture parent sprite lists for the sprite sorter benchmark.
+static std::vector<ParentSpriteToDraw> _vp_sprite_sorter_captured;     ///< Largest captured parent sprite list for the sprite sorter benchmark.
+static std::mutex _vp_parallel_draw_mutex;                             ///< Serialises the phases of ViewportDoDraw() which use shared state, while viewports are drawn in parallel.
+static bool _vp_parallel_draw = false;                                 ///< Whether viewports are drawn by several threads at once, see BeginViewportParallelDraw().
+static const int VIEWPORT_MIN_DRAW_STRIP_WIDTH = 256;                  ///< Width in pixels of the narrowest strip of a viewport which is drawn by one thread, see ViewportDrawChk().
+
+/** Phases of drawing a viewport, as timed by the render benchmark. */
+enum ViewportDrawPhase {
+	VDP_COLLECT,  ///< Collecting the sprites of the landscape, vehicles and signs; or drawing the map in map mode.
+	VDP_SORT,     ///< Sorting the parent sprites.
+	VDP_BLIT,     ///< Drawing the tile and parent sprites.
+	VDP_STRINGS,  ///< Drawing the strings, overlays, routes and plans.
+	VDP_END,
+};
+static std::atomic<uint64> *_vp_draw_phase_ns = nullptr; ///< Time spent in each #ViewportDrawPhase by all drawing threads while the render benchmark runs, otherwise \c nullptr.
+
+/** Adds the time of its lifetime to a #ViewportDrawPhase, while the render benchmark runs. */
+struct ViewportDrawPhaseTimer {
+	ViewportDrawPhase phase;
+	std::chrono::steady_clock::time_point start;
+
+	ViewportDrawPhaseTimer(ViewportDrawPhase phase) : phase(phase)
+	{
+		if (unlikely(_vp_draw_phase_ns != nullptr)) this->start = std::chrono::steady_clock::now();
+	}
+
+	~ViewportDrawPhaseTimer()
+	{
+		if (unlikely(_vp_draw_phase_ns != nullptr)) {
+			_vp_draw_phase_ns[this->phase].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->start).count(), std::memory_order_relaxed);
+		}
+	}
+};
+
+/** Kind of a recorded call of a draw_tile_proc to the viewport drawing functions. */
+enum LandscapeDrawOpType : byte {
+	LDOT_GROUND,              ///< #DrawGroundSpriteAt
+	LDOT_OFFSET_GROUND,       ///< #OffsetGroundSprite
+	LDOT_SORTABLE,            ///< #AddSortableSpriteToDraw
+	LDOT_CHILD_SCREEN,        ///< #AddChildSpriteScreen
+	LDOT_START_COMBINE,       ///< #StartSpriteCombine
+	LDOT_END_COMBINE,         ///< #EndSpriteCombine
+};
+
+/** A recorded call of a draw_tile_proc to the viewport drawing functions, with its parameters. */
+struct LandscapeDrawOp {
+	LandscapeDrawOpType type;
+	bool transparent;
+	bool scale;
+	bool relative;
+	SpriteID image;
+	PaletteID pal;
+	int x;
+	int y;
+	int z;
+	int w;
+	int h;
+	int dz;
+	int bb_offset_x;
+	int bb_offset_y;
+	int bb_offset_z;
+	int extra_offs_x;
+	int extra_offs_y;
+	int ti_z;                 ///< Height of the tile info at the time of a #LDOT_GROUND call, foundations may have raised it.
+	const SubSprite *sub;
+};
+
+/** The recorded drawing of a tile at a zoom level. */
+struct LandscapeSpriteCacheEntry {
+	std::vector<LandscapeDrawOp> ops;
+	int z;                    ///< Height of the tile info after drawing.
+	Slope tileh;              ///< Slope of the tile info after drawing.
+};
+
+static const size_t LANDSCAPE_SPRITE_CACHE_MAX_ENTRIES = 1 << 18;                   ///< Number of cached tile drawings after which the cache is emptied.
+static std::unordered_map<uint64, LandscapeSpriteCacheEntry> _landscape_sprite_cache; ///< Recorded tile drawings, by tile and zoom level. @see LandscapeSpriteCacheKey
+static uint8 _landscape_sprite_cache_zooms = 0;                                    ///< Bitmask of the zoom levels present in the landscape sprite cache.
+static uint _landscape_sprite_cache_snowline = 0;                                  ///< Snow line height the landscape sprite cache was filled with.
+static std::vector<LandscapeDrawOp> _landscape_sprite_recording_buffer;            ///< Calls recorded for the tile being drawn.
+static bool _landscape_sprite_recording = false;                                   ///< Whether the calls to the drawing functions are being recorded.
+
+static inline uint64 LandscapeSpriteCacheKey(TileIndex tile, ZoomLevel zoom)
+{
+	return ((uint64)tile << 8) | zoom;
+}
+
+/**
+ * Record a call of the draw_tile_proc of the tile being drawn, if recording is active.
+ * Calls made by a recorded function are not recorded themselves, see #LandscapeSpriteRecordingPause.
+ * @param type The called function.
+ * @param image The image parameter of the call.
+ * @param pal The palette parameter of the call.
+ * @param sub The sub sprite parameter of the call.
+ * @return The recorded call to fill in the remaining parameters, or \c nullptr when not recording.
+ */
+static inline LandscapeDrawOp *RecordLandscapeDrawOp(LandscapeDrawOpType type, SpriteID image = 0, PaletteID pal = 0, const SubSprite *sub = nullptr)
+{
+	if (likely(!_landscape_sprite_recording)) return nullptr;
+
+	/* Value initialisation clears the parameters which the call does not use. */
+	_landscape_sprite_recording_buffer.emplace_back();
+	LandscapeDrawOp &op = _landscape_sprite_recording_buffer.back();
+	op.type = type;
+	op.image = image;
+	op.pal = pal;
+	op.sub = sub;
+	return &op;
+}
+
+/** Suspends the recording of calls while a recorded function calls other drawing functions. */
+struct LandscapeSpriteRecordingPause {
+	bool recording;
+
+	LandscapeSpriteRecordingPause() : recording(_landscape_sprite_recording)
+	{
+		_landscape_sprite_recording = false;
+	}
+
+	~LandscapeSpriteRecordingPause()
+	{
+		_landscape_sprite_recording = this->recording;
+	}
+};
+
+static bool _vp_sprite_prefetch_collecting = false;      ///< Whether the sprites added to the viewport are collected for prefetching instead of drawn.
+static std::vector<SpriteID> _vp_sprite_prefetch_list; ///< The sprites collected for prefetching.
+static bool _vp_sprite_prefetch_warm = false;            ///< Whether the last prefetch found all its sprites in the sprite cache.
+static uint32 _vp_sprite_prefetch_warm_misses = 0;       ///< The sprite cache misses at the last prefetch, see GetSpriteCacheMisses().
+
+/**
+ * Collect a sprite for prefetching instead of adding it to the viewport, if a prefetch is being prepared.
+ * @param image The sprite.
+ * @return True if the sprite was collected, and should not be added.
+ */
+static inline bool CollectSpriteForPrefetch(SpriteID image)
+{
+	if (likely(!_vp_sprite_prefetch_collecting)) return false;
+
+	_vp_sprite_prefetch_list.push_back(image & SPRITE_MASK);
+	return true;
+}
 
 const byte *_pal2trsp_remap_ptr = nullptr;
 
@@ -622,6 +790,97 @@ inline void UpdateViewportDirtyBlockLeftMargin(ViewPort *vp)
 	}
 }
 
+static void ViewportAddLandscape();
+
+/**
+ * Start loading the sprites of an area of a viewport in the background, such that they are in the sprite cache when the area is drawn.
+ * The landscape of the area is walked like ViewportDoDraw() does, but the sprites are only collected.
+ * @param vp The viewport.
+ * @param left Left edge of the area, in virtual coordinates.
+ * @param top Top edge of the area, in virtual coordinates.
+ * @param width Width of the area, in virtual coordinates.
+ * @param height Height of the area, in virtual coordinates.
+ * @return Whether any sprite of the area was not in the sprite cache yet.
+ */
+static bool ViewportPrefetchSprites(const ViewPort *vp, int left, int top, int width, int height)
+{
+	DrawPixelInfo *old_dpi = _cur_dpi;
+	_cur_dpi = &_vd.dpi;
+
+	int mask = ScaleByZoom(-1, vp->zoom);
+	_vd.dpi.zoom = vp->zoom;
+	_vd.dpi.left = left & mask;
+	_vd.dpi.top = top & mask;
+	_vd.dpi.width = width & mask;
+	_vd.dpi.height = height & mask;
+	_vd.dpi.pitch = 0;
+	_vd.dpi.dst_ptr = nullptr;
+	_vd.combine_sprites = SPRITE_COMBINE_NONE;
+	_vd.last_child = nullptr;
+
+	_vp_sprite_prefetch_collecting = true;
+	ViewportAddLandscape();
+	_vp_sprite_prefetch_collecting = false;
+
+	_cur_dpi = old_dpi;
+
+	/* Tile selections and sprites added by other means are not collected, drop them. */
+	_vd.string_sprites_to_draw.clear();
+	_vd.tile_sprites_to_draw.clear();
+	_vd.parent_sprites_to_draw.clear();
+	_vd.child_screen_sprites_to_draw.clear();
+
+	std::sort(_vp_sprite_prefetch_list.begin(), _vp_sprite_prefetch_list.end());
+	_vp_sprite_prefetch_list.erase(std::unique(_vp_sprite_prefetch_list.begin(), _vp_sprite_prefetch_list.end()), _vp_sprite_prefetch_list.end());
+	bool missing = false;
+	for (SpriteID sprite : _vp_sprite_prefetch_list) {
+		if (PrefetchSprite(sprite)) missing = true;
+	}
+	_vp_sprite_prefetch_list.clear();
+	return missing;
+}
+
+/**
+ * Prefetch the sprites of the area a scrolling viewport is moving into.
+ * This is done each time the viewport has moved by an eighth of its size, for a strip of a quarter of its size ahead of it.
+ * When the previous strip had all its sprites in the cache already, the walk is skipped until a drawn sprite misses the cache.
+ * @param vp The viewport.
+ */
+static void ViewportPrefetchScrollSprites(ViewPort *vp)
+{
+	if (vp->zoom >= ZOOM_LVL_DRAW_MAP || _general_worker_pool.GetThreadCount() == 0) return;
+
+	const int dx = vp->virtual_left - vp->prefetch_left;
+	const int dy = vp->virtual_top - vp->prefetch_top;
+	if (abs(dx) < vp->virtual_width / 8 && abs(dy) < vp->virtual_height / 8) return;
+
+	vp->prefetch_left = vp->virtual_left;
+	vp->prefetch_top = vp->virtual_top;
+
+	/* Too far for a scroll, e.g. a jump to a location: the area ahead is not a good prediction. */
+	if (abs(dx) > vp->virtual_width || abs(dy) > vp->virtual_height) return;
+
+	/* The cache is warm, walking the landscape would find nothing to load. */
+	if (_vp_sprite_prefetch_warm && GetSpriteCacheMisses() == _vp_sprite_prefetch_warm_misses) return;
+
+	const int strip_width = vp->virtual_width / 4;
+	const int strip_height = vp->virtual_height / 4;
+	bool missing = false;
+	if (dx > 0) {
+		missing |= ViewportPrefetchSprites(vp, vp->virtual_left + vp->virtual_width, vp->virtual_top, strip_width, vp->virtual_height);
+	} else if (dx < 0) {
+		missing |= ViewportPrefetchSprites(vp, vp->virtual_left - strip_width, vp->virtual_top, strip_width, vp->virtual_height);
+	}
+	if (dy > 0) {
+		missing |= ViewportPrefetchSprites(vp, vp->virtual_left, vp->virtual_top + vp->virtual_height, vp->virtual_width, strip_height);
+	} else if (dy < 0) {
+		missing |= ViewportPrefetchSprites(vp, vp->virtual_left, vp->virtual_top - strip_height, vp->virtual_width, strip_height);
+	}
+
+	_vp_sprite_prefetch_warm = !missing;
+	_vp_sprite_prefetch_warm_misses = GetSpriteCacheMisses();
+}
+
 static void SetViewportPosition(Window *w, int x, int y, bool force_update_overlay)
 {
 	if (unlikely(HasBit(_viewport_debug_flags, VDF_DIRTY_WHOLE_VIEWPORT))) {
@@ -653,6 +912,8 @@ static void SetViewportPosition(Window *w, int x, int y, bool force_update_overl
 
 	if (old_top == 0 && old_left == 0) return;
 
+	ViewportPrefetchScrollSprites(vp);
+
 	_vp_move_offs.x = old_left;
 	_vp_move_offs.y = old_top;
 
@@ -855,6 +1116,18 @@ static void AddChildSpriteToFoundation(SpriteID image, PaletteID pal, const SubS
  */
 void DrawGroundSpriteAt(SpriteID image, PaletteID pal, int32 x, int32 y, int z, const SubSprite *sub, int extra_offs_x, int extra_offs_y)
 {
+	if (CollectSpriteForPrefetch(image)) return;
+
+	if (LandscapeDrawOp *op = RecordLandscapeDrawOp(LDOT_GROUND, image, pal, sub)) {
+		op->x = x;
+		op->y = y;
+		op->z = z;
+		op->extra_offs_x = extra_offs_x;
+		op->extra_offs_y = extra_offs_y;
+		op->ti_z = _cur_ti->z;
+	}
+	LandscapeSpriteRecordingPause pause;
+
 	/* Switch to first foundation part, if no foundation was drawn */
 	if (_vd.foundation_part == FOUNDATION_PART_NONE) _vd.foundation_part = FOUNDATION_PART_NORMAL;
 
@@ -890,6 +1163,11 @@ void DrawGroundSprite(SpriteID image, PaletteID pal, const SubSprite *sub, int e
  */
 void OffsetGroundSprite(int x, int y)
 {
+	if (LandscapeDrawOp *op = RecordLandscapeDrawOp(LDOT_OFFSET_GROUND)) {
+		op->x = x;
+		op->y = y;
+	}
+
 	/* Switch to next foundation part */
 	switch (_vd.foundation_part) {
 		case FOUNDATION_PART_NONE:
@@ -973,6 +1251,22 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
+	if (CollectSpriteForPrefetch(image)) return;
+
+	if (LandscapeDrawOp *op = RecordLandscapeDrawOp(LDOT_SORTABLE, image, pal, sub)) {
+		op->x = x;
+		op->y = y;
+		op->z = z;
+		op->w = w;
+		op->h = h;
+		op->dz = dz;
+		op->transparent = transparent;
+		op->bb_offset_x = bb_offset_x;
+		op->bb_offset_y = bb_offset_y;
+		op->bb_offset_z = bb_offset_z;
+	}
+	LandscapeSpriteRecordingPause pause;
+
 	/* make the sprites transparent with the right palette */
 	if (transparent) {
 		SetBit(image, PALETTE_MODIFIER_TRANSPARENT);
@@ -1083,6 +1377,7 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
  */
 void StartSpriteCombine()
 {
+	RecordLandscapeDrawOp(LDOT_START_COMBINE);
 	assert(_vd.combine_sprites == SPRITE_COMBINE_NONE);
 	_vd.combine_sprites = SPRITE_COMBINE_PENDING;
 }
@@ -1093,6 +1388,7 @@ void StartSpriteCombine()
  */
 void EndSpriteCombine()
 {
+	RecordLandscapeDrawOp(LDOT_END_COMBINE);
 	assert(_vd.combine_sprites != SPRITE_COMBINE_NONE);
 	if (_vd.combine_sprites == SPRITE_COMBINE_ACTIVE) {
 		ParentSpriteToDraw &ps = _vd.parent_sprites_to_draw[_vd.combine_psd_index];
@@ -1155,6 +1451,16 @@ void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool tran
 {
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
+	if (CollectSpriteForPrefetch(image)) return;
+
+	if (LandscapeDrawOp *op = RecordLandscapeDrawOp(LDOT_CHILD_SCREEN, image, pal, sub)) {
+		op->x = x;
+		op->y = y;
+		op->transparent = transparent;
+		op->scale = scale;
+		op->relative = relative;
+	}
+
 	/* If the ParentSprite was clipped by the viewport bounds, do not draw the ChildSprites either */
 	if (_vd.last_child == nullptr) return;
 
@@ -1184,7 +1490,7 @@ void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool tran
 	_vd.last_child = &cs.next;
 }
 
-static void AddStringToDraw(int x, int y, StringID string, uint64 params_1, uint64 params_2, Colours colour, uint16 width)
+static void AddStringToDraw(int x, int y, StringID string, uint64 params_1, uint64 params_2, Colours colour, uint16 width, const ViewportSign *sign)
 {
 	assert(width != 0);
 	/*C++17: StringSpriteToDraw &ss = */ _vd.string_sprites_to_draw.emplace_back();
@@ -1196,6 +1502,7 @@ static void AddStringToDraw(int x, int y, StringID string, uint64 params_1, uint
 	ss.params[1] = params_2;
 	ss.width = width;
 	ss.colour = colour;
+	ss.sign = sign;
 }
 
 
@@ -1512,6 +1819,108 @@ static int GetViewportY(Point tile)
 	return (tile.y * (int)(TILE_PIXELS / 2) + tile.x * (int)(TILE_PIXELS / 2) - TilePixelHeightOutsideMap(tile.x, tile.y)) << ZOOM_LVL_SHIFT;
 }
 
+/**
+ * Empty the landscape sprite cache, e.g. because the drawing of many tiles has changed.
+ */
+void ClearLandscapeSpriteCache()
+{
+	_landscape_sprite_cache.clear();
+	_landscape_sprite_cache_zooms = 0;
+}
+
+/**
+ * Forget the cached drawing of a tile and its neighbours, which may depend on it (fences, catenary, foundations).
+ * @param tile The changed tile.
+ */
+void InvalidateLandscapeSpriteCacheTile(TileIndex tile)
+{
+	if (_landscape_sprite_cache.empty()) return;
+
+	for (int dy = -1; dy <= 1; dy++) {
+		for (int dx = -1; dx <= 1; dx++) {
+			TileIndex t = TileAddWrap(tile, dx, dy);
+			if (t == INVALID_TILE) continue;
+			for (uint8 zooms = _landscape_sprite_cache_zooms; zooms != 0; zooms &= zooms - 1) {
+				_landscape_sprite_cache.erase(LandscapeSpriteCacheKey(t, (ZoomLevel)FindFirstBit(zooms)));
+			}
+		}
+	}
+}
+
+/**
+ * Replay the recorded drawing of a tile.
+ * @param ti The tile being drawn.
+ * @param entry The recorded drawing.
+ */
+static void ReplayLandscapeSprites(TileInfo *ti, const LandscapeSpriteCacheEntry &entry)
+{
+	for (const LandscapeDrawOp &op : entry.ops) {
+		switch (op.type) {
+			case LDOT_GROUND:
+				ti->z = op.ti_z;
+				DrawGroundSpriteAt(op.image, op.pal, op.x, op.y, op.z, op.sub, op.extra_offs_x, op.extra_offs_y);
+				break;
+
+			case LDOT_OFFSET_GROUND:
+				OffsetGroundSprite(op.x, op.y);
+				break;
+
+			case LDOT_SORTABLE:
+				AddSortableSpriteToDraw(op.image, op.pal, op.x, op.y, op.w, op.h, op.dz, op.z, op.transparent, op.bb_offset_x, op.bb_offset_y, op.bb_offset_z, op.sub);
+				break;
+
+			case LDOT_CHILD_SCREEN:
+				AddChildSpriteScreen(op.image, op.pal, op.x, op.y, op.transparent, op.sub, op.scale, op.relative);
+				break;
+
+			case LDOT_START_COMBINE:
+				StartSpriteCombine();
+				break;
+
+			case LDOT_END_COMBINE:
+				EndSpriteCombine();
+				break;
+
+			default: NOT_REACHED();
+		}
+	}
+	ti->z = entry.z;
+	ti->tileh = entry.tileh;
+}
+
+/**
+ * Draw a fully visible tile, replaying its drawing from the landscape sprite cache when possible.
+ * @param ti The tile to draw.
+ * @param tile_type The type of the tile.
+ * @param params The parameters for the draw_tile_proc.
+ */
+static void DrawTileWithLandscapeSpriteCache(TileInfo *ti, TileType tile_type, DrawTileProcParams params)
+{
+	const uint64 key = LandscapeSpriteCacheKey(ti->tile, _vd.dpi.zoom);
+	auto iter = _landscape_sprite_cache.find(key);
+	if (iter != _landscape_sprite_cache.end()) {
+		ReplayLandscapeSprites(ti, iter->second);
+		return;
+	}
+
+	if (_vp_sprite_prefetch_collecting) {
+		/* The collected calls are not drawn, so they cannot be recorded. */
+		_tile_type_procs[tile_type]->draw_tile_proc(ti, params);
+		return;
+	}
+
+	_landscape_sprite_recording_buffer.clear();
+	_landscape_sprite_recording = true;
+	_tile_type_procs[tile_type]->draw_tile_proc(ti, params);
+	_landscape_sprite_recording = false;
+
+	LandscapeSpriteCacheEntry &entry = _landscape_sprite_cache[key];
+	entry.ops.assign(_landscape_sprite_recording_buffer.begin(), _landscape_sprite_recording_buffer.end());
+	entry.z = ti->z;
+	entry.tileh = ti->tileh;
+	SetBit(_landscape_sprite_cache_zooms, _vd.dpi.zoom);
+}
+
 /**
  * Add the landscape to the viewport, i.e. all ground tiles and buildings.
  */
@@ -1520,6 +1929,12 @@ static void ViewportAddLandscape()
 	assert(_vd.dpi.top <= _vd.dpi.top + _vd.dpi.height);
 	assert(_vd.dpi.left <= _vd.dpi.left + _vd.dpi.width);
 
+	const bool use_cache = _settings_client.gui.cache_viewport_landscape;
+	if (!use_cache || _landscape_sprite_cache_snowline != GetSnowLine() || _landscape_sprite_cache.size() > LANDSCAPE_SPRITE_CACHE_MAX_ENTRIES) {
+		if (!_landscape_sprite_cache.empty()) ClearLandscapeSpriteCache();
+		_landscape_sprite_cache_snowline = GetSnowLine();
+	}
+
 	Point upper_left = InverseRemapCoords(_vd.dpi.left, _vd.dpi.top);
 	Point upper_right = InverseRemapCoords(_vd.dpi.left + _vd.dpi.width, _vd.dpi.top);
 
@@ -1623,7 +2038,11 @@ static void ViewportAddLandscape()
 				_vd.last_foundation_child[1] = nullptr;
 
 				bool no_ground_tiles = min_visible_height > 0;
-				_tile_type_procs[tile_type]->draw_tile_proc(&tile_info, { min_visible_height, no_ground_tiles });
+				if (use_cache && !no_ground_tiles && tile_info.tile != INVALID_TILE) {
+					DrawTileWithLandscapeSpriteCache(&tile_info, tile_type, { min_visible_height, no_ground_tiles });
+				} else {
+					_tile_type_procs[tile_type]->draw_tile_proc(&tile_info, { min_visible_height, no_ground_tiles });
+				}
 				if (tile_info.tile != INVALID_TILE && min_visible_height <= 0) {
 					DrawTileSelection(&tile_info);
 					DrawTileZoning(&tile_info);
@@ -1663,15 +2082,15 @@ void ViewportAddString(const DrawPixelInfo *dpi, ZoomLevel small_from, const Vie
 	}
 
 	if (!small) {
-		AddStringToDraw(sign->center - sign_half_width, sign->top, string_normal, params_1, params_2, colour, sign->width_normal);
+		AddStringToDraw(sign->center - sign_half_width, sign->top, string_normal, params_1, params_2, colour, sign->width_normal, sign);
 	} else {
 		int shadow_offset = 0;
 		if (string_small_shadow != STR_NULL) {
 			shadow_offset = 4;
-			AddStringToDraw(sign->center - sign_half_width + shadow_offset, sign->top, string_small_shadow, params_1, params_2, INVALID_COLOUR, sign->width_small);
+			AddStringToDraw(sign->center - sign_half_width + shadow_offset, sign->top, string_small_shadow, params_1, params_2, INVALID_COLOUR, sign->width_small, sign);
 		}
 		AddStringToDraw(sign->center - sign_half_width, sign->top - shadow_offset, string_small, params_1, params_2,
-				colour, sign->width_small | 0x8000);
+				colour, sign->width_small | 0x8000, sign);
 	}
 }
 
@@ -1796,6 +2215,9 @@ void ViewportSign::UpdatePosition(ZoomLevel maxzoom, int center, int top, String
 {
 	if (this->width_normal != 0) this->MarkDirty(maxzoom);
 
+	/* The texts of the sign are likely to have changed too. */
+	_viewport_sign_text_cache.erase(this);
+
 	this->top = top;
 
 	char buffer[DRAW_STRING_BUFFER];
@@ -1913,6 +2335,112 @@ static void ViewportSortParentSprites(ParentSpriteToSortVector *psdv)
 	}
 }
 
+/**
+ * Sort parent sprites pointer array, giving the same order as ViewportSortParentSprites.
+ * The sprites are bucketed by the sum of their minimal world X and Y coordinates, so only the sprites
+ * which can possibly be behind a sprite are compared with it, instead of all following sprites.
+ * Sprites which have to be drawn before a sprite are moved in front of it using a stack of pending
+ * sprites, in the same order in which the original sorter moves them.
+ */
+static void ViewportSortParentSpritesBucketed(ParentSpriteToSortVector *psdv)
+{
+	const uint count = (uint)psdv->size();
+	if (count < 2) return;
+
+	const uint32 ORDER_COMPARED = UINT32_MAX;     ///< Sprite was compared, but the sprites moved in front of it still have to be drawn.
+	const uint32 ORDER_RETURNED = UINT32_MAX - 1; ///< Sprite was sorted, further entries of it in the stack are ignored.
+	const uint LIST_END = UINT_MAX;
+
+	const ParentSpriteToSortVector sprites = *psdv;
+
+	/* Position in the pending order of each sprite, the first sprite is on top of the stack. */
+	std::vector<uint32> order(count);
+	std::vector<uint> pending;
+	pending.reserve(count);
+	uint32 next_order = 0;
+	for (uint i = count; i-- > 0;) {
+		order[i] = next_order++;
+		pending.push_back(i);
+	}
+
+	/* Unsorted sprites in a linked list, in order of the sum of their minimal X and Y. Entry 0 is the list head. */
+	std::vector<std::pair<int64, uint>> buckets(count + 1);
+	for (uint i = 0; i < count; i++) buckets[i + 1] = std::make_pair((int64)sprites[i]->xmin + sprites[i]->ymin, i);
+	std::stable_sort(buckets.begin() + 1, buckets.end(), [](const std::pair<int64, uint> &a, const std::pair<int64, uint> &b) {
+		return a.first < b.first;
+	});
+	std::vector<uint> next(count + 1);
+	for (uint i = 0; i < count; i++) next[i] = i + 1;
+	next[count] = LIST_END;
+
+	std::vector<uint> preceding;
+	auto out = psdv->begin();
+
+	while (!pending.empty()) {
+		const uint si = pending.back();
+		pending.pop_back();
+		const ParentSpriteToDraw *s = sprites[si];
+
+		if (order[si] == ORDER_RETURNED) continue;
+
+		if (order[si] == ORDER_COMPARED) {
+			*(out++) = sprites[si];
+			order[si] = ORDER_RETURNED;
+			continue;
+		}
+
+		/* Only sprites with xmin <= s->xmax and ymin <= s->ymax can be behind s. Also walk up to
+		 * the maximum of both coordinates, as the minimum can exceed the maximum, such that s itself
+		 * is always found and removed from the list. */
+		const int64 ssum = (int64)max(s->xmax, s->xmin) + max(s->ymax, s->ymin);
+		preceding.clear();
+		uint prev = 0;
+		for (uint cur = next[0]; cur != LIST_END && buckets[cur].first <= ssum;) {
+			const uint pi = buckets[cur].second;
+			if (pi == si) {
+				next[prev] = next[cur];
+				cur = next[cur];
+				continue;
+			}
+
+			prev = cur;
+			cur = next[cur];
+
+			const ParentSpriteToDraw *p = sprites[pi];
+			if (s->xmax < p->xmin || s->ymax < p->ymin || s->zmax < p->zmin) continue;
+			if (s->xmin <= p->xmax && // overlap in X?
+					s->ymin <= p->ymax && // overlap in Y?
+					s->zmin <= p->zmax) { // overlap in Z?
+				if (s->xmin + s->xmax + s->ymin + s->ymax + s->zmin + s->zmax <=
+						p->xmin + p->xmax + p->ymin + p->ymax + p->zmin + p->zmax) {
+					continue;
+				}
+			}
+			preceding.push_back(pi);
+		}
+
+		if (preceding.empty()) {
+			*(out++) = sprites[si];
+			order[si] = ORDER_RETURNED;
+			continue;
+		}
+
+		/* Move the preceding sprites in front of s, keeping their relative order. */
+		std::sort(preceding.begin(), preceding.end(), [&order](uint a, uint b) {
+			return order[a] > order[b];
+		});
+
+		order[si] = ORDER_COMPARED;
+		pending.push_back(si);
+
+		for (uint pi : preceding) {
+			order[pi] = next_order++;
+			pending.push_back(pi);
+		}
+	}
+	assert(out == psdv->end());
+}
+
 static void ViewportDrawParentSprites(const ParentSpriteToSortVector *psd, const ChildScreenSpriteToDrawVector *csstdv)
 {
 	for (const ParentSpriteToDraw *ps : *psd) {
@@ -1952,7 +2480,7 @@ static void ViewportDrawBoundingBoxes(const ParentSpriteToSortVector *psd)
 	}
 }
 
-static void ViewportMapStoreBridge(const ViewPort * const vp, const TileIndex tile)
+static void ViewportMapStoreBridge(ViewportDrawer &vd, const ViewPort * const vp, const TileIndex tile)
 {
 	extern LegendAndColour _legend_land_owners[NUM_NO_COMPANY_ENTRIES + MAX_COMPANIES + 1];
 	extern uint _company_to_list_pos[MAX_COMPANIES];
@@ -1965,41 +2493,41 @@ static void ViewportMapStoreBridge(const ViewPort * const vp, const TileIndex ti
 	switch (GetTunnelBridgeDirection(tile)) {
 		case DIAGDIR_NE: {
 			/* X axis: tile at higher coordinate, facing towards lower coordinate */
-			auto iter = _vd.bridge_to_map_x.lower_bound(tile);
-			if (iter != _vd.bridge_to_map_x.begin()) {
+			auto iter = vd.bridge_to_map_x.lower_bound(tile);
+			if (iter != vd.bridge_to_map_x.begin()) {
 				auto prev = iter;
 				--prev;
 				if (prev->second == tile) return;
 			}
-			_vd.bridge_to_map_x.insert(iter, std::make_pair(GetOtherTunnelBridgeEnd(tile), tile));
+			vd.bridge_to_map_x.insert(iter, std::make_pair(GetOtherTunnelBridgeEnd(tile), tile));
 			break;
 		}
 
 		case DIAGDIR_NW: {
 			/* Y axis: tile at higher coordinate, facing towards lower coordinate */
-			auto iter = _vd.bridge_to_map_y.lower_bound(tile);
-			if (iter != _vd.bridge_to_map_y.begin()) {
+			auto iter = vd.bridge_to_map_y.lower_bound(tile);
+			if (iter != vd.bridge_to_map_y.begin()) {
 				auto prev = iter;
 				--prev;
 				if (prev->second == tile) return;
 			}
-			_vd.bridge_to_map_y.insert(iter, std::make_pair(GetOtherTunnelBridgeEnd(tile), tile));
+			vd.bridge_to_map_y.insert(iter, std::make_pair(GetOtherTunnelBridgeEnd(tile), tile));
 			break;
 		}
 
 		case DIAGDIR_SW: {
 			/* X axis: tile at lower coordinate, facing towards higher coordinate */
-			auto iter = _vd.bridge_to_map_x.lower_bound(tile);
-			if (iter != _vd.bridge_to_map_x.end() && iter->first == tile) return;
-			_vd.bridge_to_map_x.insert(iter, std::make_pair(tile, GetOtherTunnelBridgeEnd(tile)));
+			auto iter = vd.bridge_to_map_x.lower_bound(tile);
+			if (iter != vd.bridge_to_map_x.end() && iter->first == tile) return;
+			vd.bridge_to_map_x.insert(iter, std::make_pair(tile, GetOtherTunnelBridgeEnd(tile)));
 			break;
 		}
 
 		case DIAGDIR_SE: {
 			/* Y axis: tile at lower coordinate, facing towards higher coordinate */
-			auto iter = _vd.bridge_to_map_y.lower_bound(tile);
-			if (iter != _vd.bridge_to_map_y.end() && iter->first == tile) return;
-			_vd.bridge_to_map_y.insert(iter, std::make_pair(tile, GetOtherTunnelBridgeEnd(tile)));
+			auto iter = vd.bridge_to_map_y.lower_bound(tile);
+			if (iter != vd.bridge_to_map_y.end() && iter->first == tile) return;
+			vd.bridge_to_map_y.insert(iter, std::make_pair(tile, GetOtherTunnelBridgeEnd(tile)));
 			break;
 		}
 
@@ -2102,8 +2630,37 @@ static void ViewportDrawDirtyBlocks()
 	} while (--bottom > 0);
 }
 
+/**
+ * Get the formatted text of a string of a viewport sign, formatting it only when it is not in the cache.
+ * @param ss The string to draw.
+ * @return The text, valid until the cache of the sign changes.
+ */
+static const char *GetViewportSignText(const StringSpriteToDraw &ss)
+{
+	ViewportSignTexts &texts = _viewport_sign_text_cache[ss.sign];
+	for (const ViewportSignText &text : texts.texts) {
+		if (text.string == ss.string && text.params[0] == ss.params[0] && text.params[1] == ss.params[1]) return text.text.c_str();
+	}
+
+	ViewportSignText &text = texts.texts[texts.next];
+	texts.next = (texts.next + 1) % lengthof(texts.texts);
+
+	char buffer[DRAW_STRING_BUFFER];
+	SetDParam(0, ss.params[0]);
+	SetDParam(1, ss.params[1]);
+	GetString(buffer, ss.string, lastof(buffer));
+
+	text.string = ss.string;
+	text.params[0] = ss.params[0];
+	text.params[1] = ss.params[1];
+	text.text = buffer;
+	return text.text.c_str();
+}
+
 static void ViewportDrawStrings(ZoomLevel zoom, const StringSpriteToDrawVector *sstdv)
 {
+	if (_viewport_sign_text_cache.size() > MAX_VIEWPORT_SIGN_TEXT_CACHE) _viewport_sign_text_cache.clear();
+
 	for (const StringSpriteToDraw &ss : *sstdv) {
 		TextColour colour = TC_BLACK;
 		bool small = HasBit(ss.width, 15);
@@ -2112,9 +2669,6 @@ static void ViewportDrawStrings(ZoomLevel zoom, const StringSpriteToDrawVector *
 		int y = UnScaleByZoom(ss.y, zoom);
 		int h = VPSM_TOP + (small ? FONT_HEIGHT_SMALL : FONT_HEIGHT_NORMAL) + VPSM_BOTTOM;
 
-		SetDParam(0, ss.params[0]);
-		SetDParam(1, ss.params[1]);
-
 		if (ss.colour != INVALID_COLOUR) {
 			/* Do not draw signs nor station names if they are set invisible */
 			if (IsInvisibilitySet(TO_SIGNS) && ss.string != STR_WHITE_SIGN) continue;
@@ -2134,7 +2688,13 @@ static void ViewportDrawStrings(ZoomLevel zoom, const StringSpriteToDrawVector *
 			}
 		}
 
-		DrawString(x + VPSM_LEFT, x + w - 1 - VPSM_RIGHT, y + VPSM_TOP, ss.string, colour, SA_HOR_CENTER);
+		if (ss.sign != nullptr) {
+			DrawString(x + VPSM_LEFT, x + w - 1 - VPSM_RIGHT, y + VPSM_TOP, GetViewportSignText(ss), colour, SA_HOR_CENTER);
+		} else {
+			SetDParam(0, ss.params[0]);
+			SetDParam(1, ss.params[1]);
+			DrawString(x + VPSM_LEFT, x + w - 1 - VPSM_RIGHT, y + VPSM_TOP, ss.string, colour, SA_HOR_CENTER);
+		}
 	}
 }
 
@@ -2675,33 +3235,33 @@ static inline uint32 ViewportMapGetColourOwner(const TileIndex tile, TileType t,
 	return colour;
 }
 
-static inline void ViewportMapStoreBridgeAboveTile(const ViewPort * const vp, const TileIndex tile)
+static inline void ViewportMapStoreBridgeAboveTile(ViewportDrawer &vd, const ViewPort * const vp, const TileIndex tile)
 {
 	/* No need to bother for hidden things */
 	if (!_settings_client.gui.show_bridges_on_map) return;
 
 	if (GetBridgeAxis(tile) == AXIS_X) {
-		auto iter = _vd.bridge_to_map_x.lower_bound(tile);
-		if (iter != _vd.bridge_to_map_x.end() && iter->first < tile && iter->second > tile) return; /* already covered */
-		_vd.bridge_to_map_x.insert(iter, std::make_pair(GetNorthernBridgeEnd(tile), GetSouthernBridgeEnd(tile)));
+		auto iter = vd.bridge_to_map_x.lower_bound(tile);
+		if (iter != vd.bridge_to_map_x.end() && iter->first < tile && iter->second > tile) return; /* already covered */
+		vd.bridge_to_map_x.insert(iter, std::make_pair(GetNorthernBridgeEnd(tile), GetSouthernBridgeEnd(tile)));
 	} else {
-		auto iter = _vd.bridge_to_map_y.lower_bound(tile);
-		if (iter != _vd.bridge_to_map_y.end() && iter->first < tile && iter->second > tile) return; /* already covered */
-		_vd.bridge_to_map_y.insert(iter, std::make_pair(GetNorthernBridgeEnd(tile), GetSouthernBridgeEnd(tile)));
+		auto iter = vd.bridge_to_map_y.lower_bound(tile);
+		if (iter != vd.bridge_to_map_y.end() && iter->first < tile && iter->second > tile) return; /* already covered */
+		vd.bridge_to_map_y.insert(iter, std::make_pair(GetNorthernBridgeEnd(tile), GetSouthernBridgeEnd(tile)));
 	}
 }
 
-static inline TileIndex ViewportMapGetMostSignificantTileType(const ViewPort * const vp, const TileIndex from_tile, TileType * const tile_type)
+static inline TileIndex ViewportMapGetMostSignificantTileType(ViewportDrawer &vd, const ViewPort * const vp, const TileIndex from_tile, TileType * const tile_type)
 {
 	if (vp->zoom <= ZOOM_LVL_OUT_128X || !_settings_client.gui.viewport_map_scan_surroundings) {
 		const TileType ttype = GetTileType(from_tile);
 		/* Store bridges and tunnels. */
 		if (ttype != MP_TUNNELBRIDGE) {
 			*tile_type = ttype;
-			if (IsBridgeAbove(from_tile)) ViewportMapStoreBridgeAboveTile(vp, from_tile);
+			if (IsBridgeAbove(from_tile)) ViewportMapStoreBridgeAboveTile(vd, vp, from_tile);
 		} else {
 			if (IsBridge(from_tile)) {
-				ViewportMapStoreBridge(vp, from_tile);
+				ViewportMapStoreBridge(vd, vp, from_tile);
 			}
 			switch (GetTunnelBridgeTransportType(from_tile)) {
 				case TRANSPORT_RAIL:  *tile_type = MP_RAILWAY; break;
@@ -2728,7 +3288,7 @@ static inline TileIndex ViewportMapGetMostSignificantTileType(const ViewPort * c
 			result = tile;
 		}
 		if (ttype != MP_TUNNELBRIDGE && IsBridgeAbove(tile)) {
-			ViewportMapStoreBridgeAboveTile(vp, tile);
+			ViewportMapStoreBridgeAboveTile(vd, vp, tile);
 		}
 	}
 
@@ -2736,7 +3296,7 @@ static inline TileIndex ViewportMapGetMostSignificantTileType(const ViewPort * c
 	*tile_type = GetTileType(result);
 	if (*tile_type == MP_TUNNELBRIDGE) {
 		if (IsBridge(result)) {
-			ViewportMapStoreBridge(vp, result);
+			ViewportMapStoreBridge(vd, vp, result);
 		}
 		switch (GetTunnelBridgeTransportType(result)) {
 			case TRANSPORT_RAIL: *tile_type = MP_RAILWAY; break;
@@ -2748,9 +3308,230 @@ static inline TileIndex ViewportMapGetMostSignificantTileType(const ViewPort * c
 	return result;
 }
 
-/** Get the colour of a tile, can be 32bpp RGB or 8bpp palette index. */
+/** Map mode colours of a square block of tiles, for each of the four colour indices. */
+struct ViewportMapColourBlock {
+	static const uint SHIFT = 4;                              ///< Log2 of the width and height of a block in tiles.
+	static const uint SLOTS = 4 << (2 * SHIFT);               ///< Number of colours in a block.
+
+	std::atomic<uint64> valid[SLOTS / 64];                    ///< Bitmask of the colours which have been computed.
+	std::atomic<uint32> colours[SLOTS];                       ///< Colour, by tile and colour index.
+	std::atomic<uint32> last_used;                            ///< Draw in which the block was last used, see ViewportMapColourCache::draw_count.
+
+	ViewportMapColourBlock(uint32 draw_count) : valid(), colours(), last_used(draw_count) {}
+};
+
+/**
+ * Persistent map mode colours of the tiles for a #ViewportMapType, sized to the map.
+ * The colours are filled in lazily by the (concurrent) drawing of the map, and forgotten when a tile changes.
+ * The storage of each block of tiles is allocated when the block is first drawn; when too many blocks are allocated
+ * the least recently drawn ones are freed before the next draw.
+ */
+struct ViewportMapColourCache {
+	static const uint MAX_BLOCKS = 1 << 15;                   ///< Number of allocated blocks above which no more blocks are allocated during a draw.
+	static const uint EVICT_BLOCKS = MAX_BLOCKS - MAX_BLOCKS / 8; ///< Number of allocated blocks above which the least recently drawn blocks are freed.
+
+	std::vector<std::atomic<ViewportMapColourBlock *>> blocks; ///< Blocks of colours, allocated when first drawn.
+	std::atomic<uint> allocated;                              ///< Number of allocated blocks.
+	uint64 signature;                                         ///< Signature of the settings the colours were computed with.
+	uint32 draw_count;                                        ///< Number of draws the cache was prepared for.
+
+	ViewportMapColourCache() : allocated(0), signature(0), draw_count(0) {}
+	~ViewportMapColourCache() { this->Clear(); }
+
+	void Clear()
+	{
+		for (auto &block : this->blocks) {
+			delete block.load(std::memory_order_relaxed);
+			block.store(nullptr, std::memory_order_relaxed);
+		}
+		this->allocated.store(0, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Make the cache ready for drawing, emptying it when the map or the colour settings have changed.
+	 * @param signature Signature of the current colour settings.
+	 */
+	void Prepare(uint64 signature)
+	{
+		const size_t block_count = MapSize() >> (2 * ViewportMapColourBlock::SHIFT);
+		if (this->blocks.size() != block_count) {
+			this->Clear();
+			std::vector<std::atomic<ViewportMapColourBlock *>>(block_count).swap(this->blocks);
+		} else if (this->signature != signature) {
+			this->Clear();
+		} else if (this->allocated.load(std::memory_order_relaxed) > EVICT_BLOCKS) {
+			this->EvictLeastRecentlyUsed(EVICT_BLOCKS / 2);
+		}
+		this->signature = signature;
+		this->draw_count++;
+	}
+
+	/**
+	 * Free the least recently drawn blocks.
+	 * @param keep Number of blocks to keep.
+	 */
+	void EvictLeastRecentlyUsed(uint keep)
+	{
+		std::vector<std::pair<uint32, size_t>> used;
+		used.reserve(this->allocated.load(std::memory_order_relaxed));
+		for (size_t i = 0; i < this->blocks.size(); i++) {
+			ViewportMapColourBlock *block = this->blocks[i].load(std::memory_order_relaxed);
+			if (block != nullptr) used.emplace_back(this->draw_count - block->last_used.load(std::memory_order_relaxed), i);
+		}
+		if (used.size() <= keep) return;
+
+		/* Move the most recently drawn blocks to the front. */
+		std::nth_element(used.begin(), used.begin() + keep, used.end());
+		for (auto it = used.begin() + keep; it != used.end(); ++it) {
+			delete this->blocks[it->second].load(std::memory_order_relaxed);
+			this->blocks[it->second].store(nullptr, std::memory_order_relaxed);
+		}
+		this->allocated.store(keep, std::memory_order_relaxed);
+	}
+
+	inline size_t GetBlockIndex(TileIndex tile) const
+	{
+		return (TileY(tile) >> ViewportMapColourBlock::SHIFT) * (MapSizeX() >> ViewportMapColourBlock::SHIFT) + (TileX(tile) >> ViewportMapColourBlock::SHIFT);
+	}
+
+	static inline uint GetSlot(TileIndex tile, uint colour_index)
+	{
+		const uint mask = (1 << ViewportMapColourBlock::SHIFT) - 1;
+		return ((((TileY(tile) & mask) << ViewportMapColourBlock::SHIFT) | (TileX(tile) & mask)) << 2) | colour_index;
+	}
+
+	/**
+	 * Get the block of a tile, allocating it if necessary.
+	 * @param tile The tile.
+	 * @return The block, or \c nullptr when the cache is full.
+	 */
+	ViewportMapColourBlock *GetBlock(TileIndex tile)
+	{
+		std::atomic<ViewportMapColourBlock *> &entry = this->blocks[this->GetBlockIndex(tile)];
+		ViewportMapColourBlock *block = entry.load(std::memory_order_acquire);
+		if (block != nullptr) {
+			if (block->last_used.load(std::memory_order_relaxed) != this->draw_count) block->last_used.store(this->draw_count, std::memory_order_relaxed);
+			return block;
+		}
+		if (this->allocated.load(std::memory_order_relaxed) >= MAX_BLOCKS) return nullptr;
+
+		block = new ViewportMapColourBlock(this->draw_count);
+		ViewportMapColourBlock *existing = nullptr;
+		if (!entry.compare_exchange_strong(existing, block, std::memory_order_acq_rel)) {
+			/* Another thread was first. */
+			delete block;
+			return existing;
+		}
+		this->allocated.fetch_add(1, std::memory_order_relaxed);
+		return block;
+	}
+
+	/**
+	 * Get the colour of a tile from the cache, computing and storing it when it is not known yet.
+	 * @param tile The tile.
+	 * @param colour_index The colour index.
+	 * @param compute Functor computing the colour.
+	 * @return The colour.
+	 */
+	template <typename F>
+	inline uint32 GetColour(TileIndex tile, uint colour_index, F compute)
+	{
+		ViewportMapColourBlock *block = this->GetBlock(tile);
+		if (block == nullptr) return compute();
+
+		const uint slot = GetSlot(tile, colour_index);
+		const uint64 bit = (uint64)1 << (slot & 63);
+		if (block->valid[slot >> 6].load(std::memory_order_acquire) & bit) return block->colours[slot].load(std::memory_order_relaxed);
+
+		const uint32 colour = compute();
+		block->colours[slot].store(colour, std::memory_order_relaxed);
+		block->valid[slot >> 6].fetch_or(bit, std::memory_order_release);
+		return colour;
+	}
+
+	/**
+	 * Forget the colours of a tile.
+	 * @param tile The changed tile.
+	 */
+	void InvalidateTile(TileIndex tile)
+	{
+		if (this->allocated.load(std::memory_order_relaxed) == 0) return;
+		const size_t index = this->GetBlockIndex(tile);
+		if (index >= this->blocks.size()) return;
+		ViewportMapColourBlock *block = this->blocks[index].load(std::memory_order_relaxed);
+		if (block == nullptr) return;
+
+		const uint slot = GetSlot(tile, 0);
+		block->valid[slot >> 6].fetch_and(~((uint64)0xF << (slot & 63)), std::memory_order_relaxed);
+	}
+};
+
+static ViewportMapColourCache _vp_map_colour_cache[VPMT_END];
+
+/**
+ * Empty the map mode colour caches of all #ViewportMapType.
+ */
+void ClearViewportMapColourCache()
+{
+	for (ViewportMapColourCache &cache : _vp_map_colour_cache) cache.Clear();
+}
+
+static void InvalidateViewportMapColourCacheTile(TileIndex tile)
+{
+	for (ViewportMapColourCache &cache : _vp_map_colour_cache) cache.InvalidateTile(tile);
+}
+
+/**
+ * Get a signature of all the state, apart from the tiles, which the colours of a map type depend on.
+ * @return The signature.
+ */
+static uint64 ViewportMapColourSignature(ViewportMapType map_type, bool is_32bpp, bool show_slope)
+{
+	extern LegendAndColour _legend_from_industries[NUM_INDUSTRYTYPES + 1];
+	extern LegendAndColour _legend_land_owners[NUM_NO_COMPANY_ENTRIES + MAX_COMPANIES + 1];
+	extern bool _smallmap_show_heightmap;
+
+	/* FNV-1a */
+	uint64 signature = 0xCBF29CE484222325ULL;
+	auto add = [&](uint64 value) {
+		signature = (signature ^ value) * 0x100000001B3ULL;
+	};
+
+	add(is_32bpp);
+	add(show_slope);
+	add(_settings_client.gui.smallmap_land_colour);
+	add(_settings_game.construction.max_heightlevel);
+	add(_settings_game.game_creation.landscape);
+	switch (map_type) {
+		case VPMT_VEGETATION:
+			add(IsTransparencySet(TO_TREES));
+			add(IsInvisibilitySet(TO_TREES));
+			break;
+
+		case VPMT_OWNER:
+			for (const LegendAndColour &legend : _legend_land_owners) {
+				add(legend.show_on_map);
+				add(legend.colour);
+			}
+			break;
+
+		case VPMT_INDUSTRY:
+			add(_smallmap_show_heightmap);
+			for (const LegendAndColour &legend : _legend_from_industries) add(legend.show_on_map);
+			break;
+
+		default: NOT_REACHED();
+	}
+	return signature;
+}
+
+/**
+ * Get the colour of a tile, can be 32bpp RGB or 8bpp palette index.
+ * Bridges found on the way are stored in the given drawer, such that this can be called for different parts of a viewport concurrently.
+ * The colours of the tiles themselves are looked up in, or added to, the given colour cache.
+ */
 template <bool is_32bpp, bool show_slope>
-uint32 ViewportMapGetColour(const ViewPort * const vp, uint x, uint y, const uint colour_index)
+uint32 ViewportMapGetColour(ViewportDrawer &vd, ViewportMapColourCache &colour_cache, const ViewPort * const vp, uint x, uint y, const uint colour_index)
 {
 	if (!(IsInsideMM(x, TILE_SIZE, MapMaxX() * TILE_SIZE - 1) &&
 		  IsInsideMM(y, TILE_SIZE, MapMaxY() * TILE_SIZE - 1)))
@@ -2771,15 +3552,17 @@ uint32 ViewportMapGetColour(const ViewPort * const vp, uint x, uint y, const uin
 				return 0;
 	}
 	TileType tile_type = MP_VOID;
-	tile = ViewportMapGetMostSignificantTileType(vp, tile, &tile_type);
+	tile = ViewportMapGetMostSignificantTileType(vd, vp, tile, &tile_type);
 	if (tile_type == MP_VOID) return 0;
 
 	/* Return the colours. */
-	switch (vp->map_type) {
-		default:              return ViewportMapGetColourOwner<is_32bpp, show_slope>(tile, tile_type, colour_index);
-		case VPMT_INDUSTRY:   return ViewportMapGetColourIndustries<is_32bpp, show_slope>(tile, tile_type, colour_index);
-		case VPMT_VEGETATION: return ViewportMapGetColourVegetation<is_32bpp, show_slope>(tile, tile_type, colour_index);
-	}
+	return colour_cache.GetColour(tile, colour_index, [&]() -> uint32 {
+		switch (vp->map_type) {
+			default:              return ViewportMapGetColourOwner<is_32bpp, show_slope>(tile, tile_type, colour_index);
+			case VPMT_INDUSTRY:   return ViewportMapGetColourIndustries<is_32bpp, show_slope>(tile, tile_type, colour_index);
+			case VPMT_VEGETATION: return ViewportMapGetColourVegetation<is_32bpp, show_slope>(tile, tile_type, colour_index);
+		}
+	});
 }
 
 /* Taken from http://stereopsis.com/doubleblend.html, PixelBlend() is faster than ComposeColourRGBANoCheck() */
@@ -2853,7 +3636,8 @@ static void ViewportMapDrawScrollingViewportBox(const ViewPort * const vp)
 	}
 }
 
-uint32 *_vp_map_line; ///< Buffer for drawing the map of a viewport.
+/** Number of lines of the map of a viewport which are drawn in one batch on a worker thread. */
+static const uint VIEWPORT_MAP_DRAW_BATCH_LINES = 16;
 
 static void ViewportMapDrawBridgeTunnel(const ViewPort * const vp, const TunnelBridgeToMap * const tbtm, const int z,
 		const bool is_tunnel, const int w, const int h, Blitter * const blitter)
@@ -2903,44 +3687,61 @@ void ViewportMapDraw(const ViewPort * const vp)
 	const  int sx = UnScaleByZoomLower(_vd.dpi.left, _vd.dpi.zoom);
 	const  int sy = UnScaleByZoomLower(_vd.dpi.top, _vd.dpi.zoom);
 	const uint line_padding = 2 * (sy & 1);
-	uint       colour_index_base = (sx + line_padding) & 3;
+	const uint colour_index_start = (sx + line_padding) & 3;
 
 	const  int incr_a = (1 << (vp->zoom - 2)) / ZOOM_LVL_BASE;
 	const  int incr_b = (1 << (vp->zoom - 1)) / ZOOM_LVL_BASE;
 	const  int a = (_vd.dpi.left >> 2) / ZOOM_LVL_BASE;
-	int        b = (_vd.dpi.top >> 1) / ZOOM_LVL_BASE;
+	const  int b_start = (_vd.dpi.top >> 1) / ZOOM_LVL_BASE;
 	const  int w = UnScaleByZoom(_vd.dpi.width, vp->zoom);
 	const  int h = UnScaleByZoom(_vd.dpi.height, vp->zoom);
-	int        j = 0;
-
-	/* Render base map. */
-	do { // For each line
-		int i = w;
-		uint colour_index = colour_index_base;
-		colour_index_base ^= 2;
-		uint32 *vp_map_line_ptr32 = _vp_map_line;
-		uint8 *vp_map_line_ptr8 = (uint8*) _vp_map_line;
-		int c = b - a;
-		int d = b + a;
-		do { // For each pixel of a line
+
+	ViewportMapColourCache &colour_cache = _vp_map_colour_cache[vp->map_type];
+	colour_cache.Prepare(ViewportMapColourSignature(vp->map_type, is_32bpp, show_slope));
+
+	/* Render base map. Batches of lines are rendered on the worker threads, each with its own line buffer and bridge storage.
+	 * The found bridges are merged afterwards; they are keyed by their northern end, so the merge order does not matter. */
+	std::mutex bridge_lock;
+	ViewportDrawer &main_vd = _vd;
+	RunParallelFor(_general_worker_pool, h, VIEWPORT_MAP_DRAW_BATCH_LINES, [&](size_t begin, size_t end) {
+		ViewportDrawer vd;
+		std::vector<uint32> vp_map_line(w);
+		uint colour_index_base = colour_index_start ^ (2 * (begin & 1));
+		int b = b_start + (int)begin * incr_b;
+
+		for (int j = (int)begin; j < (int)end; j++) { // For each line
+			int i = w;
+			uint colour_index = colour_index_base;
+			colour_index_base ^= 2;
+			uint32 *vp_map_line_ptr32 = vp_map_line.data();
+			uint8 *vp_map_line_ptr8 = (uint8*) vp_map_line.data();
+			int c = b - a;
+			int d = b + a;
+			do { // For each pixel of a line
+				if (is_32bpp) {
+					*vp_map_line_ptr32 = ViewportMapGetColour<is_32bpp, show_slope>(vd, colour_cache, vp, c, d, colour_index);
+					vp_map_line_ptr32++;
+				} else {
+					*vp_map_line_ptr8 = (uint8) ViewportMapGetColour<is_32bpp, show_slope>(vd, colour_cache, vp, c, d, colour_index);
+					vp_map_line_ptr8++;
+				}
+				colour_index = (colour_index + 1) & 3;
+				c -= incr_a;
+				d += incr_a;
+			} while (--i);
 			if (is_32bpp) {
-				*vp_map_line_ptr32 = ViewportMapGetColour<is_32bpp, show_slope>(vp, c, d, colour_index);
-				vp_map_line_ptr32++;
+				blitter->SetLine32(main_vd.dpi.dst_ptr, 0, j, vp_map_line.data(), w);
 			} else {
-				*vp_map_line_ptr8 = (uint8) ViewportMapGetColour<is_32bpp, show_slope>(vp, c, d, colour_index);
-				vp_map_line_ptr8++;
+				blitter->SetLine(main_vd.dpi.dst_ptr, 0, j, (uint8*) vp_map_line.data(), w);
 			}
-			colour_index = (colour_index + 1) & 3;
-			c -= incr_a;
-			d += incr_a;
-		} while (--i);
-		if (is_32bpp) {
-			blitter->SetLine32(_vd.dpi.dst_ptr, 0, j, _vp_map_line, w);
-		} else {
-			blitter->SetLine(_vd.dpi.dst_ptr, 0, j, (uint8*) _vp_map_line, w);
+			b += incr_b;
 		}
-		b += incr_b;
-	} while (++j < h);
+
+		if (vd.bridge_to_map_x.empty() && vd.bridge_to_map_y.empty()) return;
+		std::lock_guard<std::mutex> lock(bridge_lock);
+		main_vd.bridge_to_map_x.insert(vd.bridge_to_map_x.begin(), vd.bridge_to_map_x.end());
+		main_vd.bridge_to_map_y.insert(vd.bridge_to_map_y.begin(), vd.bridge_to_map_y.end());
+	});
 
 	auto draw_tunnels = [&](const int y_intercept_min, const int y_intercept_max, const TunnelToMapStorage &storage) {
 		auto iter = std::lower_bound(storage.tunnels.begin(), storage.tunnels.end(), y_intercept_min, [](const TunnelToMap &a, int b) -> bool {
@@ -3058,8 +3859,18 @@ static void ViewportProcessParentSprites()
 		}
 		_cur_dpi->dst_ptr = saved_dst_ptr;
 	} else {
-		_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
-		ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
+		if (unlikely(_vp_sprite_sorter_capture) && !IsNonMainThread() && _vd.parent_sprites_to_sort.size() > _vp_sprite_sorter_captured.size()) {
+			_vp_sprite_sorter_captured.clear();
+			for (const ParentSpriteToDraw *ps : _vd.parent_sprites_to_sort) _vp_sprite_sorter_captured.push_back(*ps);
+		}
+		{
+			ViewportDrawPhaseTimer timer(VDP_SORT);
+			_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
+		}
+		{
+			ViewportDrawPhaseTimer timer(VDP_BLIT);
+			ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
+		}
 
 		if (_draw_dirty_blocks && HasBit(_viewport_debug_flags, VDF_DIRTY_BLOCK_PER_SPLIT)) {
 			ViewportDrawDirtyBlocks();
@@ -3097,7 +3908,12 @@ void ViewportDoDraw(ViewPort *vp, int left, int top, int right, int bottom)
 	_dpi_for_text.height = UnScaleByZoom(_dpi_for_text.height, _dpi_for_text.zoom);
 	_dpi_for_text.zoom   = ZOOM_LVL_NORMAL;
 
+	/* Collecting the sprites runs the tile draw procs and the landscape sprite cache, which use shared state. */
+	std::unique_lock<std::mutex> parallel_draw_lock(_vp_parallel_draw_mutex, std::defer_lock);
+	if (_vp_parallel_draw) parallel_draw_lock.lock();
+
 	if (vp->zoom >= ZOOM_LVL_DRAW_MAP) {
+		ViewportDrawPhaseTimer timer(VDP_COLLECT);
 		/* Here the rendering is like smallmap. */
 		if (BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 32) {
 			if (_settings_client.gui.show_slopes_on_viewport_map) ViewportMapDraw<true, true>(vp);
@@ -3112,14 +3928,23 @@ void ViewportDoDraw(ViewPort *vp, int left, int top, int right, int bottom)
 		if (vp->zoom < ZOOM_LVL_OUT_256X) ViewportAddKdtreeSigns(&_vd.dpi, true);
 	} else {
 		/* Classic rendering. */
-		ViewportAddLandscape();
-		ViewportAddVehicles(&_vd.dpi);
+		{
+			ViewportDrawPhaseTimer timer(VDP_COLLECT);
+			ViewportAddLandscape();
+			ViewportAddVehicles(&_vd.dpi);
+
+			ViewportAddKdtreeSigns(&_vd.dpi, false);
 
-		ViewportAddKdtreeSigns(&_vd.dpi, false);
+			DrawTextEffects(&_vd.dpi);
+		}
 
-		DrawTextEffects(&_vd.dpi);
+		/* Sorting and blitting only use the state of this thread. */
+		if (parallel_draw_lock.owns_lock()) parallel_draw_lock.unlock();
 
-		if (_vd.tile_sprites_to_draw.size() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
+		if (_vd.tile_sprites_to_draw.size() != 0) {
+			ViewportDrawPhaseTimer timer(VDP_BLIT);
+			ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
+		}
 
 		for (auto &psd : _vd.parent_sprites_to_draw) {
 			_vd.parent_sprites_to_sort.push_back(&psd);
@@ -3134,6 +3959,11 @@ void ViewportDoDraw(ViewPort *vp, int left, int top, int right, int bottom)
 		if (HasBit(_viewport_debug_flags, VDF_DIRTY_BLOCK_PER_DRAW)) ++_dirty_block_colour;
 	}
 
+	/* Drawing strings uses the global string parameters, and the font and layout caches. */
+	if (_vp_parallel_draw && !parallel_draw_lock.owns_lock()) parallel_draw_lock.lock();
+
+	ViewportDrawPhaseTimer strings_timer(VDP_STRINGS);
+
 	DrawPixelInfo dp = _vd.dpi;
 	ZoomLevel zoom = _vd.dpi.zoom;
 	dp.zoom = ZOOM_LVL_NORMAL;
@@ -3169,21 +3999,41 @@ void ViewportDoDraw(ViewPort *vp, int left, int top, int right, int bottom)
 	_vd.child_screen_sprites_to_draw.clear();
 }
 
+/**
+ * Allow ViewportDoDraw() to be called from several threads at once, each drawing a different area, until EndViewportParallelDraw().
+ * Only the sorting and blitting of the sprites then run in parallel, the other phases use shared state and run one at a time.
+ * The main thread must not change the game state meanwhile.
+ */
+void BeginViewportParallelDraw()
+{
+	assert(!_vp_parallel_draw);
+	BeginSpriteCacheSharing();
+	_vp_parallel_draw = true;
+}
+
+/** End drawing viewports in parallel, see BeginViewportParallelDraw(). */
+void EndViewportParallelDraw()
+{
+	assert(_vp_parallel_draw);
+	_vp_parallel_draw = false;
+	EndSpriteCacheSharing();
+}
+
 /**
  * Make sure we don't draw a too big area at a time.
  * If we do, the sprite sorter will run into major performance problems and the sprite memory may overflow.
  */
-void ViewportDrawChk(ViewPort *vp, int left, int top, int right, int bottom)
+static void ViewportDrawArea(ViewPort *vp, int left, int top, int right, int bottom)
 {
 	if ((vp->zoom < ZOOM_LVL_DRAW_MAP) && ((int64)ScaleByZoom(bottom - top, vp->zoom) * (int64)ScaleByZoom(right - left, vp->zoom) > (int64)(1000000 * ZOOM_LVL_BASE * ZOOM_LVL_BASE))) {
 		if ((bottom - top) > (right - left)) {
 			int t = (top + bottom) >> 1;
-			ViewportDrawChk(vp, left, top, right, t);
-			ViewportDrawChk(vp, left, t, right, bottom);
+			ViewportDrawArea(vp, left, top, right, t);
+			ViewportDrawArea(vp, left, t, right, bottom);
 		} else {
 			int t = (left + right) >> 1;
-			ViewportDrawChk(vp, left, top, t, bottom);
-			ViewportDrawChk(vp, t, top, right, bottom);
+			ViewportDrawArea(vp, left, top, t, bottom);
+			ViewportDrawArea(vp, t, top, right, bottom);
 		}
 	} else {
 		ViewportDoDraw(vp,
@@ -3195,6 +4045,37 @@ void ViewportDrawChk(ViewPort *vp, int left, int top, int right, int bottom)
 	}
 }
 
+/**
+ * Draw an area of a viewport, in screen coordinates.
+ * A wide area drawn with sprites is split into strips, one for each thread of the general worker pool, which are drawn in parallel.
+ * The strips collect their sprites one at a time, and sort and blit them in parallel, see BeginViewportParallelDraw().
+ */
+void ViewportDrawChk(ViewPort *vp, int left, int top, int right, int bottom)
+{
+	const int width = right - left;
+	const uint threads = _general_worker_pool.GetThreadCount();
+	if (vp->zoom >= ZOOM_LVL_DRAW_MAP || threads == 0 || _vp_parallel_draw || _draw_dirty_blocks || width < 2 * VIEWPORT_MIN_DRAW_STRIP_WIDTH) {
+		ViewportDrawArea(vp, left, top, right, bottom);
+		return;
+	}
+
+	const int strips = min<int>(width / VIEWPORT_MIN_DRAW_STRIP_WIDTH, threads + 1);
+	DrawPixelInfo *caller_dpi = _cur_dpi;
+	BeginViewportParallelDraw();
+	RunParallelFor(_general_worker_pool, strips, 1, [&](size_t begin, size_t end) {
+		DrawPixelInfo dpi = *caller_dpi;
+		DrawPixelInfo *old_dpi = _cur_dpi;
+		_cur_dpi = &dpi;
+
+		for (size_t strip = begin; strip < end; strip++) {
+			ViewportDrawArea(vp, left + width * (int)strip / strips, top, left + width * (int)(strip + 1) / strips, bottom);
+		}
+
+		_cur_dpi = old_dpi;
+	});
+	EndViewportParallelDraw();
+}
+
 static inline void ViewportDraw(ViewPort *vp, int left, int top, int right, int bottom)
 {
 	if (right <= vp->left || bottom <= vp->top) return;
@@ -3503,6 +4384,10 @@ void ConstrainAllViewportsZoom()
  */
 void MarkTileDirtyByTile(TileIndex tile, const ZoomLevel mark_dirty_if_zoomlevel_is_below, int bridge_level_offset, int tile_height_override)
 {
+	InvalidateLandscapeSpriteCacheTile(tile);
+	/* Also changes which aren't redrawn in map mode, like tree growth, may change the map colour of the tile. */
+	InvalidateViewportMapColourCacheTile(tile);
+	InvalidateSmallMapColourCacheTile(tile);
 	Point pt = RemapCoords(TileX(tile) * TILE_SIZE, TileY(tile) * TILE_SIZE, tile_height_override * TILE_HEIGHT);
 	MarkAllViewportsDirty(
 			pt.x - 31  * ZOOM_LVL_BASE,
@@ -3515,6 +4400,10 @@ void MarkTileDirtyByTile(TileIndex tile, const ZoomLevel mark_dirty_if_zoomlevel
 
 void MarkTileGroundDirtyByTile(TileIndex tile, const ZoomLevel mark_dirty_if_zoomlevel_is_below)
 {
+	InvalidateLandscapeSpriteCacheTile(tile);
+	/* Also changes which aren't redrawn in map mode, like tree growth, may change the map colour of the tile. */
+	InvalidateViewportMapColourCacheTile(tile);
+	InvalidateSmallMapColourCacheTile(tile);
 	int x = TileX(tile) * TILE_SIZE;
 	int y = TileY(tile) * TILE_SIZE;
 	Point top = RemapCoords(x, y, GetTileMaxPixelZ(tile));
@@ -5443,6 +6332,7 @@ struct ViewportSSCSS {
 
 /** List of sorters ordered from best to worst. */
 static ViewportSSCSS _vp_sprite_sorters[] = {
+	{ &ViewportSortParentSpritesChecker, &ViewportSortParentSpritesBucketed },
 #ifdef WITH_SSE
 	{ &ViewportSortParentSpritesSSE41Checker, &ViewportSortParentSpritesSSE41 },
 #endif
@@ -5461,6 +6351,201 @@ void InitializeSpriteSorter()
 	assert(_vp_sprite_sorter != nullptr);
 }
 
+/**
+ * Start capturing the parent sprite lists which are sorted when drawing viewports, for the sprite sorter benchmark.
+ * The largest list which is sorted from now on is kept.
+ */
+void ViewportStartSpriteSorterCapture()
+{
+	_vp_sprite_sorter_captured.clear();
+	_vp_sprite_sorter_capture = true;
+	MarkWholeScreenDirty();
+}
+
+/**
+ * Benchmark all available sprite sorters on the captured parent sprite list, and check that they give the same order.
+ * @param iterations Number of times to sort the list with each sorter.
+ */
+void ViewportRunSpriteSorterBenchmark(uint iterations)
+{
+	_vp_sprite_sorter_capture = false;
+	if (_vp_sprite_sorter_captured.empty()) {
+		IConsolePrint(CC_WARNING, "No parent sprites captured, use 'viewport_sort_benchmark capture' and let the viewports redraw first");
+		return;
+	}
+
+	IConsolePrintF(CC_DEFAULT, "Sorting %u parent sprites %u times", (uint)_vp_sprite_sorter_captured.size(), iterations);
+
+	/* The last sorter is the plain reference implementation, compare the order of the others with it. */
+	std::vector<uint> reference;
+	for (uint i = lengthof(_vp_sprite_sorters); i-- > 0;) {
+		if (!_vp_sprite_sorters[i].fct_checker()) continue;
+
+		ParentSpriteToDrawVector sprites(_vp_sprite_sorter_captured.begin(), _vp_sprite_sorter_captured.end());
+		ParentSpriteToSortVector psdv;
+		uint64 total_us = 0;
+		for (uint iter = 0; iter < iterations; iter++) {
+			psdv.clear();
+			for (ParentSpriteToDraw &ps : sprites) {
+				ps.SetComparisonDone(false);
+				psdv.push_back(&ps);
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			_vp_sprite_sorters[i].fct_sorter(&psdv);
+			total_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		std::vector<uint> result;
+		for (const ParentSpriteToDraw *ps : psdv) result.push_back((uint)(ps - sprites.data()));
+		bool same = reference.empty() || result == reference;
+		if (reference.empty()) reference = std::move(result);
+
+		IConsolePrintF(same ? CC_DEFAULT : CC_ERROR, "Sorter %u%s: %u us per sort%s", i, _vp_sprite_sorters[i].fct_sorter == _vp_sprite_sorter ? " (active)" : "",
+				(uint)(total_us / max(iterations, 1u)), same ? "" : ", order differs from the reference sorter");
+	}
+}
+
+/**
+ * Get a percentile of sorted samples.
+ * @param samples The sorted samples.
+ * @param percent The percentile.
+ * @return The sample, in microseconds.
+ */
+static double RenderBenchmarkPercentile(const std::vector<uint64> &samples, uint percent)
+{
+	size_t index = std::min<size_t>(samples.size() - 1, samples.size() * percent / 100);
+	return samples[index] / 1000.0;
+}
+
+/**
+ * Render a fixed set of viewports at every zoom level and map mode into an offscreen buffer,
+ * and report percentiles of the frame times and of the time spent in each drawing phase.
+ * The viewports are the size of the screen resolution, centred on the middle and the quarter points of the map.
+ * @param iterations Number of times to render each viewport; a first, untimed, round fills the caches.
+ * @param blitter_name Blitter to render with, or \c nullptr for the current one. Only the null video driver allows another blitter.
+ * @param print Function to output the report lines with.
+ * @return False if the benchmark could not be run.
+ */
+bool ViewportRunRenderBenchmark(uint iterations, const char *blitter_name, void (*print)(const char *))
+{
+	char buf[256];
+	if (_game_mode != GM_NORMAL && _game_mode != GM_EDITOR) {
+		print("No game loaded");
+		return false;
+	}
+
+	std::string old_blitter;
+	if (blitter_name != nullptr && strcasecmp(blitter_name, BlitterFactory::GetCurrentBlitter()->GetName()) != 0) {
+		if (VideoDriver::GetInstance()->HasGUI()) {
+			print("Another blitter can only be used with the null video driver");
+			return false;
+		}
+		if (BlitterFactory::GetBlitterFactory(blitter_name) == nullptr) {
+			seprintf(buf, lastof(buf), "Unknown blitter: %s", blitter_name);
+			print(buf);
+			return false;
+		}
+		old_blitter = BlitterFactory::GetCurrentBlitter()->GetName();
+		BlitterFactory::SelectBlitter(blitter_name);
+		ClearFontCache();
+		GfxClearSpriteCache();
+	}
+
+	const int width = max<int>(_cur_resolution.width, 64);
+	const int height = max<int>(_cur_resolution.height, 64);
+	std::vector<uint32> buffer(width * height);
+
+	/* Like a giant screenshot, render to the buffer instead of to the screen. */
+	DrawPixelInfo old_screen = _screen;
+	bool old_disable_anim = _screen_disable_anim;
+	DrawPixelInfo *old_dpi = _cur_dpi;
+	_screen.dst_ptr = buffer.data();
+	_screen.left = 0;
+	_screen.top = 0;
+	_screen.width = width;
+	_screen.height = height;
+	_screen.pitch = width;
+	_screen.zoom = ZOOM_LVL_NORMAL;
+	_screen_disable_anim = true;
+	DrawPixelInfo dpi = _screen;
+	_cur_dpi = &dpi;
+
+	static const uint position_fractions[][2] = { { 2, 2 }, { 1, 1 }, { 3, 1 }, { 1, 3 }, { 3, 3 } };
+	static const char * const map_type_names[] = { "vegetation", "owner", "industry" };
+	static_assert(lengthof(map_type_names) == VPMT_END, "");
+	static const char * const phase_names[] = { "collect", "sort", "blit", "strings" };
+	static_assert(lengthof(phase_names) == VDP_END, "");
+
+	seprintf(buf, lastof(buf), "Rendering %u viewports of %dx%d %u times with blitter %s, times are p50/p90/p99/max in us",
+			(uint)lengthof(position_fractions), width, height, iterations, BlitterFactory::GetCurrentBlitter()->GetName());
+	print(buf);
+
+	std::atomic<uint64> phase_ns[VDP_END];
+	_vp_draw_phase_ns = phase_ns;
+	for (ZoomLevel zoom = ZOOM_LVL_MIN; zoom <= ZOOM_LVL_MAX; zoom++) {
+		for (uint map_type = VPMT_BEGIN; map_type < (zoom >= ZOOM_LVL_DRAW_MAP ? VPMT_END : VPMT_BEGIN + 1); map_type++) {
+			ViewPort vp;
+			vp.left = 0;
+			vp.top = 0;
+			vp.width = width;
+			vp.height = height;
+			vp.zoom = zoom;
+			vp.virtual_width = ScaleByZoom(width, zoom);
+			vp.virtual_height = ScaleByZoom(height, zoom);
+			vp.map_type = (ViewportMapType)map_type;
+			vp.overlay = nullptr;
+			UpdateViewportSizeZoom(&vp);
+
+			std::vector<uint64> frame_samples;
+			std::vector<uint64> phase_samples[VDP_END];
+			for (uint iter = 0; iter <= iterations; iter++) {
+				for (const auto &fraction : position_fractions) {
+					uint x = MapSizeX() * fraction[0] / 4 * TILE_SIZE;
+					uint y = MapSizeY() * fraction[1] / 4 * TILE_SIZE;
+					Point pt = MapXYZToViewport(&vp, x, y, GetSlopePixelZ(x, y));
+					vp.virtual_left = pt.x;
+					vp.virtual_top = pt.y;
+					UpdateViewportDirtyBlockLeftMargin(&vp);
+					ClearViewPortCache(&vp);
+
+					for (auto &ns : phase_ns) ns.store(0, std::memory_order_relaxed);
+					auto start = std::chrono::steady_clock::now();
+					ViewportDrawChk(&vp, 0, 0, width, height);
+					uint64 frame_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+					if (iter == 0) continue;
+
+					frame_samples.push_back(frame_ns);
+					for (uint phase = 0; phase < VDP_END; phase++) phase_samples[phase].push_back(phase_ns[phase].load(std::memory_order_relaxed));
+				}
+			}
+			if (frame_samples.empty()) continue;
+
+			char *b = buf + seprintf(buf, lastof(buf), "%4ux %-10s", 1u << zoom, zoom >= ZOOM_LVL_DRAW_MAP ? map_type_names[map_type] : "sprites");
+			auto add_samples = [&](const char *name, std::vector<uint64> &samples) {
+				std::sort(samples.begin(), samples.end());
+				b += seprintf(b, lastof(buf), " | %s %.0f/%.0f/%.0f/%.0f", name, RenderBenchmarkPercentile(samples, 50), RenderBenchmarkPercentile(samples, 90),
+						RenderBenchmarkPercentile(samples, 99), samples.back() / 1000.0);
+			};
+			add_samples("frame", frame_samples);
+			for (uint phase = 0; phase < VDP_END; phase++) add_samples(phase_names[phase], phase_samples[phase]);
+			print(buf);
+		}
+	}
+	_vp_draw_phase_ns = nullptr;
+
+	_cur_dpi = old_dpi;
+	_screen = old_screen;
+	_screen_disable_anim = old_disable_anim;
+
+	if (!old_blitter.empty()) {
+		BlitterFactory::SelectBlitter(old_blitter);
+		ClearFontCache();
+		GfxClearSpriteCache();
+	}
+	return true;
+}
+
 /**
  * Scroll players main viewport.
  * @param tile tile to center viewport on
@@ -76,6 +76,8 @@ void SetTileSelectSize(int w, int h);
 void SetTileSelectBigSize(int ox, int oy, int sx, int sy);
 
 void ViewportDoDraw(ViewPort *vp, int left, int top, int right, int bottom);
+void BeginViewportParallelDraw();
+void EndViewportParallelDraw();
 
 bool ScrollWindowToTile(TileIndex tile, Window *w, bool instant = false);
 bool ScrollWindowTo(int x, int y, int z, Window *w, bool instant = false);
@@ -109,6 +111,10 @@ static inline void MarkTileDirtyByTile(TileIndex tile, const ZoomLevel mark_dirt
 
 void MarkTileGroundDirtyByTile(TileIndex tile, const ZoomLevel mark_dirty_if_zoomlevel_is_below);
 
+void InvalidateLandscapeSpriteCacheTile(TileIndex tile);
+void ClearLandscapeSpriteCache();
+void ClearViewportMapColourCache();
+
 ViewportMapType ChangeRenderMode(const ViewPort *vp, bool down);
 
 Point GetViewportStationMiddle(const ViewPort *vp, const Station *st);
@@ -61,6 +61,9 @@ struct ViewPort {
 	bool is_drawn = false;
 	ViewPortMapDrawVehiclesCache map_draw_vehicles_cache;
 
+	int prefetch_left = 0; ///< Virtual left coordinate at the last sprite prefetch, see ViewportPrefetchSprites().
+	int prefetch_top = 0;  ///< Virtual top coordinate at the last sprite prefetch, see ViewportPrefetchSprites().
+
 	uint GetDirtyBlockWidthShift() const { return this->GetDirtyBlockShift(); }
 	uint GetDirtyBlockHeightShift() const { return this->GetDirtyBlockShift(); }
 	uint GetDirtyBlockWidth() const { return 1 << this->GetDirtyBlockWidthShift(); }
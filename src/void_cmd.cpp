@@ -86,4 +86,5 @@ extern const TileTypeProcs _tile_type_void_procs = {
 	nullptr,                     // vehicle_enter_tile_proc
 	GetFoundation_Void,       // get_foundation_proc
 	TerraformTile_Void,       // terraform_tile_proc
+	nullptr,                  // tile_loop_precheck_proc
 };
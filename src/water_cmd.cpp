@@ -1132,6 +1132,8 @@ void DoFloodTile(TileIndex target)
 {
 	assert_tile(!IsTileType(target, MP_WATER), target);
 
+	InvalidateTileLoopPrecheck(target);
+
 	bool flooded = false; // Will be set to true if something is changed.
 
 	Backup<CompanyID> cur_company(_current_company, OWNER_WATER, FILE_LINE);
@@ -1197,6 +1199,8 @@ void DoFloodTile(TileIndex target)
  */
 static void DoDryUp(TileIndex tile)
 {
+	InvalidateTileLoopPrecheck(tile);
+
 	Backup<CompanyID> cur_company(_current_company, OWNER_WATER, FILE_LINE);
 
 	switch (GetTileType(tile)) {
@@ -1285,6 +1289,44 @@ void TileLoop_Water(TileIndex tile)
 	}
 }
 
+/**
+ * Tile loop of a water tile for which TileLoopPrecheck_Water determined that it neither floods nor dries up anything.
+ * @param tile the water tile
+ */
+static void TileLoop_WaterNoFlooding(TileIndex tile)
+{
+	AmbientSoundEffect(tile);
+}
+
+/**
+ * Tile loop precheck of water tiles.
+ * Open water tiles which are surrounded by water cannot flood anything, which is the case for most of the sea.
+ * @param tile the water tile
+ * @return TileLoop_WaterNoFlooding if TileLoop_Water would not flood or dry up anything, nullptr otherwise.
+ */
+static TileLoopProc *TileLoopPrecheck_Water(TileIndex tile)
+{
+	switch (GetFloodingBehaviour(tile)) {
+		case FLOOD_ACTIVE:
+			for (Direction dir = DIR_BEGIN; dir < DIR_END; dir++) {
+				TileIndex dest = tile + TileOffsByDir(dir);
+				if (!IsValidTile(dest)) continue;
+				if (IsTileType(dest, MP_WATER)) continue;
+				if (IsTileType(dest, MP_TREES) && GetTreeGround(dest) == TREE_GROUND_SHORE) continue;
+
+				/* Whether the tile can be flooded depends on its foundation, which may involve NewGRF callbacks. */
+				return nullptr;
+			}
+			return &TileLoop_WaterNoFlooding;
+
+		case FLOOD_NONE:
+			return &TileLoop_WaterNoFlooding;
+
+		default:
+			return nullptr;
+	}
+}
+
 void ConvertGroundTilesIntoWaterTiles()
 {
 	int z;
@@ -1424,4 +1466,5 @@ extern const TileTypeProcs _tile_type_water_procs = {
 	VehicleEnter_Water,       // vehicle_enter_tile_proc
 	GetFoundation_Water,      // get_foundation_proc
 	TerraformTile_Water,      // terraform_tile_proc
+	TileLoopPrecheck_Water,   // tile_loop_precheck_proc
 };
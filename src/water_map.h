@@ -12,6 +12,7 @@
 
 #include "depot_type.h"
 #include "tile_map.h"
+#include "pathfinder/water_regions.h"
 
 /**
  * Bit field layout of m5 for water tiles.
@@ -384,6 +385,7 @@ static inline void MakeShore(TileIndex t)
 	_m[t].m5 = WBL_TYPE_NORMAL << WBL_TYPE_BEGIN | 1 << WBL_COAST_FLAG;
 	SB(_me[t].m6, 2, 4, 0);
 	_me[t].m7 = 0;
+	InvalidateWaterRegion(t);
 }
 
 /**
@@ -405,6 +407,7 @@ static inline void MakeWater(TileIndex t, Owner o, WaterClass wc, uint8 random_b
 	_m[t].m5 = WBL_TYPE_NORMAL << WBL_TYPE_BEGIN;
 	SB(_me[t].m6, 2, 4, 0);
 	_me[t].m7 = 0;
+	InvalidateWaterRegion(t);
 }
 
 /**
@@ -459,6 +462,7 @@ static inline void MakeShipDepot(TileIndex t, Owner o, DepotID did, DepotPart pa
 	_m[t].m5 = WBL_TYPE_DEPOT << WBL_TYPE_BEGIN | part << WBL_DEPOT_PART | a << WBL_DEPOT_AXIS;
 	SB(_me[t].m6, 2, 4, 0);
 	_me[t].m7 = 0;
+	InvalidateWaterRegion(t);
 }
 
 /**
@@ -482,6 +486,7 @@ static inline void MakeLockTile(TileIndex t, Owner o, LockPart part, DiagDirecti
 	_m[t].m5 = WBL_TYPE_LOCK << WBL_TYPE_BEGIN | part << WBL_LOCK_PART_BEGIN | dir << WBL_LOCK_ORIENT_BEGIN;
 	SB(_me[t].m6, 2, 4, 0);
 	_me[t].m7 = 0;
+	InvalidateWaterRegion(t);
 }
 
 /**
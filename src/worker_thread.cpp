@@ -0,0 +1,345 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_thread.cpp Work-stealing worker thread pool. */
+
+#include "stdafx.h"
+#include "worker_thread.h"
+#include "settings_type.h"
+#include "debug.h"
+
+#include "safeguards.h"
+
+WorkerThreadPool _general_worker_pool;
+
+/** Whether the configured number of worker threads changed, but the general worker pool could not be restarted yet. */
+static bool _general_worker_pool_restart_pending = false;
+
+/** The pool and the index of the worker thread, if this thread is a worker thread. */
+static thread_local WorkerThreadPool *_current_pool = nullptr;
+static thread_local uint _current_worker = 0;
+
+/**
+ * Get the name of a class of worker tasks, for debug output.
+ * @param task_class The task class.
+ * @return The name.
+ */
+const char *GetWorkerTaskClassName(WorkerTaskClass task_class)
+{
+	static const char * const names[] = { "general", "linkgraph", "saveload", "grf-md5", "sprite-prefetch" };
+	static_assert(lengthof(names) == WTC_END, "Worker task class name list length mismatch");
+	return task_class < WTC_END ? names[task_class] : "invalid";
+}
+
+/**
+ * Run the task, unless it has already been started by another thread.
+ * @return True if the task was run by this call.
+ */
+bool WorkerTask::TryRun()
+{
+	uint8 expected = WTS_QUEUED;
+	if (!this->state.compare_exchange_strong(expected, WTS_RUNNING, std::memory_order_acq_rel)) return false;
+
+	this->func(this->data1, this->data2, this->data3);
+	if (this->long_tasks != nullptr) (*this->long_tasks)--;
+
+	{
+		std::unique_lock<std::mutex> lk(this->lock);
+		this->state.store(WTS_DONE, std::memory_order_release);
+	}
+	this->done_cv.notify_all();
+	return true;
+}
+
+/**
+ * Wait until the task has finished running.
+ * If no worker thread has started the task yet, it is run on the calling thread instead.
+ */
+void WorkerTask::Wait()
+{
+	if (this->TryRun()) return;
+
+	std::unique_lock<std::mutex> lk(this->lock);
+	while (!this->IsDone()) this->done_cv.wait(lk);
+}
+
+/**
+ * Start the worker threads of the pool.
+ * @param thread_name Name of the worker threads.
+ * @param worker_threads Number of worker threads to start.
+ */
+void WorkerThreadPool::Start(const char *thread_name, uint worker_threads)
+{
+#ifndef NO_THREADS
+	assert(this->threads.empty());
+	std::unique_lock<std::mutex> lk(this->lock);
+	this->exit = false;
+
+	this->queues.clear();
+	for (uint i = 0; i <= worker_threads; i++) {
+		this->queues.emplace_back(new WorkerQueue());
+	}
+
+	/* Link graph job groups can run for a long time, leave a worker thread for other tasks.
+	 * With less than two worker threads they get threads of their own, see UsesDedicatedThread. */
+	this->throttle_limit[WTC_LINKGRAPH] = worker_threads > 1 ? worker_threads - 1 : 1;
+
+	/* Sprite prefetching is only an optimisation, it should not hold up the parallel drawing and game loop tasks. */
+	this->throttle_limit[WTC_SPRITE_PREFETCH] = max<uint>(1, worker_threads / 2);
+
+	for (uint i = 0; i < worker_threads; i++) {
+		this->threads.emplace_back();
+		if (!StartNewThread(&this->threads.back(), thread_name, &WorkerThreadPool::Run, this, (uint)i)) {
+			this->threads.pop_back();
+			break;
+		}
+	}
+	this->thread_count = (uint)this->threads.size();
+#endif
+}
+
+/**
+ * Stop the worker threads of the pool.
+ * All tasks which have already been queued are run to completion first.
+ * Tasks queued meanwhile are run by the threads which queue them.
+ */
+void WorkerThreadPool::Stop()
+{
+	if (this->threads.empty()) return;
+
+	{
+		std::unique_lock<std::mutex> lk(this->lock);
+		this->exit = true;
+		this->thread_count = 0;
+		this->work_cv.notify_all();
+	}
+
+	for (std::thread &thread : this->threads) {
+		thread.join();
+	}
+	this->threads.clear();
+
+	std::unique_lock<std::mutex> lk(this->lock);
+	this->queues.clear();
+}
+
+/**
+ * Change the number of worker threads of a running pool.
+ * Waiting for long-running tasks would block the calling thread for a long time, so the pool is only
+ * restarted when it has none, and while it is restarted no new tasks are given to the old worker threads.
+ * @param thread_name Name of the worker threads.
+ * @param worker_threads Number of worker threads to start.
+ * @return False if the pool was left unchanged, because it has unfinished long-running tasks.
+ */
+bool WorkerThreadPool::Restart(const char *thread_name, uint worker_threads)
+{
+	{
+		std::unique_lock<std::mutex> lk(this->lock);
+		if (this->long_tasks.load() != 0) return false;
+		this->exit = true;
+		this->thread_count = 0;
+		this->work_cv.notify_all();
+	}
+
+	this->Stop();
+	this->Start(thread_name, worker_threads);
+	return true;
+}
+
+/**
+ * Queue a task to be run on one of the worker threads.
+ * If the pool has no worker threads, the task is run immediately on the calling thread.
+ * @param task_class Class of the task.
+ * @param func Task function.
+ * @param data1 First parameter of the task function.
+ * @param data2 Second parameter of the task function.
+ * @param data3 Third parameter of the task function.
+ * @return The task, which can be waited for.
+ */
+std::shared_ptr<WorkerTask> WorkerThreadPool::EnqueueTask(WorkerTaskClass task_class, WorkerJobFunc *func, void *data1, void *data2, void *data3)
+{
+	std::shared_ptr<WorkerTask> task = std::make_shared<WorkerTask>(task_class, func, data1, data2, data3);
+	if (task_class == WTC_LINKGRAPH || task_class == WTC_SAVELOAD || task_class == WTC_GRF_MD5) {
+		task->long_tasks = &this->long_tasks;
+		this->long_tasks++;
+	}
+
+	if (this->UsesDedicatedThread(task_class)) {
+		static const char * const thread_names[] = { "ottd:worker", "ottd:linkgraph", "ottd:savegame", "ottd:grf-md5", "ottd:prefetch" };
+		static_assert(lengthof(thread_names) == WTC_END, "Worker task class thread name list length mismatch");
+		if (StartNewThread(nullptr, thread_names[task_class], [](std::shared_ptr<WorkerTask> task) { task->TryRun(); }, std::shared_ptr<WorkerTask>(task))) return task;
+	}
+
+	std::unique_lock<std::mutex> lk(this->lock);
+	if (this->thread_count == 0) {
+		lk.unlock();
+		task->TryRun();
+		return task;
+	}
+
+	if (this->throttle_limit[task_class] != 0) {
+		this->throttled_tasks[task_class].push_back(task);
+	} else {
+		/* Worker threads add to their own queue, any other thread to the shared queue. */
+		WorkerQueue &queue = *this->queues[_current_pool == this ? _current_worker : this->queues.size() - 1];
+		std::unique_lock<std::mutex> queue_lk(queue.lock);
+		queue.tasks.push_back(task);
+		this->queued_tasks++;
+	}
+	this->work_cv.notify_one();
+	return task;
+}
+
+/**
+ * Check whether the tasks of a class are run on a thread of their own, instead of on the worker threads.
+ * @param task_class Class of the tasks.
+ * @return True if each task gets a dedicated thread.
+ */
+bool WorkerThreadPool::UsesDedicatedThread(WorkerTaskClass task_class) const
+{
+	switch (task_class) {
+		/* Saving can block on file or network I/O for a long time, e.g. while clients download the map. */
+		case WTC_SAVELOAD: return true;
+
+		/* Link graph job groups must not occupy the only worker thread, or run on the thread which queued them. */
+		case WTC_LINKGRAPH: return this->thread_count < 2;
+
+		default: return false;
+	}
+}
+
+/**
+ * Check whether a throttled task can be started.
+ * The pool lock must be held.
+ * @return True if there is a throttled task which is not held back by the limit of its class.
+ */
+bool WorkerThreadPool::HasRunnableThrottledTask() const
+{
+	for (uint i = 0; i < WTC_END; i++) {
+		if (!this->throttled_tasks[i].empty() && this->running_throttled[i] < this->throttle_limit[i]) return true;
+	}
+	return false;
+}
+
+/**
+ * Take the next task to run for a worker thread.
+ * @param worker Index of the worker thread.
+ * @param[out] throttled Set to the class of the task if it is a throttled task.
+ * @return The task, or nullptr if no task is available.
+ */
+std::shared_ptr<WorkerTask> WorkerThreadPool::TakeTask(uint worker, WorkerTaskClass *throttled)
+{
+	std::shared_ptr<WorkerTask> task;
+
+	if (this->queued_tasks.load() > 0) {
+		/* The most recently queued task of the own queue is the most likely to have its data in the cache. */
+		WorkerQueue &own = *this->queues[worker];
+		{
+			std::unique_lock<std::mutex> lk(own.lock);
+			if (!own.tasks.empty()) {
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				this->queued_tasks--;
+				return task;
+			}
+		}
+
+		/* Then take the oldest task of the shared queue, or steal the oldest task of another worker. */
+		const uint worker_queues = (uint)this->queues.size() - 1;
+		for (uint i = 0; i < worker_queues; i++) {
+			WorkerQueue &queue = *this->queues[i == 0 ? worker_queues : (worker + i) % worker_queues];
+			std::unique_lock<std::mutex> lk(queue.lock);
+			if (!queue.tasks.empty()) {
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+				this->queued_tasks--;
+				return task;
+			}
+		}
+	}
+
+	std::unique_lock<std::mutex> lk(this->lock);
+	for (uint i = 0; i < WTC_END; i++) {
+		if (!this->throttled_tasks[i].empty() && this->running_throttled[i] < this->throttle_limit[i]) {
+			task = std::move(this->throttled_tasks[i].front());
+			this->throttled_tasks[i].pop_front();
+			this->running_throttled[i]++;
+			*throttled = (WorkerTaskClass)i;
+			return task;
+		}
+	}
+	return task;
+}
+
+void WorkerThreadPool::Run(WorkerThreadPool *pool, uint worker)
+{
+	_current_pool = pool;
+	_current_worker = worker;
+
+	while (true) {
+		WorkerTaskClass throttled = WTC_END;
+		std::shared_ptr<WorkerTask> task = pool->TakeTask(worker, &throttled);
+		if (task != nullptr) {
+			if (task->task_class != WTC_GENERAL) DEBUG(misc, 6, "Worker %u: running %s task", worker, GetWorkerTaskClassName(task->task_class));
+			task->TryRun();
+			if (throttled != WTC_END) {
+				std::unique_lock<std::mutex> lk(pool->lock);
+				pool->running_throttled[throttled]--;
+				if (!pool->throttled_tasks[throttled].empty()) pool->work_cv.notify_one();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lk(pool->lock);
+		while (pool->queued_tasks.load() == 0 && !pool->HasRunnableThrottledTask()) {
+			if (pool->exit) return;
+			pool->work_cv.wait(lk);
+		}
+	}
+}
+
+/**
+ * Get the number of worker threads to use for the general worker pool, as configured by the threading.worker_threads setting.
+ * @return Number of worker threads, not including the main thread.
+ */
+uint GetConfiguredWorkerThreadCount()
+{
+	uint threads = _settings_client.threading.worker_threads;
+	if (threads == 0) {
+		/* Automatic: one thread per hardware thread */
+		threads = Clamp<uint>(std::thread::hardware_concurrency(), 1, 16);
+	}
+	/* The main thread counts as one of the threads, so 1 means no worker threads. */
+	return threads - 1;
+}
+
+/**
+ * Start the general worker pool with the configured number of worker threads.
+ */
+void StartGeneralWorkerPool()
+{
+	_general_worker_pool.Start("ottd:worker", GetConfiguredWorkerThreadCount());
+}
+
+/**
+ * Restart the general worker pool after the configured number of worker threads changed.
+ * When link graph jobs, saving or NewGRF checksums are running, the restart is retried by ApplyPendingGeneralWorkerPoolRestart.
+ * @return False if the pool could not be restarted yet.
+ */
+bool RestartGeneralWorkerPool()
+{
+	_general_worker_pool_restart_pending = !_general_worker_pool.Restart("ottd:worker", GetConfiguredWorkerThreadCount());
+	return !_general_worker_pool_restart_pending;
+}
+
+/**
+ * Restart the general worker pool if a change of the number of worker threads is still pending.
+ */
+void ApplyPendingGeneralWorkerPoolRestart()
+{
+	if (_general_worker_pool_restart_pending) RestartGeneralWorkerPool();
+}
@@ -0,0 +1,231 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_thread.h Work-stealing worker thread pool for running independent tasks in parallel. */
+
+#ifndef WORKER_THREAD_H
+#define WORKER_THREAD_H
+
+#include "thread.h"
+#include "core/math_func.hpp"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#if defined(__MINGW32__)
+#include "3rdparty/mingw-std-threads/mingw.mutex.h"
+#include "3rdparty/mingw-std-threads/mingw.condition_variable.h"
+#endif
+
+typedef void WorkerJobFunc(void *, void *, void *);
+
+/** Classes of tasks which can be run on a worker pool. */
+enum WorkerTaskClass : uint8 {
+	WTC_GENERAL,    ///< Short jobs, such as the batches of a parallel loop.
+	WTC_LINKGRAPH,  ///< Link graph job groups.
+	WTC_SAVELOAD,   ///< Savegame compression and writing, and loading savegame chunks in parallel.
+	WTC_GRF_MD5,    ///< NewGRF MD5 checksum calculation.
+	WTC_SPRITE_PREFETCH, ///< Background loading of sprites which are about to be drawn.
+	WTC_END,
+};
+
+const char *GetWorkerTaskClassName(WorkerTaskClass task_class);
+
+/**
+ * A task which has been queued on a worker pool.
+ * A task is run exactly once, either by a worker thread or by a thread which waits for it before any worker thread picked it up.
+ */
+class WorkerTask {
+	friend class WorkerThreadPool;
+
+	enum State : uint8 {
+		WTS_QUEUED,
+		WTS_RUNNING,
+		WTS_DONE,
+	};
+
+	WorkerJobFunc *func;
+	void *data1;
+	void *data2;
+	void *data3;
+	const WorkerTaskClass task_class;
+	std::atomic<uint8> state;
+	std::atomic<uint> *long_tasks = nullptr; ///< Counter of unfinished long-running tasks of the pool, if this is one.
+	std::mutex lock;
+	std::condition_variable done_cv;
+
+	bool TryRun();
+
+public:
+	WorkerTask(WorkerTaskClass task_class, WorkerJobFunc *func, void *data1, void *data2, void *data3)
+			: func(func), data1(data1), data2(data2), data3(data3), task_class(task_class), state(WTS_QUEUED) {}
+
+	/**
+	 * Check whether the task has finished running.
+	 * @return True if the task is done.
+	 */
+	inline bool IsDone() const { return this->state.load(std::memory_order_acquire) == WTS_DONE; }
+
+	void Wait();
+};
+
+/**
+ * Pool of worker threads, which run queued tasks.
+ * Each worker thread has its own queue, tasks queued by a worker thread are added to its own queue,
+ * tasks queued by any other thread are added to a shared queue. Idle workers take tasks from their own queue first,
+ * then from the shared queue, and then steal from the queues of the other workers.
+ * Tasks of long-running classes are throttled, such that they can not occupy all worker threads at once.
+ * Tasks which may block, and long-running tasks when there are too few worker threads, get a thread of their own.
+ * The number of worker threads can be changed while other threads queue tasks, but not while long-running tasks are unfinished.
+ */
+class WorkerThreadPool {
+private:
+	typedef std::deque<std::shared_ptr<WorkerTask>> TaskQueue;
+
+	struct WorkerQueue {
+		std::mutex lock;
+		TaskQueue tasks;
+	};
+
+	std::vector<std::thread> threads;
+	std::vector<std::unique_ptr<WorkerQueue>> queues; ///< Queue of each worker thread, followed by the shared queue, only changed while no worker threads run.
+	std::atomic<uint> queued_tasks;                   ///< Number of tasks in #queues.
+	std::atomic<uint> thread_count;                   ///< Number of worker threads which take new tasks, only changed with #lock held.
+	std::atomic<uint> long_tasks;                     ///< Number of unfinished tasks of the long-running classes.
+	std::mutex lock;                                  ///< Lock for the members below.
+	std::condition_variable work_cv;
+	TaskQueue throttled_tasks[WTC_END];               ///< Queued tasks of the throttled classes.
+	uint running_throttled[WTC_END] = {};             ///< Number of running tasks of the throttled classes.
+	uint throttle_limit[WTC_END] = {};                ///< Maximum number of concurrently running tasks of each class, 0 for unthrottled.
+	bool exit = false;
+
+	static void Run(WorkerThreadPool *pool, uint worker);
+	std::shared_ptr<WorkerTask> TakeTask(uint worker, WorkerTaskClass *throttled);
+	bool HasRunnableThrottledTask() const;
+	bool UsesDedicatedThread(WorkerTaskClass task_class) const;
+
+public:
+	WorkerThreadPool() : queued_tasks(0), thread_count(0), long_tasks(0) {}
+
+	void Start(const char *thread_name, uint worker_threads);
+	void Stop();
+	bool Restart(const char *thread_name, uint worker_threads);
+	std::shared_ptr<WorkerTask> EnqueueTask(WorkerTaskClass task_class, WorkerJobFunc *func, void *data1 = nullptr, void *data2 = nullptr, void *data3 = nullptr);
+
+	/**
+	 * Queue a general job, which is not waited for.
+	 * If the pool has no worker threads, the job is run immediately on the calling thread.
+	 * @param func Job function.
+	 * @param data1 First parameter of the job function.
+	 * @param data2 Second parameter of the job function.
+	 * @param data3 Third parameter of the job function.
+	 */
+	inline void EnqueueJob(WorkerJobFunc *func, void *data1 = nullptr, void *data2 = nullptr, void *data3 = nullptr)
+	{
+		this->EnqueueTask(WTC_GENERAL, func, data1, data2, data3);
+	}
+
+	/**
+	 * Get the number of worker threads in this pool, not including the thread which enqueues jobs.
+	 * @return Number of worker threads.
+	 */
+	inline uint GetThreadCount() const { return this->thread_count.load(); }
+
+	~WorkerThreadPool()
+	{
+		this->Stop();
+	}
+};
+
+extern WorkerThreadPool _general_worker_pool;
+
+uint GetConfiguredWorkerThreadCount();
+void StartGeneralWorkerPool();
+bool RestartGeneralWorkerPool();
+void ApplyPendingGeneralWorkerPoolRestart();
+
+/**
+ * Call func(begin, end) over the index range [0, count), split into batches of at most batch_size
+ * indices, which may be run concurrently on the worker threads of the given pool.
+ * The calling thread participates in processing the batches, and this function does not return until
+ * all batches have completed.
+ * The order in which batches are processed is unspecified, func must therefore only perform work
+ * which is independent of the other batches.
+ * @param pool Worker pool to use.
+ * @param count Number of indices to process.
+ * @param batch_size Maximum number of indices in a batch, this should be large enough to amortise the cost of dispatching a batch.
+ * @param func Function to call for each batch.
+ */
+template <typename F>
+void RunParallelFor(WorkerThreadPool &pool, size_t count, size_t batch_size, F func)
+{
+	const size_t batches = CeilDivT<size_t>(count, batch_size);
+	if (batches <= 1 || pool.GetThreadCount() == 0) {
+		if (count > 0) func(0, count);
+		return;
+	}
+
+	/* The state is shared with the helper jobs, a helper job which only gets to run after
+	 * all batches have been claimed must still be able to access it safely. */
+	struct State {
+		F *func;
+		size_t count;
+		size_t batch_size;
+		size_t batches;
+		std::atomic<size_t> next_batch;
+		std::mutex lock;
+		std::condition_variable done_cv;
+		uint active_helpers = 0;
+
+		void RunBatches()
+		{
+			for (size_t batch = this->next_batch++; batch < this->batches; batch = this->next_batch++) {
+				size_t begin = batch * this->batch_size;
+				(*this->func)(begin, std::min(begin + this->batch_size, this->count));
+			}
+		}
+
+		static void Helper(void *data, void *, void *)
+		{
+			std::shared_ptr<State> *state_ptr = static_cast<std::shared_ptr<State> *>(data);
+			State *state = state_ptr->get();
+			{
+				std::unique_lock<std::mutex> lk(state->lock);
+				state->active_helpers++;
+			}
+			state->RunBatches();
+			{
+				std::unique_lock<std::mutex> lk(state->lock);
+				state->active_helpers--;
+				if (state->active_helpers == 0) state->done_cv.notify_all();
+			}
+			delete state_ptr;
+		}
+	};
+
+	std::shared_ptr<State> state = std::make_shared<State>();
+	state->func = &func;
+	state->count = count;
+	state->batch_size = batch_size;
+	state->batches = batches;
+	state->next_batch = 0;
+
+	const uint helpers = (uint)std::min<size_t>(pool.GetThreadCount(), batches - 1);
+	for (uint i = 0; i < helpers; i++) {
+		pool.EnqueueJob(&State::Helper, new std::shared_ptr<State>(state));
+	}
+
+	state->RunBatches();
+
+	/* All batches have been claimed, wait for any helpers which are still running one. */
+	std::unique_lock<std::mutex> lk(state->lock);
+	while (state->active_helpers != 0) state->done_cv.wait(lk);
+}
+
+#endif /* WORKER_THREAD_H */